@@ -1,7 +1,9 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_HOUR, CONF_MINUTE, CONF_SECOND, CONF_TIME_ID
 from esphome import automation
+from esphome.components import time
+from esphome.helpers import fnv1_hash
 from esphome.automation import maybe_simple_id
 
 DEPENDENCIES = ["network"]
@@ -10,19 +12,150 @@ AUTO_LOAD = ["json", "watchdog"]
 notion_database_ns = cg.esphome_ns.namespace("notion_database")
 NotionDatabase = notion_database_ns.class_("NotionDatabase", cg.PollingComponent)
 NotionDatabasePage = notion_database_ns.class_("Page")
+ChangeSet = notion_database_ns.struct("ChangeSet")
 FirstPageAction = notion_database_ns.class_("FirstPageAction", automation.Action)
 NextPageAction = notion_database_ns.class_("NextPageAction", automation.Action)
 PreviousPageAction = notion_database_ns.class_("PreviousPageAction", automation.Action)
+MemoryPlacement = notion_database_ns.enum("MemoryPlacement", is_class=True)
+FilterOperator = notion_database_ns.enum("FilterOperator", is_class=True)
+
+MEMORY_PLACEMENTS = {
+    "PSRAM": MemoryPlacement.PSRAM,
+    "INTERNAL": MemoryPlacement.INTERNAL,
+}
+
+FILTER_OPERATORS = {
+    "equals": FilterOperator.EQUALS,
+    "does_not_equal": FilterOperator.NOT_EQUALS,
+    "contains": FilterOperator.CONTAINS,
+    "does_not_contain": FilterOperator.DOES_NOT_CONTAIN,
+    "is_empty": FilterOperator.IS_EMPTY,
+    "is_not_empty": FilterOperator.IS_NOT_EMPTY,
+    "greater_than": FilterOperator.GREATER_THAN,
+    "less_than": FilterOperator.LESS_THAN,
+}
 
 CONF_API_TOKEN = "api_token"
 CONF_DATABASE_ID = "database_id"
+CONF_BASE_URL = "base_url"
 CONF_QUERY = "query"
 CONF_PROPERTY_FILTERS = "property_filters"
 CONF_ON_PAGE_CHANGE = "on_page_change"
 CONF_WATCHDOG_TIMEOUT = "watchdog_timeout"
 CONF_HTTP_CONNECT_TIMEOUT = "http_connect_timeout"
 CONF_HTTP_TIMEOUT = "http_timeout"
+CONF_KEEP_ALIVE = "keep_alive"
+CONF_KEEP_ALIVE_TIMEOUT = "keep_alive_timeout"
 CONF_JSON_PARSE_BUFFER_SIZE = "json_parse_buffer_size"
+CONF_JSON_PARSE_BUFFER_PLACEMENT = "json_parse_buffer_placement"
+CONF_PAGE_STORE_PLACEMENT = "page_store_placement"
+CONF_CACHE_PLACEMENT = "cache_placement"
+CONF_INCREMENTAL_SYNC = "incremental_sync"
+CONF_FULL_SYNC_INTERVAL = "full_sync_interval"
+CONF_PAGE_CACHE_ENTRIES = "page_cache_entries"
+CONF_PAGE_CACHE_BYTES = "page_cache_bytes"
+CONF_ASYNC_FETCH = "async_fetch"
+CONF_FETCH_TASK_STACK_SIZE = "fetch_task_stack_size"
+CONF_FETCH_TASK_CORE = "fetch_task_core"
+CONF_ADAPTIVE_POLLING = "adaptive_polling"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_MAX_INTERVAL = "max_interval"
+CONF_BACKOFF_FACTOR = "backoff_factor"
+CONF_QUIET_HOURS = "quiet_hours"
+CONF_START = "start"
+CONF_END = "end"
+CONF_SNAPSHOT = "snapshot"
+CONF_MAX_SIZE = "max_size"
+CONF_WRITE_DELAY = "write_delay"
+CONF_MAX_AGE = "max_age"
+CONF_SOURCE_ID = "source_id"
+CONF_LOCAL_FILTER = "local_filter"
+CONF_LOCAL_SORTS = "local_sorts"
+CONF_PROPERTY = "property"
+CONF_OPERATOR = "operator"
+CONF_VALUE = "value"
+CONF_DIRECTION = "direction"
+
+LOCAL_FILTER_SCHEMA = cv.Schema({
+    cv.Required(CONF_PROPERTY): cv.string,
+    cv.Required(CONF_OPERATOR): cv.enum(FILTER_OPERATORS, lower=True),
+    cv.Optional(CONF_VALUE, default=""): cv.string,
+})
+
+LOCAL_SORT_SCHEMA = cv.Schema({
+    cv.Required(CONF_PROPERTY): cv.string,
+    cv.Optional(CONF_DIRECTION, default="ascending"): cv.one_of("ascending", "descending", lower=True),
+})
+
+QUIET_HOURS_SCHEMA = cv.Schema({
+    cv.GenerateID(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+    cv.Required(CONF_START): cv.time_of_day,
+    cv.Required(CONF_END): cv.time_of_day,
+})
+
+def validate_adaptive_polling(config):
+    if config[CONF_MAX_INTERVAL] < config[CONF_MIN_INTERVAL]:
+        raise cv.Invalid(f"{CONF_MAX_INTERVAL} must not be less than {CONF_MIN_INTERVAL}")
+    return config
+
+ADAPTIVE_POLLING_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Optional(CONF_MIN_INTERVAL, default="1min"): cv.All(
+            cv.positive_not_null_time_period,
+            cv.positive_time_period_milliseconds,
+        ),
+        cv.Optional(CONF_MAX_INTERVAL, default="30min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_BACKOFF_FACTOR, default=2.0): cv.float_range(min=1.0, max=10.0),
+        cv.Optional(CONF_QUIET_HOURS): QUIET_HOURS_SCHEMA,
+    }),
+    validate_adaptive_polling,
+)
+
+SNAPSHOT_SCHEMA = cv.Schema({
+    cv.Optional(CONF_MAX_SIZE, default="4kB"): cv.All(cv.validate_bytes, cv.int_range(min=256, max=65536)),
+    cv.Optional(CONF_WRITE_DELAY, default="60s"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_MAX_AGE, default="0s"): cv.positive_time_period_seconds,
+    cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+})
+
+def seconds_of_day(value):
+    return value[CONF_HOUR] * 3600 + value[CONF_MINUTE] * 60 + value[CONF_SECOND]
+
+def validate_sources(configs):
+    sources = {config[CONF_ID].id: config for config in configs}
+    for config in configs:
+        if CONF_SOURCE_ID not in config:
+            if config.get(CONF_LOCAL_FILTER) or config.get(CONF_LOCAL_SORTS):
+                raise cv.Invalid(f"{CONF_LOCAL_FILTER} and {CONF_LOCAL_SORTS} require {CONF_SOURCE_ID}")
+            continue
+        for key in (CONF_ADAPTIVE_POLLING, CONF_SNAPSHOT):
+            if key in config:
+                raise cv.Invalid(f"{config[CONF_ID].id} is updated by its source and cannot use {key}")
+        source = sources.get(config[CONF_SOURCE_ID].id)
+        if source is None:
+            raise cv.Invalid(f"{CONF_SOURCE_ID} must refer to another notion_database")
+        if source is config or CONF_SOURCE_ID in source:
+            raise cv.Invalid(f"The source of {config[CONF_ID].id} must query the Notion API itself")
+    return configs
+
+def merge_source_property_filters(configs):
+    # The source must keep every property its derived databases display, filter or sort on
+    sources = {config[CONF_ID].id: config for config in configs}
+    for config in configs:
+        if CONF_SOURCE_ID not in config:
+            continue
+        source = sources[config[CONF_SOURCE_ID].id]
+        if not source[CONF_PROPERTY_FILTERS]:
+            continue
+        if not config[CONF_PROPERTY_FILTERS]:
+            source[CONF_PROPERTY_FILTERS] = []
+            continue
+        wanted = (config[CONF_PROPERTY_FILTERS]
+                  + [condition[CONF_PROPERTY] for condition in config[CONF_LOCAL_FILTER]]
+                  + [sort[CONF_PROPERTY] for sort in config[CONF_LOCAL_SORTS]])
+        for property_name in wanted:
+            if property_name not in source[CONF_PROPERTY_FILTERS]:
+                source[CONF_PROPERTY_FILTERS].append(property_name)
 
 CONFIG_SCHEMA = cv.All(
     cv.ensure_list(
@@ -30,6 +163,7 @@ CONFIG_SCHEMA = cv.All(
             cv.GenerateID(): cv.declare_id(NotionDatabase),
             cv.Optional(CONF_API_TOKEN, default=""): cv.templatable(cv.string),
             cv.Optional(CONF_DATABASE_ID, default=""): cv.templatable(cv.string),
+            cv.Optional(CONF_BASE_URL, default="https://api.notion.com"): cv.All(cv.url, lambda value: value.rstrip("/")),
             cv.Optional(CONF_QUERY, default=""): cv.templatable(cv.string),
             cv.Optional(CONF_PROPERTY_FILTERS, default=[]): cv.ensure_list(cv.string),
             cv.Optional(CONF_ON_PAGE_CHANGE): automation.validate_automation(),
@@ -45,15 +179,34 @@ CONFIG_SCHEMA = cv.All(
                 cv.positive_not_null_time_period,
                 cv.positive_time_period_milliseconds,
             )),
+            cv.Optional(CONF_KEEP_ALIVE, default=False): cv.boolean,
+            cv.Optional(CONF_KEEP_ALIVE_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
             cv.Optional(CONF_JSON_PARSE_BUFFER_SIZE, default="20kB"): cv.templatable(cv.validate_bytes),
+            cv.Optional(CONF_JSON_PARSE_BUFFER_PLACEMENT, default="PSRAM"): cv.enum(MEMORY_PLACEMENTS, upper=True),
+            cv.Optional(CONF_PAGE_STORE_PLACEMENT, default="PSRAM"): cv.enum(MEMORY_PLACEMENTS, upper=True),
+            cv.Optional(CONF_CACHE_PLACEMENT, default="INTERNAL"): cv.enum(MEMORY_PLACEMENTS, upper=True),
+            cv.Optional(CONF_INCREMENTAL_SYNC, default=False): cv.boolean,
+            cv.Optional(CONF_FULL_SYNC_INTERVAL, default="15min"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_PAGE_CACHE_ENTRIES, default=0): cv.int_range(min=0, max=16),
+            cv.Optional(CONF_PAGE_CACHE_BYTES, default="32kB"): cv.validate_bytes,
+            cv.Optional(CONF_ASYNC_FETCH, default=False): cv.boolean,
+            cv.Optional(CONF_FETCH_TASK_STACK_SIZE, default="16kB"): cv.All(cv.validate_bytes, cv.int_range(min=4096)),
+            cv.Optional(CONF_FETCH_TASK_CORE): cv.int_range(min=0, max=1),
+            cv.Optional(CONF_ADAPTIVE_POLLING): ADAPTIVE_POLLING_SCHEMA,
+            cv.Optional(CONF_SNAPSHOT): SNAPSHOT_SCHEMA,
+            cv.Optional(CONF_SOURCE_ID): cv.use_id(NotionDatabase),
+            cv.Optional(CONF_LOCAL_FILTER, default=[]): cv.ensure_list(LOCAL_FILTER_SCHEMA),
+            cv.Optional(CONF_LOCAL_SORTS, default=[]): cv.ensure_list(LOCAL_SORT_SCHEMA),
         }).extend(cv.polling_component_schema('60s'))
     ),
+    validate_sources,
     cv.only_on_esp32,
     cv.only_with_arduino,
     cv.require_esphome_version(2025, 7, 0)
 )
 
 async def to_code(configs):
+    merge_source_property_filters(configs)
     for config in configs:
         var = cg.new_Pvariable(config[CONF_ID])
         await cg.register_component(var, config)
@@ -62,6 +215,7 @@ async def to_code(configs):
             cg.add(var.set_api_token(api_token_tpl))
         if database_id_tpl := await cg.templatable(config[CONF_DATABASE_ID], [], cg.std_string):
             cg.add(var.set_database_id(database_id_tpl))
+        cg.add(var.set_base_url(config[CONF_BASE_URL]))
         if query_tpl := await cg.templatable(config[CONF_QUERY], [], cg.std_string):
             cg.add(var.set_query(query_tpl))
         for property_filter in config[CONF_PROPERTY_FILTERS]:
@@ -69,7 +223,7 @@ async def to_code(configs):
         for trigger in config.get(CONF_ON_PAGE_CHANGE, []):
             await automation.build_automation(
                     var.get_on_page_change_trigger(),
-                    [],
+                    [(ChangeSet.operator("ref").operator("const"), "changes")],
                     trigger)
 
         if CONF_WATCHDOG_TIMEOUT in config:
@@ -81,9 +235,44 @@ async def to_code(configs):
         if CONF_HTTP_TIMEOUT in config:
             timeout_tpl = await cg.templatable(config[CONF_HTTP_TIMEOUT], [], cg.uint32)
             cg.add(var.set_http_timeout(timeout_tpl))
+        cg.add(var.set_keep_alive(config[CONF_KEEP_ALIVE]))
+        cg.add(var.set_keep_alive_timeout(config[CONF_KEEP_ALIVE_TIMEOUT]))
         if CONF_JSON_PARSE_BUFFER_SIZE in config:
             buffer_size_tpl = await cg.templatable(config[CONF_JSON_PARSE_BUFFER_SIZE], [], cg.uint32)
             cg.add(var.set_json_parse_buffer_size(buffer_size_tpl))
+        cg.add(var.set_json_parse_buffer_placement(config[CONF_JSON_PARSE_BUFFER_PLACEMENT]))
+        cg.add(var.set_page_store_placement(config[CONF_PAGE_STORE_PLACEMENT]))
+        cg.add(var.set_cache_placement(config[CONF_CACHE_PLACEMENT]))
+        cg.add(var.set_incremental_sync(config[CONF_INCREMENTAL_SYNC]))
+        cg.add(var.set_full_sync_interval(config[CONF_FULL_SYNC_INTERVAL]))
+        cg.add(var.set_page_cache_entries(config[CONF_PAGE_CACHE_ENTRIES]))
+        cg.add(var.set_page_cache_bytes(config[CONF_PAGE_CACHE_BYTES]))
+        cg.add(var.set_async_fetch(config[CONF_ASYNC_FETCH]))
+        cg.add(var.set_fetch_task_stack_size(config[CONF_FETCH_TASK_STACK_SIZE]))
+        if CONF_FETCH_TASK_CORE in config:
+            cg.add(var.set_fetch_task_core(config[CONF_FETCH_TASK_CORE]))
+        if adaptive := config.get(CONF_ADAPTIVE_POLLING):
+            cg.add(var.set_adaptive_polling(adaptive[CONF_MIN_INTERVAL], adaptive[CONF_MAX_INTERVAL],
+                                            adaptive[CONF_BACKOFF_FACTOR]))
+            if quiet_hours := adaptive.get(CONF_QUIET_HOURS):
+                clock = await cg.get_variable(quiet_hours[CONF_TIME_ID])
+                cg.add(var.set_time(clock))
+                cg.add(var.set_quiet_hours(seconds_of_day(quiet_hours[CONF_START]),
+                                           seconds_of_day(quiet_hours[CONF_END])))
+        if snapshot := config.get(CONF_SNAPSHOT):
+            cg.add(var.set_snapshot(fnv1_hash(config[CONF_ID].id), snapshot[CONF_MAX_SIZE]))
+            cg.add(var.set_snapshot_write_delay(snapshot[CONF_WRITE_DELAY]))
+            cg.add(var.set_snapshot_max_age(snapshot[CONF_MAX_AGE]))
+            if CONF_TIME_ID in snapshot:
+                clock = await cg.get_variable(snapshot[CONF_TIME_ID])
+                cg.add(var.set_time(clock))
+        if CONF_SOURCE_ID in config:
+            source = await cg.get_variable(config[CONF_SOURCE_ID])
+            cg.add(var.set_source(source))
+        for condition in config[CONF_LOCAL_FILTER]:
+            cg.add(var.add_local_condition(condition[CONF_PROPERTY], condition[CONF_OPERATOR], condition[CONF_VALUE]))
+        for sort in config[CONF_LOCAL_SORTS]:
+            cg.add(var.add_local_sort(sort[CONF_PROPERTY], sort[CONF_DIRECTION] == "ascending"))
 
     # WiFi auto-enables Network via Arduino library dependency mapping
     cg.add_library("WiFi", None)
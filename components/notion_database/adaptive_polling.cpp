@@ -0,0 +1,57 @@
+#include "adaptive_polling.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace notion_database {
+
+static const uint32_t SECONDS_PER_DAY = 86400;
+
+void AdaptivePolling::set_intervals(uint32_t min_interval, uint32_t max_interval) {
+  min_interval_ = min_interval;
+  max_interval_ = std::max(min_interval, max_interval);
+  reset();
+}
+
+void AdaptivePolling::set_quiet_hours(uint32_t start, uint32_t end) {
+  quiet_start_ = start % SECONDS_PER_DAY;
+  quiet_end_ = end % SECONDS_PER_DAY;
+}
+
+uint32_t AdaptivePolling::grow_(uint32_t interval) const {
+  float grown = interval * backoff_factor_;
+  return grown >= max_interval_ ? max_interval_ : std::max(static_cast<uint32_t>(grown), min_interval_);
+}
+
+uint32_t AdaptivePolling::on_success(bool changed) {
+  failure_interval_ = 0;
+  // Edits tend to come in bursts, so a change is followed by polls at the minimum interval
+  interval_ = changed ? min_interval_ : grow_(interval_);
+  return interval_;
+}
+
+uint32_t AdaptivePolling::on_failure() {
+  failure_interval_ = failure_interval_ == 0 ? min_interval_ : grow_(failure_interval_);
+  return failure_interval_;
+}
+
+void AdaptivePolling::reset() {
+  interval_ = min_interval_;
+  failure_interval_ = 0;
+}
+
+uint32_t AdaptivePolling::get_quiet_delay(uint32_t seconds_of_day) const {
+  if (!has_quiet_hours()) {
+    return 0;
+  }
+  bool quiet = quiet_start_ < quiet_end_ ? seconds_of_day >= quiet_start_ && seconds_of_day < quiet_end_
+                                         : seconds_of_day >= quiet_start_ || seconds_of_day < quiet_end_;
+  if (!quiet) {
+    return 0;
+  }
+  uint32_t remaining = (quiet_end_ + SECONDS_PER_DAY - seconds_of_day) % SECONDS_PER_DAY;
+  return remaining * 1000;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
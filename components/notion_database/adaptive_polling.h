@@ -0,0 +1,58 @@
+#pragma once
+/**
+ * @file adaptive_polling.h
+ * @brief Chooses the delay before the next poll from the outcome of the last one.
+ */
+
+#include <cstdint>
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief Polls quickly while a database is being edited and backs off while it is idle.
+ *
+ * A fetch that finds changes resets the interval to the minimum; each fetch that finds none
+ * multiplies it by the backoff factor, up to the maximum. Failed fetches back off the same way
+ * from the minimum, independently of the idle interval, so a brief outage does not slow down
+ * polling once it is over. An optional quiet-hours window postpones polls to its end.
+ */
+class AdaptivePolling {
+ public:
+  // Sets the bounds of the interval in milliseconds; a minimum of 0 disables adaptive polling
+  void set_intervals(uint32_t min_interval, uint32_t max_interval);
+  // Sets the factor the interval grows by after each fetch without changes
+  void set_backoff_factor(float backoff_factor) { backoff_factor_ = backoff_factor; }
+  // Sets the quiet hours in seconds since midnight; the window may span midnight
+  void set_quiet_hours(uint32_t start, uint32_t end);
+  bool is_enabled() const { return min_interval_ > 0; }
+  bool has_quiet_hours() const { return quiet_start_ != quiet_end_; }
+
+  // Returns the delay before the next poll after a successful fetch
+  uint32_t on_success(bool changed);
+  // Returns the delay before the next poll after a failed fetch
+  uint32_t on_failure();
+  // Returns to the minimum interval, e.g. after the query changed
+  void reset();
+  // Returns the current interval
+  uint32_t get_interval() const { return interval_; }
+  uint32_t get_min_interval() const { return min_interval_; }
+  uint32_t get_max_interval() const { return max_interval_; }
+  float get_backoff_factor() const { return backoff_factor_; }
+  // Returns the milliseconds until the quiet hours end, or 0 outside of them
+  uint32_t get_quiet_delay(uint32_t seconds_of_day) const;
+
+ protected:
+  uint32_t grow_(uint32_t interval) const;
+
+  uint32_t min_interval_{0};
+  uint32_t max_interval_{0};
+  float backoff_factor_{2.0f};
+  uint32_t interval_{0};
+  uint32_t failure_interval_{0};
+  uint32_t quiet_start_{0};
+  uint32_t quiet_end_{0};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -1,10 +1,119 @@
 #include "allocator.h"
 
+#include <esp_heap_caps.h>
+
+#include <atomic>
+#include <cstring>
+
 namespace esphome {
 namespace notion_database {
 
-// Global allocator
-RAMAllocator<uint8_t> ALLOCATOR = RAMAllocator<uint8_t>(RAMAllocator<uint8_t>::NONE);
+static const uint32_t PSRAM_CAPS = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+static const uint32_t INTERNAL_CAPS = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+
+// Counted from the fetch tasks as well as the main loop
+static std::atomic<size_t> fallback_count{0};
+
+// Returns the name of a placement
+const char *memory_placement_to_string(MemoryPlacement placement) {
+  return placement == MemoryPlacement::INTERNAL ? "INTERNAL" : "PSRAM";
+}
+
+// A board without PSRAM always lands in internal RAM, which is not a fallback
+static bool counts_as_fallback(uint32_t preferred) { return heap_caps_get_total_size(preferred) > 0; }
+
+// Allocates from the preferred heap, falling back to the other heap
+void *placed_allocate(size_t n, MemoryPlacement placement) {
+  uint32_t preferred = placement == MemoryPlacement::INTERNAL ? INTERNAL_CAPS : PSRAM_CAPS;
+  uint32_t other = placement == MemoryPlacement::INTERNAL ? PSRAM_CAPS : INTERNAL_CAPS;
+  void *p = heap_caps_malloc(n, preferred);
+  if (p == nullptr) {
+    p = heap_caps_malloc(n, other);
+    if (p != nullptr && counts_as_fallback(preferred)) fallback_count++;
+  }
+  return p;
+}
+
+// Reallocates in the preferred heap, falling back to the other heap
+void *placed_reallocate(void *p, size_t n, MemoryPlacement placement) {
+  uint32_t preferred = placement == MemoryPlacement::INTERNAL ? INTERNAL_CAPS : PSRAM_CAPS;
+  uint32_t other = placement == MemoryPlacement::INTERNAL ? PSRAM_CAPS : INTERNAL_CAPS;
+  void *moved = heap_caps_realloc(p, n, preferred);
+  if (moved == nullptr) {
+    moved = heap_caps_realloc(p, n, other);
+    if (moved != nullptr && counts_as_fallback(preferred)) fallback_count++;
+  }
+  return moved;
+}
+
+void placed_deallocate(void *p) { heap_caps_free(p); }
+
+// Returns how many allocations were served by the non-preferred heap
+size_t placed_fallback_count() { return fallback_count; }
+
+ArenaAllocator::~ArenaAllocator() { placed_deallocate(block_); }
+
+// Allocates the backing block
+bool ArenaAllocator::init(size_t size, MemoryPlacement placement) {
+  placed_deallocate(block_);
+  placement_ = placement;
+  block_ = static_cast<uint8_t *>(placed_allocate(size, placement));
+  capacity_ = block_ != nullptr ? size : 0;
+  reset();
+  return block_ != nullptr;
+}
+
+void *ArenaAllocator::allocate(size_t n) {
+  size_t size = align_(n);
+  if (size <= capacity_ - used_) {
+    void *p = block_ + used_;
+    used_ += size;
+    peak_ = std::max(peak_, used_);
+    return p;
+  }
+  fallback_count_++;
+  return placed_allocate(n, placement_);
+}
+
+void ArenaAllocator::deallocate(void *p, size_t n) {
+  if (p == nullptr) return;
+  if (!owns(p)) {
+    placed_deallocate(p);
+    return;
+  }
+  // Only the most recent allocation can be given back before reset()
+  if (static_cast<uint8_t *>(p) + align_(n) == block_ + used_) {
+    used_ -= align_(n);
+  }
+}
+
+void *ArenaAllocator::reallocate(void *p, size_t old_size, size_t new_size) {
+  if (p == nullptr) return allocate(new_size);
+  if (!owns(p)) {
+    return placed_reallocate(p, new_size, placement_);
+  }
+
+  // Grow or shrink the most recent allocation in place
+  size_t offset = static_cast<uint8_t *>(p) - block_;
+  if (offset + align_(old_size) == used_ && offset + align_(new_size) <= capacity_) {
+    used_ = offset + align_(new_size);
+    peak_ = std::max(peak_, used_);
+    return p;
+  }
+
+  void *moved = allocate(new_size);
+  if (moved == nullptr) return nullptr;
+  std::memcpy(moved, p, std::min(old_size, new_size));
+  deallocate(p, old_size);
+  return moved;
+}
+
+// Releases everything and clears the statistics
+void ArenaAllocator::reset() {
+  used_ = 0;
+  peak_ = 0;
+  fallback_count_ = 0;
+}
 
 }  // namespace notion_database
 }  // namespace esphome
@@ -1,12 +1,26 @@
 #pragma once
 
 #include "esphome/core/helpers.h"
+#include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 
 namespace esphome {
 namespace notion_database {
 
-extern RAMAllocator<uint8_t> ALLOCATOR;
+// Where a buffer should be allocated
+enum class MemoryPlacement : uint8_t { PSRAM, INTERNAL };
+
+// Returns the name of a placement
+const char *memory_placement_to_string(MemoryPlacement placement);
+
+// Allocates from the preferred heap, falling back to the other heap when it is exhausted
+void *placed_allocate(size_t n, MemoryPlacement placement);
+void *placed_reallocate(void *p, size_t n, MemoryPlacement placement);
+void placed_deallocate(void *p);
+// Returns how many allocations were served by the non-preferred heap
+size_t placed_fallback_count();
 
 template <typename T>
 struct Allocator {
@@ -17,6 +31,8 @@ struct Allocator {
   typedef const T* const_pointer;
   typedef T& reference;
   typedef const T& const_reference;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
 
   template <typename U>
   struct rebind {
@@ -25,25 +41,70 @@ struct Allocator {
 
   Allocator() = default;
 
+  explicit Allocator(MemoryPlacement placement) : placement(placement) {}
+
   template <typename U>
-  Allocator(const Allocator<U>&) {}
+  Allocator(const Allocator<U>& other) : placement(other.placement) {}
 
   ~Allocator() {}
 
   T* allocate(size_t n) {
-    void* mem = ALLOCATOR.allocate(n * sizeof(T), alignof(T));
+    void* mem = placed_allocate(n * sizeof(T), placement);
     return static_cast<T*>(mem);
   }
 
-  void deallocate(T* p, size_t n) {
-    ALLOCATOR.deallocate(static_cast<uint8_t*>(static_cast<void*>(p)), n * sizeof(T));
-  }
+  void deallocate(T* p, size_t n) { placed_deallocate(p); }
 
   template <typename U>
-  bool operator==(const Allocator<U>&) const { return true; }
+  bool operator==(const Allocator<U>& other) const { return placement == other.placement; }
 
   template <typename U>
-  bool operator!=(const Allocator<U>&) const { return false; }
+  bool operator!=(const Allocator<U>& other) const { return placement != other.placement; }
+
+  MemoryPlacement placement{MemoryPlacement::PSRAM};
+};
+
+/**
+ * @brief Bump allocator for data that lives no longer than one response.
+ *
+ * Allocations are carved out of one block that is allocated once and released in a single
+ * reset(), so parsing a response does not leave holes in the heap. Allocations that do not fit
+ * fall back to the heap of the arena's placement.
+ */
+class ArenaAllocator {
+ public:
+  ~ArenaAllocator();
+
+  // Allocates the backing block; any previous block is freed
+  bool init(size_t size, MemoryPlacement placement);
+
+  void *allocate(size_t n);
+  void deallocate(void *p, size_t n);
+  void *reallocate(void *p, size_t old_size, size_t new_size);
+
+  // Returns a position that rewind() can return to
+  size_t mark() const { return used_; }
+  // Releases everything allocated after mark
+  void rewind(size_t mark) { used_ = std::min(mark, used_); }
+  // Releases everything and clears the statistics
+  void reset();
+
+  bool owns(const void *p) const { return p >= block_ && p < block_ + capacity_; }
+  size_t capacity() const { return capacity_; }
+  size_t used() const { return used_; }
+  size_t peak() const { return peak_; }
+  size_t fallback_count() const { return fallback_count_; }
+  MemoryPlacement placement() const { return placement_; }
+
+ protected:
+  static size_t align_(size_t n) { return (n + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1); }
+
+  uint8_t *block_{nullptr};
+  size_t capacity_{0};
+  size_t used_{0};
+  size_t peak_{0};
+  size_t fallback_count_{0};
+  MemoryPlacement placement_{MemoryPlacement::PSRAM};
 };
 
 }  // namespace notion_database
@@ -0,0 +1,127 @@
+#include "change_set.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace esphome {
+namespace notion_database {
+
+void ChangeSet::clear() {
+  inserted.clear();
+  removed.clear();
+  moved.clear();
+  modified.clear();
+  schema_changed = false;
+}
+
+// Returns whether a row of the current pages was inserted, moved or modified
+bool ChangeSet::is_row_changed(uint32_t row) const {
+  if (schema_changed) return true;
+  for (uint32_t inserted_row : inserted) {
+    if (inserted_row == row) return true;
+  }
+  for (const auto &change : moved) {
+    if (change.row == row) return true;
+  }
+  for (const auto &change : modified) {
+    if (change.row == row) return true;
+  }
+  return false;
+}
+
+using Row = ChangeSet::Row;
+
+// Marks the longest subsequence of rows whose old rows are increasing, in O(n log n)
+static std::vector<bool> longest_ordered_run(const std::vector<Row> &rows) {
+  // tails[k] is the index of the smallest old row ending an increasing run of length k + 1
+  std::vector<uint32_t> tails;
+  std::vector<int> previous(rows.size(), -1);
+  for (size_t i = 0; i < rows.size(); i++) {
+    auto it = std::lower_bound(tails.begin(), tails.end(), rows[i].old_row,
+                               [&rows](uint32_t tail, uint32_t old_row) { return rows[tail].old_row < old_row; });
+    if (it != tails.begin()) {
+      previous[i] = *(it - 1);
+    }
+    if (it == tails.end()) {
+      tails.push_back(i);
+    } else {
+      *it = i;
+    }
+  }
+
+  std::vector<bool> in_run(rows.size(), false);
+  for (int i = tails.empty() ? -1 : tails.back(); i >= 0; i = previous[i]) {
+    in_run[i] = true;
+  }
+  return in_run;
+}
+
+// Computes the changes that turn before into after
+void diff_pages(const PageTable &before, const PageTable &after, ChangeSet &changes) {
+  changes.clear();
+
+  // Map the columns of after to the columns of before
+  const auto &columns = after.columns();
+  std::vector<int> old_columns(columns.size());
+  changes.schema_changed = columns.size() != before.columns().size();
+  for (size_t i = 0; i < columns.size(); i++) {
+    old_columns[i] = before.find_column(columns[i].key);
+    if (old_columns[i] < 0 || before.column(old_columns[i]).type != columns[i].type) {
+      old_columns[i] = -1;
+      changes.schema_changed = true;
+    }
+  }
+
+  std::unordered_map<uint32_t, uint32_t> old_rows;
+  old_rows.reserve(before.size());
+  for (Page page : before) {
+    old_rows.emplace(before.row_key(page.index()), page.index());
+  }
+
+  std::vector<bool> kept(before.size(), false);
+  std::vector<Row> kept_rows;
+  kept_rows.reserve(std::min(before.size(), after.size()));
+  for (Page page : after) {
+    uint32_t row = page.index();
+    auto it = old_rows.find(after.row_key(row));
+    if (it == old_rows.end()) {
+      changes.inserted.push_back(row);
+      continue;
+    }
+    uint32_t old_row = it->second;
+    kept[old_row] = true;
+
+    uint32_t changed_columns = 0;
+    if (after.row_hash(row) != before.row_hash(old_row)) {
+      // Edits to properties that are not stored leave every cell unchanged
+      for (size_t i = 0; i < columns.size(); i++) {
+        if (old_columns[i] < 0 || !PageTable::cell_equals(after, i, row, before, old_columns[i], old_row)) {
+          changed_columns |= ChangeSet::column_bit(i);
+        }
+      }
+    }
+    if (changed_columns != 0) {
+      changes.modified.push_back({row, old_row, changed_columns});
+    }
+    kept_rows.push_back({row, old_row, 0});
+  }
+
+  // Inserts and removals shift the rows after them without moving them; a row only moved when
+  // its order relative to the other kept rows changed. The rows outside the longest run that
+  // kept their relative order are the fewest that explain the new order.
+  std::vector<bool> in_order = longest_ordered_run(kept_rows);
+  for (size_t i = 0; i < kept_rows.size(); i++) {
+    if (!in_order[i]) {
+      changes.moved.push_back(kept_rows[i]);
+    }
+  }
+
+  for (size_t i = 0; i < kept.size(); i++) {
+    if (!kept[i]) {
+      changes.removed.push_back(i);
+    }
+  }
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,54 @@
+#pragma once
+/**
+ * @file change_set.h
+ * @brief Row-level difference between two versions of a PageTable.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "page_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief What changed between the previous and the current pages.
+ *
+ * Rows are matched by page ID. Row indices refer to the current pages, except for removed rows
+ * and `old_row`, which refer to the previous pages. Column masks have bit i set when column i of
+ * the current pages changed; columns past the 31st share the highest bit.
+ */
+struct ChangeSet {
+  struct Row {
+    uint32_t row;
+    uint32_t old_row;
+    uint32_t columns;
+  };
+
+  // Rows that are new
+  std::vector<uint32_t> inserted;
+  // Rows that are gone, as indices into the previous pages
+  std::vector<uint32_t> removed;
+  // Rows whose order relative to the other kept rows changed; rows only shifted by inserts or removals are not moved
+  std::vector<Row> moved;
+  // Rows with at least one changed cell
+  std::vector<Row> modified;
+  // Whether the columns changed, in which case every row should be considered changed
+  bool schema_changed{false};
+
+  bool empty() const {
+    return inserted.empty() && removed.empty() && moved.empty() && modified.empty() && !schema_changed;
+  }
+  void clear();
+  // Returns the mask of a column index
+  static uint32_t column_bit(size_t column) { return 1u << (column < 31 ? column : 31); }
+  // Returns whether a row of the current pages was inserted, moved or modified
+  bool is_row_changed(uint32_t row) const;
+};
+
+// Computes the changes that turn before into after
+void diff_pages(const PageTable &before, const PageTable &after, ChangeSet &changes);
+
+}  // namespace notion_database
+}  // namespace esphome
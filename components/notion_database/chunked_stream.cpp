@@ -0,0 +1,100 @@
+#include "chunked_stream.h"
+
+#include <cstdlib>
+
+// Constructor
+ChunkedStream::ChunkedStream(Stream &inner) : inner_(inner) { setTimeout(inner.getTimeout()); }
+
+// Returns the number of payload bytes available without blocking
+int ChunkedStream::available() {
+  if (done_ || error_) return 0;
+  if (remaining_ == 0) {
+    // A chunk header is pending; report data so readers keep reading
+    return inner_.available() > 0 ? 1 : 0;
+  }
+  return std::min<int>(remaining_, inner_.available());
+}
+
+// Reads a payload byte
+int ChunkedStream::read() {
+  if (!next_chunk_()) return -1;
+  int c = inner_.read();
+  if (c < 0) return -1;
+  if (--remaining_ == 0) {
+    end_chunk_();
+  }
+  return c;
+}
+
+// Peeks at the next payload byte
+int ChunkedStream::peek() {
+  if (!next_chunk_()) return -1;
+  return inner_.peek();
+}
+
+// Reads and discards the rest of the body
+bool ChunkedStream::drain() {
+  char buf[64];
+  while (next_chunk_()) {
+    size_t n = inner_.readBytes(buf, std::min(remaining_, sizeof(buf)));
+    if (n == 0) {
+      error_ = true;
+      break;
+    }
+    remaining_ -= n;
+    if (remaining_ == 0) {
+      end_chunk_();
+    }
+  }
+  return done_;
+}
+
+// Consumes the CRLF that follows a chunk payload
+void ChunkedStream::end_chunk_() {
+  char crlf[2];
+  if (inner_.readBytes(crlf, sizeof(crlf)) != sizeof(crlf)) {
+    error_ = true;
+  }
+}
+
+// Reads the next chunk header if the current chunk is exhausted
+bool ChunkedStream::next_chunk_() {
+  if (done_ || error_) return false;
+  if (remaining_ > 0) return true;
+
+  char line[32];
+  if (!read_line_(line, sizeof(line))) {
+    error_ = true;
+    return false;
+  }
+  // Chunk extensions after ';' are ignored
+  remaining_ = std::strtoul(line, nullptr, 16);
+  if (remaining_ == 0) {
+    // Skip trailers up to the empty line that ends the body; a body cut short before it is not complete
+    do {
+      if (!read_line_(line, sizeof(line))) {
+        error_ = true;
+        return false;
+      }
+    } while (line[0] != '\0');
+    done_ = true;
+    return false;
+  }
+  return true;
+}
+
+// Reads a CRLF-terminated line from the inner stream
+bool ChunkedStream::read_line_(char *buf, size_t size) {
+  size_t len = 0;
+  char c;
+  while (inner_.readBytes(&c, 1) == 1) {
+    if (c == '\n') {
+      buf[len] = '\0';
+      return true;
+    }
+    if (c != '\r' && len + 1 < size) {
+      buf[len++] = c;
+    }
+  }
+  return false;
+}
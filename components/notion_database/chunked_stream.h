@@ -0,0 +1,41 @@
+#pragma once
+
+#include "esphome.h"
+
+/**
+ * @brief Decodes an HTTP/1.1 chunked transfer-encoded body.
+ *
+ * Wraps the raw connection stream and yields only the chunk payloads, so the JSON parser can
+ * read a keep-alive response exactly like an HTTP/1.0 body.
+ */
+class ChunkedStream : public Stream {
+ public:
+  // Constructor
+  ChunkedStream(Stream &inner);
+
+  // Returns the number of payload bytes available without blocking
+  int available() override;
+  // Reads a payload byte
+  int read() override;
+  // Peeks at the next payload byte
+  int peek() override;
+  // Writing is not supported
+  size_t write(uint8_t byte) override { return 0; }
+  // Reads and discards the rest of the body, including the last chunk and trailers
+  bool drain();
+  // Returns true once the last chunk has been read
+  bool is_done() const { return done_; }
+
+ private:
+  // Reads the next chunk header if the current chunk is exhausted
+  bool next_chunk_();
+  // Consumes the CRLF that follows a chunk payload
+  void end_chunk_();
+  // Reads a CRLF-terminated line from the inner stream
+  bool read_line_(char *buf, size_t size);
+
+  Stream &inner_;
+  size_t remaining_{0};
+  bool done_{false};
+  bool error_{false};
+};
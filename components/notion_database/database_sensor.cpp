@@ -0,0 +1,64 @@
+#include "database_sensor.h"
+
+#ifdef USE_SENSOR
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.sensor";
+
+void NotionDatabaseSensor::setup() {
+  database_->add_on_fetch_callback([this](const FetchStats &stats, bool success) { this->on_fetch_(stats, success); });
+}
+
+void NotionDatabaseSensor::set_window_size(size_t window_size) {
+  window_size_ = window_size;
+  for (auto &window : windows_) {
+    window.set_window_size(window_size);
+  }
+}
+
+void NotionDatabaseSensor::add_sensor(DatabaseMetric metric, Statistic statistic, sensor::Sensor *sensor) {
+  sensors_.push_back(Entry{metric, statistic, sensor});
+}
+
+void NotionDatabaseSensor::on_fetch_(const FetchStats &stats, bool success) {
+  windows_[static_cast<size_t>(DatabaseMetric::CONSECUTIVE_FAILURES)].add(database_->get_consecutive_failures());
+  if (!success) {
+    return;
+  }
+  windows_[static_cast<size_t>(DatabaseMetric::CONNECT_TIME)].add(stats.connect_us / 1000.0f);
+  windows_[static_cast<size_t>(DatabaseMetric::REQUEST_TIME)].add(stats.request_us / 1000.0f);
+  windows_[static_cast<size_t>(DatabaseMetric::FIRST_BYTE_TIME)].add(stats.first_byte_us / 1000.0f);
+  windows_[static_cast<size_t>(DatabaseMetric::PARSE_TIME)].add(stats.parse_us / 1000.0f);
+  windows_[static_cast<size_t>(DatabaseMetric::APPLY_TIME)].add(stats.apply_us / 1000.0f);
+  windows_[static_cast<size_t>(DatabaseMetric::BYTES_READ)].add(stats.response_bytes);
+  windows_[static_cast<size_t>(DatabaseMetric::PAGES)].add(stats.pages);
+  windows_[static_cast<size_t>(DatabaseMetric::PARSE_HEAP)].add(stats.heap_used_peak());
+  windows_[static_cast<size_t>(DatabaseMetric::LARGEST_FREE_BLOCK)].add(stats.largest_free_block);
+}
+
+void NotionDatabaseSensor::update() {
+  for (const auto &entry : sensors_) {
+    const RollingStats &window = windows_[static_cast<size_t>(entry.metric)];
+    if (!window.empty()) {
+      entry.sensor->publish_state(window.get(entry.statistic));
+    }
+  }
+}
+
+void NotionDatabaseSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "Notion Database Sensor:");
+  ESP_LOGCONFIG(TAG, "  Window Size: %u", static_cast<unsigned>(window_size_));
+  for (const auto &entry : sensors_) {
+    LOG_SENSOR("  ", statistic_to_string(entry.statistic), entry.sensor);
+  }
+  LOG_UPDATE_INTERVAL(this);
+}
+
+}  // namespace notion_database
+}  // namespace esphome
+
+#endif  // USE_SENSOR
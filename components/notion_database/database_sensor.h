@@ -0,0 +1,66 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#ifdef USE_SENSOR
+
+#include <vector>
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "notion_database.h"
+#include "rolling_stats.h"
+
+namespace esphome {
+namespace notion_database {
+
+enum class DatabaseMetric : uint8_t {
+  CONNECT_TIME,
+  REQUEST_TIME,
+  FIRST_BYTE_TIME,
+  PARSE_TIME,
+  APPLY_TIME,
+  BYTES_READ,
+  PAGES,
+  PARSE_HEAP,
+  LARGEST_FREE_BLOCK,
+  CONSECUTIVE_FAILURES,
+};
+
+/**
+ * @brief Publishes the fetch statistics of a NotionDatabase as sensors.
+ *
+ * Every successful fetch adds a sample to a rolling window per metric; the configured
+ * statistic of each window is published on the update interval, so a display refresh or a
+ * burst of page flips does not flood Home Assistant with states.
+ */
+class NotionDatabaseSensor : public PollingComponent {
+ public:
+  void setup() override;
+  void update() override;
+  void dump_config() override;
+
+  void set_database(NotionDatabase *database) { database_ = database; }
+  void set_window_size(size_t window_size);
+  void add_sensor(DatabaseMetric metric, Statistic statistic, sensor::Sensor *sensor);
+
+ protected:
+  static const size_t METRIC_COUNT = static_cast<size_t>(DatabaseMetric::CONSECUTIVE_FAILURES) + 1;
+
+  struct Entry {
+    DatabaseMetric metric;
+    Statistic statistic;
+    sensor::Sensor *sensor;
+  };
+
+  void on_fetch_(const FetchStats &stats, bool success);
+
+  NotionDatabase *database_{nullptr};
+  size_t window_size_{20};
+  std::vector<Entry> sensors_;
+  RollingStats windows_[METRIC_COUNT];
+};
+
+}  // namespace notion_database
+}  // namespace esphome
+
+#endif  // USE_SENSOR
@@ -0,0 +1,59 @@
+#include "fetch_task.h"
+
+#include "esphome/core/application.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.task";
+
+static thread_local bool on_fetch_task = false;
+
+void feed_wdt() {
+  if (!on_fetch_task) {
+    App.feed_wdt();
+  }
+}
+
+bool FetchTask::start(const char *name, uint32_t stack_size, int core, std::function<void()> &&job) {
+  job_ = std::move(job);
+  BaseType_t affinity = core < 0 ? tskNO_AFFINITY : core;
+  if (xTaskCreatePinnedToCore(task_main_, name, stack_size, this, tskIDLE_PRIORITY + 1, &task_, affinity) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create task with %u bytes of stack", stack_size);
+    task_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool FetchTask::run() {
+  uint8_t expected = IDLE;
+  if (task_ == nullptr ||
+      !state_.compare_exchange_strong(expected, RUNNING, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    return false;
+  }
+  xTaskNotifyGive(task_);
+  return true;
+}
+
+bool FetchTask::take_finished() {
+  uint8_t expected = FINISHED;
+  return state_.compare_exchange_strong(expected, IDLE, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+void FetchTask::task_main_(void *arg) {
+  FetchTask *task = static_cast<FetchTask *>(arg);
+  on_fetch_task = true;
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (task->state_.load(std::memory_order_acquire) != RUNNING) {
+      continue;
+    }
+    task->job_();
+    task->state_.store(FINISHED, std::memory_order_release);
+  }
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,53 @@
+#pragma once
+/**
+ * @file fetch_task.h
+ * @brief Runs query requests on a FreeRTOS task of their own.
+ */
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace notion_database {
+
+// Feeds the task watchdog; does nothing on a fetch task, which the watchdog does not watch
+void feed_wdt();
+
+/**
+ * @brief A worker task that runs one job at a time for the main loop.
+ *
+ * The main loop fills in the job's input, calls run() and later collects the output once
+ * take_finished() returns true. The state word is the only thing shared between the two
+ * tasks: it moves IDLE -> RUNNING on the main loop, RUNNING -> FINISHED on the worker and
+ * FINISHED -> IDLE on the main loop again, with release/acquire ordering so each side sees
+ * everything the other wrote before handing over. No locks are taken.
+ */
+class FetchTask {
+ public:
+  // Creates the task; core is 0 or 1, or -1 for no affinity
+  bool start(const char *name, uint32_t stack_size, int core, std::function<void()> &&job);
+  bool is_started() const { return task_ != nullptr; }
+
+  // Wakes the task to run the job once; returns false if the last run has not been collected
+  bool run();
+  // Returns true once per finished run, after which the job's output may be read
+  bool take_finished();
+  // Returns whether no run is in progress or waiting to be collected
+  bool is_idle() const { return state_.load(std::memory_order_acquire) == IDLE; }
+
+ protected:
+  enum State : uint8_t { IDLE, RUNNING, FINISHED };
+
+  static void task_main_(void *arg);
+
+  std::atomic<uint8_t> state_{IDLE};
+  TaskHandle_t task_{nullptr};
+  std::function<void()> job_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
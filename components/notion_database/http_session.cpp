@@ -0,0 +1,95 @@
+#include "http_session.h"
+
+#include "fetch_task.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.http";
+
+static const char *COLLECTED_HEADERS[] = {"Transfer-Encoding", "Retry-After"};
+
+// Sends a POST request
+int HttpSession::post(const std::string &url, const std::string &api_token, const std::string &payload) {
+  bool reused = keep_alive_ && connected_ && http_.connected();
+  if (reused && millis() - last_used_ > idle_timeout_) {
+    ESP_LOGD(TAG, "Connection idle for %u ms, reconnecting", millis() - last_used_);
+    close();
+    reused = false;
+  }
+
+  int http_code = send_(url, api_token, payload);
+  if (http_code < 0 && reused) {
+    // The server may have closed the idle connection; retry once on a fresh one
+    ESP_LOGD(TAG, "Reused connection failed (%d), reconnecting", http_code);
+    close();
+    reused = false;
+    http_code = send_(url, api_token, payload);
+  }
+  if (reused) {
+    reuse_count_++;
+  }
+  last_used_ = millis();
+  return http_code;
+}
+
+int HttpSession::send_(const std::string &url, const std::string &api_token, const std::string &payload) {
+  chunked_.reset();
+  http_.setReuse(keep_alive_);
+  http_.begin(url.c_str());
+  http_.useHTTP10(!keep_alive_);
+  http_.setConnectTimeout(connect_timeout_);
+  http_.setTimeout(timeout_);
+  http_.collectHeaders(COLLECTED_HEADERS, sizeof(COLLECTED_HEADERS) / sizeof(COLLECTED_HEADERS[0]));
+  http_.addHeader("Authorization", ("Bearer " + api_token).c_str());
+  http_.addHeader("Notion-Version", "2022-06-28");
+  http_.addHeader("Content-Type", "application/json");
+  feed_wdt();
+  // POST() reuses the connection opened here
+  bool was_connected = http_.connected();
+  uint32_t start = micros();
+  bool opened = http_.open();
+  connect_us_ = was_connected ? 0 : micros() - start;
+  if (!opened) {
+    connected_ = false;
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  feed_wdt();
+  int http_code = http_.POST(payload.c_str());
+  connected_ = http_code > 0;
+  return http_code;
+}
+
+// Returns the response body with any transfer encoding removed
+Stream &HttpSession::get_stream() {
+  if (keep_alive_ && http_.header("Transfer-Encoding").equalsIgnoreCase("chunked")) {
+    if (!chunked_) {
+      chunked_.reset(new ChunkedStream(http_.getStream()));
+    }
+    return *chunked_;
+  }
+  return http_.getStream();
+}
+
+// Finishes the response
+void HttpSession::end(bool consumed) {
+  if (consumed && chunked_) {
+    consumed = chunked_->drain();
+  }
+  chunked_.reset();
+  if (!keep_alive_ || !consumed) {
+    close();
+    return;
+  }
+  http_.end();
+}
+
+// Closes the connection
+void HttpSession::close() {
+  http_.setReuse(false);
+  http_.end();
+  connected_ = false;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
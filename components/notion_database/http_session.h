@@ -0,0 +1,72 @@
+#pragma once
+
+#include <HTTPClient.h>
+
+#include <memory>
+#include <string>
+
+#include "chunked_stream.h"
+#include "esphome.h"
+
+namespace esphome {
+namespace notion_database {
+
+// HTTPClient opens the connection within POST(); this opens it beforehand, so that it can be timed
+class SessionClient : public HTTPClient {
+ public:
+  bool open() { return connect(); }
+};
+
+/**
+ * @brief HTTPS connection to the Notion API.
+ *
+ * Without keep-alive every request opens a new HTTP/1.0 connection, as before. With keep-alive
+ * the connection is reused across polls and pagination as long as it has not been idle for
+ * longer than the idle timeout, and chunked responses are decoded transparently.
+ */
+class HttpSession {
+ public:
+  void set_keep_alive(bool keep_alive) { keep_alive_ = keep_alive; }
+  bool get_keep_alive() const { return keep_alive_; }
+  void set_idle_timeout(uint32_t idle_timeout) { idle_timeout_ = idle_timeout; }
+  uint32_t get_idle_timeout() const { return idle_timeout_; }
+  void set_connect_timeout(uint32_t connect_timeout) { connect_timeout_ = connect_timeout; }
+  void set_timeout(uint32_t timeout) { timeout_ = timeout; }
+
+  // Sends a POST request and returns the HTTP status code, or a negative HTTPClient error
+  int post(const std::string &url, const std::string &api_token, const std::string &payload);
+  // Returns the response body with any transfer encoding removed
+  Stream &get_stream();
+  // Returns the content length, or -1 if unknown
+  int get_size() { return http_.getSize(); }
+  // Returns the response body as a string, for error reporting
+  String get_string() { return http_.getString(); }
+  // Returns the value of a response header collected by post()
+  String get_header(const char *name) { return http_.header(name); }
+  // Finishes the response; the connection is kept only if the body was fully consumed
+  void end(bool consumed);
+  // Closes the connection
+  void close();
+
+  // Returns the number of requests sent over a reused connection
+  uint32_t get_reuse_count() const { return reuse_count_; }
+  // Returns how long the last post() took to open the connection, including the TLS handshake; zero if reused
+  uint32_t get_connect_us() const { return connect_us_; }
+
+ protected:
+  int send_(const std::string &url, const std::string &api_token, const std::string &payload);
+
+  SessionClient http_;
+  std::unique_ptr<ChunkedStream> chunked_;
+  bool keep_alive_{false};
+  bool connected_{false};
+  uint32_t idle_timeout_{60000};
+  uint32_t connect_timeout_{5000};
+  uint32_t timeout_{10000};
+  uint32_t last_used_{0};
+  uint32_t reuse_count_{0};
+  uint32_t connect_us_{0};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,206 @@
+#include "local_query.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "notion_database.h"
+
+namespace esphome {
+namespace notion_database {
+
+const char *filter_operator_to_string(FilterOperator op) {
+  switch (op) {
+    case FilterOperator::EQUALS:
+      return "equals";
+    case FilterOperator::NOT_EQUALS:
+      return "does_not_equal";
+    case FilterOperator::CONTAINS:
+      return "contains";
+    case FilterOperator::DOES_NOT_CONTAIN:
+      return "does_not_contain";
+    case FilterOperator::IS_EMPTY:
+      return "is_empty";
+    case FilterOperator::IS_NOT_EMPTY:
+      return "is_not_empty";
+    case FilterOperator::GREATER_THAN:
+      return "greater_than";
+    case FilterOperator::LESS_THAN:
+      return "less_than";
+    default:
+      return "unknown";
+  }
+}
+
+// Adds a condition on a property
+void LocalQuery::add_condition(const std::string &property, FilterOperator op, const std::string &value) {
+  // Parsed once here rather than for every page the condition is matched against
+  int32_t epoch = 0;
+  parse_iso8601_epoch(value.c_str(), epoch);
+  conditions_.push_back({property, Page::hash_key(property), op, value, std::strtod(value.c_str(), nullptr), epoch});
+}
+
+// Adds a sort on a property
+void LocalQuery::add_sort(const std::string &property, bool ascending) {
+  sorts_.push_back({property, Page::hash_key(property), ascending});
+}
+
+// Returns whether the page matches all conditions
+bool LocalQuery::matches(const Page &page) const {
+  for (const auto &condition : conditions_) {
+    if (!matches_(condition, page.get_property(condition.key))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether a property matches a condition
+bool LocalQuery::matches_(const Condition &condition, const NotionProperty &prop) const {
+  if (!prop) {
+    return condition.op == FilterOperator::IS_EMPTY || condition.op == FilterOperator::NOT_EQUALS ||
+           condition.op == FilterOperator::DOES_NOT_CONTAIN;
+  }
+
+  // Numbers, checkboxes and dates compare their value
+  int order = 0;
+  bool empty = false;
+  bool ordered = true;
+  switch (prop.type()) {
+    case NotionPropertyType::NUMBER:
+      order = prop.number_value() < condition.number ? -1 : (prop.number_value() > condition.number ? 1 : 0);
+      break;
+    case NotionPropertyType::CHECKBOX:
+      order = prop.bool_value() == (condition.value == "true") ? 0 : 1;
+      empty = !prop.bool_value();
+      break;
+    case NotionPropertyType::DATE:
+    case NotionPropertyType::CREATED_TIME:
+    case NotionPropertyType::LAST_EDITED_TIME:
+      order = prop.epoch_value() < condition.epoch ? -1 : (prop.epoch_value() > condition.epoch ? 1 : 0);
+      empty = prop.epoch_value() == 0;
+      // An empty date is neither before nor after anything, as in Notion
+      ordered = !empty;
+      break;
+    case NotionPropertyType::MULTI_SELECT: {
+      bool any = false;
+      for (size_t i = 0; i < prop.item_count() && !any; i++) {
+        const char *item = prop.item(i);
+        any = condition.op == FilterOperator::CONTAINS || condition.op == FilterOperator::DOES_NOT_CONTAIN
+                  ? std::strstr(item, condition.value.c_str()) != nullptr
+                  : condition.value == item;
+      }
+      order = any ? 0 : 1;
+      empty = prop.item_count() == 0;
+      break;
+    }
+    default: {
+      const char *text = prop.string_value();
+      if (condition.op == FilterOperator::CONTAINS || condition.op == FilterOperator::DOES_NOT_CONTAIN) {
+        order = std::strstr(text, condition.value.c_str()) != nullptr ? 0 : 1;
+      } else {
+        order = std::strcmp(text, condition.value.c_str());
+      }
+      empty = *text == '\0';
+      break;
+    }
+  }
+
+  switch (condition.op) {
+    case FilterOperator::EQUALS:
+    case FilterOperator::CONTAINS:
+      return order == 0;
+    case FilterOperator::NOT_EQUALS:
+    case FilterOperator::DOES_NOT_CONTAIN:
+      return order != 0;
+    case FilterOperator::IS_EMPTY:
+      return empty;
+    case FilterOperator::IS_NOT_EMPTY:
+      return !empty;
+    case FilterOperator::GREATER_THAN:
+      return ordered && order > 0;
+    case FilterOperator::LESS_THAN:
+      return ordered && order < 0;
+    default:
+      return false;
+  }
+}
+
+// Compares two pages by one sort; missing properties sort last
+int LocalQuery::compare_(const Sort &sort, const Page &lhs, const Page &rhs) const {
+  NotionProperty a = lhs.get_property(sort.key);
+  NotionProperty b = rhs.get_property(sort.key);
+  if (!a || !b) {
+    return !a && !b ? 0 : (!a ? 1 : -1);
+  }
+
+  int order = 0;
+  switch (a.type()) {
+    case NotionPropertyType::NUMBER:
+      order = a.number_value() < b.number_value() ? -1 : (a.number_value() > b.number_value() ? 1 : 0);
+      break;
+    case NotionPropertyType::CHECKBOX:
+      order = static_cast<int>(a.bool_value()) - static_cast<int>(b.bool_value());
+      break;
+    case NotionPropertyType::DATE:
+    case NotionPropertyType::CREATED_TIME:
+    case NotionPropertyType::LAST_EDITED_TIME:
+      // Empty dates sort last, as in Notion
+      if (a.epoch_value() == 0 || b.epoch_value() == 0) {
+        return a.epoch_value() == b.epoch_value() ? 0 : (a.epoch_value() == 0 ? 1 : -1);
+      }
+      order = a.epoch_value() < b.epoch_value() ? -1 : (a.epoch_value() > b.epoch_value() ? 1 : 0);
+      break;
+    case NotionPropertyType::MULTI_SELECT:
+      order = std::strcmp(a.item_count() > 0 ? a.item(0) : "", b.item_count() > 0 ? b.item(0) : "");
+      break;
+    default:
+      order = std::strcmp(a.string_value(), b.string_value());
+      break;
+  }
+  return sort.ascending ? order : -order;
+}
+
+// Copies the matching pages of source into target in sort order
+uint32_t LocalQuery::apply(const PageTable &source, PageTable &target) const {
+  std::vector<uint32_t> rows;
+  rows.reserve(source.size());
+  for (Page page : source) {
+    if (matches(page)) {
+      rows.push_back(page.index());
+    }
+  }
+
+  if (!sorts_.empty()) {
+    std::stable_sort(rows.begin(), rows.end(), [this, &source](uint32_t lhs, uint32_t rhs) {
+      for (const auto &sort : sorts_) {
+        int order = compare_(sort, source[lhs], source[rhs]);
+        if (order != 0) return order < 0;
+      }
+      return false;
+    });
+  }
+
+  // Same hash as NotionDatabase::process_results_ would compute for these pages
+  uint32_t hash = 17;
+  for (uint32_t row : rows) {
+    target.copy_row(source, row);
+    hash = hash * 31 + source.row_hash(row);
+  }
+  return hash;
+}
+
+// Returns the names of the properties the query reads
+std::vector<std::string> LocalQuery::get_properties() const {
+  std::vector<std::string> properties;
+  for (const auto &condition : conditions_) {
+    properties.push_back(condition.property);
+  }
+  for (const auto &sort : sorts_) {
+    properties.push_back(sort.property);
+  }
+  return properties;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,77 @@
+#pragma once
+/**
+ * @file local_query.h
+ * @brief Filters and sorts the pages of a PageTable on the device.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "page_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+enum class FilterOperator : uint8_t {
+  EQUALS,
+  NOT_EQUALS,
+  CONTAINS,
+  DOES_NOT_CONTAIN,
+  IS_EMPTY,
+  IS_NOT_EMPTY,
+  GREATER_THAN,
+  LESS_THAN,
+};
+
+const char *filter_operator_to_string(FilterOperator op);
+
+/**
+ * @brief A filter and sort applied to pages that were already fetched.
+ *
+ * Conditions are ANDed. Text, select and status properties compare their text, multi-select
+ * properties match when any item matches, numbers and checkboxes compare their value and dates
+ * compare against an ISO 8601 value. A property missing from a page is treated as empty.
+ */
+class LocalQuery {
+ public:
+  // Adds a condition on a property
+  void add_condition(const std::string &property, FilterOperator op, const std::string &value);
+  // Adds a sort on a property; later sorts break ties of earlier ones
+  void add_sort(const std::string &property, bool ascending);
+
+  // Returns whether the page matches all conditions
+  bool matches(const Page &page) const;
+  // Copies the matching pages of source into target in sort order and returns their hash
+  uint32_t apply(const PageTable &source, PageTable &target) const;
+
+  // Returns the names of the properties the query reads
+  std::vector<std::string> get_properties() const;
+  size_t get_condition_count() const { return conditions_.size(); }
+  size_t get_sort_count() const { return sorts_.size(); }
+
+ protected:
+  struct Condition {
+    std::string property;
+    uint32_t key;
+    FilterOperator op;
+    std::string value;
+    double number;
+    int32_t epoch;
+  };
+
+  struct Sort {
+    std::string property;
+    uint32_t key;
+    bool ascending;
+  };
+
+  bool matches_(const Condition &condition, const NotionProperty &prop) const;
+  int compare_(const Sort &sort, const Page &lhs, const Page &rhs) const;
+
+  std::vector<Condition> conditions_;
+  std::vector<Sort> sorts_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
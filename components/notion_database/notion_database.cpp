@@ -1,9 +1,9 @@
 #include "notion_database.h"
 
-#include <HTTPClient.h>
-
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <set>
 
 #include "allocator.h"
@@ -18,6 +18,12 @@ namespace notion_database {
 
 static const char *const TAG = "notion_database";
 
+// Seconds to wait after a 429 response without a usable Retry-After header, and the longest wait honored
+static const uint32_t DEFAULT_RETRY_AFTER = 5;
+static const uint32_t MAX_RETRY_AFTER = 300;
+// Milliseconds before the first adaptive poll, and between polls while waiting for the network to fetch it
+static const uint32_t FIRST_POLL_DELAY = 1000;
+
 std::string tm_to_date(const std::tm &tm_time) {
   char buffer[10];
   std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm_time);
@@ -30,38 +36,261 @@ std::string tm_to_iso8601(const std::tm &tm_time) {
   return std::string(buffer);
 }
 
+// Hashes a string without copying it
+static uint32_t fnv1a_hash(const char *str, uint32_t hash = 2166136261UL) {
+  for (; *str != '\0'; str++) {
+    hash ^= static_cast<uint8_t>(*str);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+// Returns the seconds since epoch, or 0 until the clock has been set
+static uint32_t current_epoch() {
+  time_t now = ::time(nullptr);
+  // Anything before 2020 is the clock counting from boot
+  return now > 1577836800 ? static_cast<uint32_t>(now) : 0;
+}
+
+const char *fetch_mode_to_string(FetchMode mode) {
+  switch (mode) {
+    case FetchMode::PAGE:
+      return "page";
+    case FetchMode::INCREMENTAL:
+      return "incremental";
+    case FetchMode::APPEND:
+      return "append";
+    case FetchMode::PREFETCH:
+      return "prefetch";
+  }
+  return "unknown";
+}
+
+// Notion sends a number of seconds; an HTTP date or a missing header falls back to a default
+uint32_t parse_retry_after(const char *value) {
+  char *end = nullptr;
+  unsigned long seconds = std::strtoul(value, &end, 10);
+  if (end == value || seconds == 0) {
+    return DEFAULT_RETRY_AFTER;
+  }
+  return std::min<unsigned long>(seconds, MAX_RETRY_AFTER);
+}
+
+// Logs free and largest free block of the internal heap and PSRAM
+void NotionDatabase::log_heap_(const char *stage) {
+  ESP_LOGD(TAG, "%s: internal free:%u, max block:%u; psram free:%u, max block:%u; fallbacks:%u", stage,
+           heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL),
+           heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL),
+           heap_caps_get_free_size(MALLOC_CAP_SPIRAM), heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM),
+           placed_fallback_count());
+}
+
 // Setup priority
 float NotionDatabase::get_setup_priority() const { return setup_priority::LATE; }
 
 // Component setup
-void NotionDatabase::setup() {}
+void NotionDatabase::setup() {
+  if (source_ != nullptr) {
+    source_->add_on_pages_changed_callback([this]() { this->apply_source_(); });
+    return;
+  }
+  if (snapshot_store_.is_enabled()) {
+    restore_snapshot_();
+  }
+  if (adaptive_polling_.is_enabled()) {
+    // The poll timer replaces the update interval; update() still fetches on demand
+    this->set_update_interval(SCHEDULER_DONT_RUN);
+    schedule_poll_(FIRST_POLL_DELAY);
+  }
+  if (async_fetch_ &&
+      !fetch_task_.start("notion_fetch", fetch_task_stack_size_, fetch_task_core_,
+                         [this]() { this->execute_request_(this->request_, *this->async_result_); })) {
+    ESP_LOGW(TAG, "Falling back to fetching on the main loop");
+  }
+}
 
 // Periodic update
 void NotionDatabase::update() {
+  // The pages restored on boot may be recent enough to show without asking Notion; page flips skip this
+  if (snapshot_restored_) {
+    snapshot_restored_ = false;
+    if (is_snapshot_fresh_(now_epoch_())) {
+      return;
+    }
+  }
+  request_fetch_(FetchMode::PAGE, true);
+}
+
+// Returns the bit of a fetch mode in a set of modes
+static uint8_t fetch_mode_bit(FetchMode mode) { return 1u << static_cast<uint8_t>(mode); }
+
+// Queues a fetch; the mode travels with the request, and each mode is waiting at most once
+void NotionDatabase::request_fetch_(FetchMode mode, bool poll) {
+  // Pages come from the source database
+  if (source_ != nullptr) {
+    apply_source_();
+    return;
+  }
+
+  // The request is sent again once the Retry-After time has passed
+  if (retry_pending_ && static_cast<int32_t>(millis() - retry_at_) < 0) {
+    ESP_LOGD(TAG, "Rate limited, skipping update");
+    return;
+  }
+
   // Validate configuration before proceeding
   if (!validate_config_()) {
     ESP_LOGE(TAG, "Configuration validation failed");
     return;
   }
 
-  // Send request and update status
-  if (send_request_()) {
+  // The next page is already on its way
+  if (mode != FetchMode::PAGE && is_fetching() && request_.mode == mode) {
+    return;
+  }
+  // A poll merged into a page flip already waiting still counts as a poll
+  poll_waiting_ = poll_waiting_ || poll;
+  if (waiting_modes_ & fetch_mode_bit(mode)) {
+    ESP_LOGV(TAG, "Fetch already queued");
+    return;
+  }
+  waiting_modes_ |= fetch_mode_bit(mode);
+
+  if (scheduler_ != nullptr) {
+    scheduler_->submit(this, mode);
+    return;
+  }
+  fetch(mode);
+}
+
+// Send the query now
+void NotionDatabase::fetch(FetchMode mode) {
+  waiting_modes_ &= ~fetch_mode_bit(mode);
+  if ((mode == FetchMode::APPEND || mode == FetchMode::PREFETCH) && (!has_more_ || next_cursor_.empty())) {
+    ESP_LOGD(TAG, "No next page to fetch");
+    return;
+  }
+  if (fetch_task_.is_started()) {
+    start_async_fetch_(mode);
+    return;
+  }
+  QueryResult result(page_store_placement_);
+  bool success = send_request_(mode, result);
+  finish_fetch_(success, result.outdated);
+}
+
+// Updates the status after a fetch
+void NotionDatabase::finish_fetch_(bool success, bool outdated) {
+  // Only scheduled polls move the polling schedule; page flips, appends and prefetches leave it
+  // alone, and so does a response dropped because the state changed while it was in flight. After
+  // a 429 response the retry timer sends the next request.
+  if (adaptive_polling_.is_enabled() && request_.poll && !outdated && !retry_pending_) {
+    schedule_poll_(success ? adaptive_polling_.on_success(has_page_change_flag_) : adaptive_polling_.on_failure());
+  }
+  if (request_.mode == FetchMode::APPEND || success) {
+    load_more_failed_ = !success;
+  }
+  if (success) {
+    consecutive_failures_ = 0;
     this->status_clear_warning();
-  } else {
-    this->status_set_warning();
+    return;
   }
+  consecutive_failures_++;
+  this->status_set_warning();
+  fetch_callback_.call(fetch_stats_, false);
+}
+
+// Schedules the next adaptive poll, replacing the pending one
+void NotionDatabase::schedule_poll_(uint32_t delay) {
+  ESP_LOGD(TAG, "Next poll in %us", delay / 1000);
+  this->set_timeout("poll", delay, [this]() { this->poll_(); });
+}
+
+// Fetches unless within quiet hours
+void NotionDatabase::poll_() {
+#ifdef USE_TIME
+  if (time_ != nullptr && adaptive_polling_.has_quiet_hours()) {
+    ESPTime now = time_->now();
+    uint32_t quiet_delay =
+        now.is_valid() ? adaptive_polling_.get_quiet_delay(now.hour * 3600 + now.minute * 60 + now.second) : 0;
+    if (quiet_delay > 0) {
+      ESP_LOGD(TAG, "Quiet hours, skipping poll");
+      schedule_poll_(quiet_delay);
+      return;
+    }
+  }
+#endif
+  // Until the first pages arrive, a network still coming up is waited for rather than counted as a failure
+  if (pages_hash_ == 0 && !network::is_connected()) {
+    schedule_poll_(FIRST_POLL_DELAY);
+    return;
+  }
+  // The age of a restored snapshot is waited for until the clock is set, which happens soon after
+  // the network comes up; once max_age has passed since boot the snapshot is stale anyway
+  if (snapshot_restored_ && now_epoch_() == 0 && millis() / 1000 < snapshot_max_age_) {
+    schedule_poll_(FIRST_POLL_DELAY);
+    return;
+  }
+  // Replaced once the fetch finishes; keeps polling if update() sends nothing
+  schedule_poll_(adaptive_polling_.get_interval());
+  update();
 }
 
 // Debug configuration
 void NotionDatabase::dump_config() {
   ESP_LOGCONFIG(TAG, "Notion Database:");
   ESP_LOGCONFIG(TAG, "  API Token: %s", api_token_.value().empty() ? "not set" : "set");
+  if (source_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Source: %s", source_->database_id_.value().c_str());
+    ESP_LOGCONFIG(TAG, "  Local Filter Conditions: %u", local_query_.get_condition_count());
+    ESP_LOGCONFIG(TAG, "  Local Sorts: %u", local_query_.get_sort_count());
+    return;
+  }
+  ESP_LOGCONFIG(TAG, "  Base URL: %s", base_url_.c_str());
   ESP_LOGCONFIG(TAG, "  Database ID: %s", database_id_.value().c_str());
   ESP_LOGCONFIG(TAG, "  Query: %s", query_.value().c_str());
   ESP_LOGCONFIG(TAG, "  Watchdog Timeout: %u", watchdog_timeout_.value());
   ESP_LOGCONFIG(TAG, "  HTTP Connect Timeout: %u", http_connect_timeout_.value());
   ESP_LOGCONFIG(TAG, "  HTTP Timeout: %u", http_timeout_.value());
+  if (scheduler_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Connection: shared by hub");
+  } else {
+    ESP_LOGCONFIG(TAG, "  Keep Alive: %s", YESNO(session_.get_keep_alive()));
+    if (session_.get_keep_alive()) {
+      ESP_LOGCONFIG(TAG, "  Keep Alive Timeout: %u", session_.get_idle_timeout());
+    }
+  }
+  ESP_LOGCONFIG(TAG, "  Incremental Sync: %s", YESNO(incremental_sync_));
+  if (incremental_sync_) {
+    ESP_LOGCONFIG(TAG, "  Full Sync Interval: %u", full_sync_interval_);
+  }
+  if (page_cache_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Page Cache: %u entries", page_cache_.size());
+  }
+  if (snapshot_store_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Snapshot: max %u bytes, write delay %ums, max age %us", snapshot_max_size_,
+                  snapshot_write_delay_, snapshot_max_age_);
+  }
+  if (adaptive_polling_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Adaptive Polling: %us to %us, backoff factor %.1f",
+                  adaptive_polling_.get_min_interval() / 1000, adaptive_polling_.get_max_interval() / 1000,
+                  adaptive_polling_.get_backoff_factor());
+  }
+  ESP_LOGCONFIG(TAG, "  Async Fetch: %s", YESNO(fetch_task_.is_started()));
+  if (fetch_task_.is_started()) {
+    ESP_LOGCONFIG(TAG, "  Fetch Task Stack Size: %u, Core: %d", fetch_task_stack_size_, fetch_task_core_);
+  }
   ESP_LOGCONFIG(TAG, "  JSON Parser Buffer Size: %u", json_parse_buffer_size_.value());
+  ESP_LOGCONFIG(TAG, "  JSON Parser Buffer Placement: %s", memory_placement_to_string(json_parse_buffer_placement_));
+  ESP_LOGCONFIG(TAG, "  Page Store Placement: %s", memory_placement_to_string(page_store_placement_));
+  ESP_LOGCONFIG(TAG, "  Cache Placement: %s", memory_placement_to_string(cache_placement_));
+  ESP_LOGCONFIG(TAG, "  Memory Usage:");
+  ESP_LOGCONFIG(TAG, "    Internal: %u free of %u, max block %u", heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                heap_caps_get_total_size(MALLOC_CAP_INTERNAL), heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+  ESP_LOGCONFIG(TAG, "    PSRAM: %u free of %u, max block %u", heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                heap_caps_get_total_size(MALLOC_CAP_SPIRAM), heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+  ESP_LOGCONFIG(TAG, "    Page Store: %u bytes, JSON Parse Buffer: %u bytes", pages_->memory_usage(), arena_.capacity());
+  ESP_LOGCONFIG(TAG, "    Allocations outside preferred heap: %u", placed_fallback_count());
   ESP_LOGCONFIG(TAG, "  Supported Property Types:");
   for (const auto &type : supported_property_types_) {
     ESP_LOGCONFIG(TAG, "    - %s", notion_property_type_to_string(type).c_str());
@@ -91,374 +320,1237 @@ bool NotionDatabase::validate_config_() {
   return true;
 }
 
-// Send HTTP request
-bool NotionDatabase::send_request_() {
+// Send HTTP request and apply the response
+bool NotionDatabase::send_request_(FetchMode mode, QueryResult &result) {
+  if (!prepare_request_(mode, request_, result)) {
+    return false;
+  }
+  watchdog::WatchdogManager wdm(this->watchdog_timeout_.value());
+  execute_request_(request_, result);
+  return apply_result_(request_, result);
+}
+
+// Start a request on the fetch task; the response is applied by loop()
+void NotionDatabase::start_async_fetch_(FetchMode mode) {
+  if (!fetch_task_.is_idle()) {
+    ESP_LOGD(TAG, "Fetch in progress, fetching again when it finishes");
+    waiting_modes_ |= fetch_mode_bit(mode);
+    return;
+  }
+  async_result_.reset(new QueryResult(page_store_placement_));
+  if (!prepare_request_(mode, request_, *async_result_)) {
+    async_result_.reset();
+    finish_fetch_(false);
+    return;
+  }
+  fetch_task_.run();
+}
+
+void NotionDatabase::loop() {
+  if (!fetch_task_.take_finished()) {
+    return;
+  }
+  bool success = apply_result_(request_, *async_result_);
+  finish_fetch_(success, async_result_->outdated);
+  async_result_.reset();
+  // Fetches requested while this one was in flight; all but the first wait again
+  uint8_t waiting = waiting_modes_;
+  waiting_modes_ = 0;
+  for (FetchMode mode : {FetchMode::PAGE, FetchMode::APPEND, FetchMode::PREFETCH}) {
+    if (waiting & fetch_mode_bit(mode)) {
+      request_fetch_(mode);
+    }
+  }
+}
+
+// Captures everything the request needs on the main loop, so that it can run on another task
+bool NotionDatabase::prepare_request_(FetchMode mode, QueryRequest &request, QueryResult &result) {
+  // Incremental syncs are first page requests too
+  request.poll = mode == FetchMode::PAGE && poll_waiting_;
+  if (mode == FetchMode::PAGE) {
+    poll_waiting_ = false;
+  }
+  // Only the first page of results is kept in sync incrementally
+  if (mode == FetchMode::PAGE && incremental_sync_ && !full_sync_pending_ && current_cursor_.empty() &&
+      pages_hash_ != 0 && !sync_watermark_.empty() && millis() - last_full_sync_ < full_sync_interval_) {
+    mode = FetchMode::INCREMENTAL;
+  }
+  request.mode = mode;
+
   if (!network::is_connected()) {
     ESP_LOGW(TAG, "Network not connected");
     return false;
   }
 
-  watchdog::WatchdogManager wdm(this->watchdog_timeout_.value());
-  std::string url = "https://api.notion.com/v1/databases/" + database_id_.value() + "/query";
-
-  HTTPClient http;
-  http.begin(url.c_str());
-  http.useHTTP10(true);
-  http.setConnectTimeout(http_connect_timeout_.value());
-  http.setTimeout(http_timeout_.value());
-  http.addHeader("Authorization", ("Bearer " + api_token_.value()).c_str());
-  http.addHeader("Notion-Version", "2022-06-28");
-  http.addHeader("Content-Type", "application/json");
-
-  std::string payload = query_.value();
-  if (!current_cursor_.empty()) {
-    if (!add_pagination_cursor_to_query_(payload)) {
+  request.generation = generation_;
+  request.url = base_url_ + "/v1/databases/" + database_id_.value() + "/query";
+  request.api_token = api_token_.value();
+  request.payload = query_.value();
+  request.cursor = mode == FetchMode::APPEND || mode == FetchMode::PREFETCH ? next_cursor_ : current_cursor_;
+  if (!request.cursor.empty()) {
+    if (!add_pagination_cursor_to_query_(request.payload, request.cursor)) {
       ESP_LOGE(TAG, "Failed to add pagination cursor to query");
       return false;
     }
   }
-  ESP_LOGD(TAG, "Sending query: %s", payload.c_str());
+  if (mode == FetchMode::INCREMENTAL) {
+    if (!add_watermark_to_query_(request.payload)) {
+      ESP_LOGE(TAG, "Failed to add sync watermark to query");
+      return false;
+    }
+  }
+  request.connect_timeout = http_connect_timeout_.value();
+  request.timeout = http_timeout_.value();
+  request.property_filters = property_filters_;
+  request.page_filter = get_page_filter_();
+
+  if (arena_.capacity() != json_parse_buffer_size_.value() || arena_.placement() != json_parse_buffer_placement_) {
+    if (!arena_.init(json_parse_buffer_size_.value(), json_parse_buffer_placement_)) {
+      ESP_LOGW(TAG, "Failed to allocate %u bytes for the JSON parse buffer", json_parse_buffer_size_.value());
+    }
+  }
 
-  ESP_LOGD(TAG, "Before request: free heap:%u, max block:%u", ESP.getFreeHeap(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
-  App.feed_wdt();
-  int http_code = http.POST(payload.c_str());
-  ESP_LOGD(TAG, "After request: free heap:%u, max block:%u", ESP.getFreeHeap(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
+  // Symbols are only ever added, so the stored pages can be drawn while the response interns new ones
+  result.symbols = symbols_;
+  result.watermark = sync_watermark_;
+  return true;
+}
 
-  // Process successful HTTP response
-  if (http_code == HTTP_CODE_OK) {
-    App.feed_wdt();
-    std::vector<Page, Allocator<Page>> new_pages;
-    uint32_t new_pages_hash = process_response_(http.getStream(), http.getSize(), new_pages);
-    http.end();
-    // Check for changes if parsing was successful
-    if (new_pages_hash != 0) {
-      check_changes_(new_pages, new_pages_hash);
+// Sends the request and parses the response; touches nothing but the request, the result, the
+// connection and the JSON parse buffer
+void NotionDatabase::execute_request_(const QueryRequest &request, QueryResult &result) {
+  ESP_LOGD(TAG, "Sending query: %s", request.payload.c_str());
+
+  HttpSession &session = scheduler_ != nullptr ? scheduler_->get_session() : session_;
+  session.set_connect_timeout(request.connect_timeout);
+  session.set_timeout(request.timeout);
+
+  log_heap_("Before request");
+  feed_wdt();
+  uint32_t start = micros();
+  result.http_code = session.post(request.url, request.api_token, request.payload);
+  result.stats.mode = request.mode;
+  result.stats.connect_us = session.get_connect_us();
+  result.stats.request_us = micros() - start - result.stats.connect_us;
+  log_heap_("After request");
+
+  if (result.http_code != HTTP_CODE_OK) {
+    if (result.http_code == HTTP_CODE_TOO_MANY_REQUESTS) {
+      result.retry_after = parse_retry_after(session.get_header("Retry-After").c_str());
     }
-    ESP_LOGD(TAG, "After json parse: free heap:%u, max block:%u", ESP.getFreeHeap(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL));
-    return true;
-  } else {
+    result.error = session.get_string().c_str();
+    session.end(false);
+    return;
+  }
+
+  feed_wdt();
+  result.pages.set_symbols(result.symbols);
+  start = micros();
+  result.stats.heap_free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  result.stats.heap_free_min = result.stats.heap_free_before;
+  result.pages_hash = process_response_(session.get_stream(), session.get_size(), request, result);
+  result.stats.parse_us = micros() - start - result.stats.first_byte_us;
+  session.end(result.pages_hash != 0);
+  result.stats.pages = result.pages.size();
+  result.stats.page_store_bytes = result.pages.memory_usage();
+  result.stats.parse_buffer_peak = arena_.peak();
+  result.stats.parse_buffer_fallbacks = arena_.fallback_count();
+
+  ESP_LOGD(TAG, "JSON parse buffer: peak %u of %u bytes, %u allocations spilled to heap", arena_.peak(),
+           arena_.capacity(), arena_.fallback_count());
+  if (arena_.fallback_count() > 0) {
+    ESP_LOGW(TAG, "JSON parse buffer too small, consider increasing json_parse_buffer_size");
+  }
+  // Everything parsed from this response is released at once
+  arena_.reset();
+  log_heap_("After json parse");
+}
+
+// Applies a parsed response to the stored pages and pagination state
+bool NotionDatabase::apply_result_(const QueryRequest &request, QueryResult &result) {
+  if (result.http_code == HTTP_CODE_TOO_MANY_REQUESTS) {
+    ESP_LOGW(TAG, "Rate limited, retrying in %u s", result.retry_after);
+    handle_rate_limit_(result.retry_after);
+    return false;
+  }
+  if (result.http_code != HTTP_CODE_OK) {
     // Handle HTTP request failure
-    ESP_LOGE(TAG, "HTTP request failed, code: %d, error: %s", http_code, http.getString().c_str());
-    http.end();
+    ESP_LOGE(TAG, "HTTP request failed, code: %d, error: %s", result.http_code, result.error.c_str());
     return false;
   }
+  if (result.pages_hash == 0) {
+    return false;
+  }
+
+  // The state may have changed while an asynchronous request was in flight; a prefetched page
+  // is still worth caching after the user has moved on
+  bool outdated = request.generation != generation_;
+  if (request.mode == FetchMode::APPEND) {
+    outdated = outdated || request.cursor != next_cursor_;
+  } else if (request.mode != FetchMode::PREFETCH) {
+    outdated = outdated || request.cursor != current_cursor_;
+  }
+  if (outdated) {
+    ESP_LOGD(TAG, "Discarding the response to an outdated request");
+    result.outdated = true;
+    return true;
+  }
+
+  uint32_t start = micros();
+  PageTable &new_pages = result.pages;
+  available_properties_.insert(result.available_properties.begin(), result.available_properties.end());
+  uint32_t new_pages_hash = result.pages_hash;
+
+  switch (request.mode) {
+    case FetchMode::PREFETCH:
+      ESP_LOGD(TAG, "Prefetched %zu pages", new_pages.size());
+      page_cache_.put(page_cache_key_(request.cursor), std::move(new_pages), new_pages_hash, result.has_more,
+                      result.has_more ? result.next_cursor : "");
+      break;
+
+    case FetchMode::APPEND:
+      has_more_ = result.has_more;
+      next_cursor_ = result.has_more ? result.next_cursor : "";
+      ESP_LOGD(TAG, "Pagination: Appended, has more: %s", has_more_ ? "true" : "false");
+      sync_watermark_ = result.watermark;
+      append_pages_(new_pages);
+      break;
+
+    case FetchMode::INCREMENTAL:
+      // The edited pages did not fit in one response; fetch the whole view next time
+      if (result.has_more) {
+        ESP_LOGD(TAG, "Incremental sync: more edited pages than page_size, scheduling a full sync");
+        full_sync_pending_ = true;
+      }
+      ESP_LOGD(TAG, "Incremental sync: %zu pages edited since %s", new_pages.size(), sync_watermark_.c_str());
+      sync_watermark_ = result.watermark;
+      merge_pages_(new_pages);
+      cache_current_page_();
+      schedule_snapshot_();
+      break;
+
+    case FetchMode::PAGE: {
+      // The current cursor was moved by the page flip that sent the request; a response to any
+      // other cursor was discarded above. Rows appended since leave the next cursor past them.
+      if (!has_appended_rows_) {
+        has_more_ = result.has_more;
+        next_cursor_ = result.has_more ? result.next_cursor : "";
+      }
+      if (!current_cursor_.empty()) {
+        ESP_LOGD(TAG, "Pagination: Currnet cursor: %s", current_cursor_.c_str());
+      }
+      ESP_LOGD(TAG, "Pagination: Has more: %s", has_more_ ? "true" : "false");
+      if (has_more_) {
+        ESP_LOGD(TAG, "Pagination: Next cursor: %s", next_cursor_.c_str());
+      }
+
+      sync_watermark_ = result.watermark;
+      if (incremental_sync_ && current_cursor_.empty()) {
+        full_sync_pending_ = false;
+        last_full_sync_ = millis();
+      }
+      if (has_appended_rows_) {
+        keep_appended_rows_(new_pages, new_pages_hash);
+      } else {
+        base_rows_ = new_pages.size();
+      }
+      check_changes_(new_pages, new_pages_hash);
+      // The page was fetched anyway, so this also revalidates a page shown from the cache
+      cache_current_page_();
+      schedule_prefetch_();
+      schedule_snapshot_();
+      break;
+    }
+  }
+
+  fetch_stats_ = result.stats;
+  fetch_stats_.apply_us = micros() - start;
+  fetch_stats_.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  log_fetch_stats_();
+  fetch_callback_.call(fetch_stats_, true);
+  return true;
+}
+
+// Returns a hash of what the pages depend on, so that a snapshot of another query is not shown
+uint32_t NotionDatabase::snapshot_config_hash_() {
+  uint32_t hash = fnv1a_hash(base_url_.c_str());
+  hash = fnv1a_hash(database_id_.value().c_str(), hash);
+  hash = fnv1a_hash(query_.value().c_str(), hash);
+  for (const auto &property : property_filters_) {
+    hash = fnv1a_hash(property.c_str(), hash);
+  }
+  return hash;
+}
+
+// Shows the pages saved before the last reboot or deep sleep until the first fetch replaces them
+void NotionDatabase::restore_snapshot_() {
+  std::vector<uint8_t> data;
+  if (!snapshot_store_.load(data)) {
+    ESP_LOGD(TAG, "No snapshot to restore");
+    return;
+  }
+  uint32_t saved_at = 0;
+  if (!load_snapshot(data.data(), data.size(), &saved_at)) {
+    snapshot_store_.erase();
+    return;
+  }
+  // Unchanged pages only update the time they were checked at
+  uint32_t checked_at = 0;
+  if (snapshot_store_.load_checked_at(checked_at) && checked_at > saved_at) {
+    saved_at = checked_at;
+  }
+  snapshot_pages_hash_ = pages_hash_;
+  snapshot_checked_at_ = saved_at;
+  // The clock is rarely set this early in boot, so the first poll decides whether it fetches
+  snapshot_restored_ = snapshot_max_age_ > 0 && saved_at != 0;
+}
+
+// Returns whether the restored snapshot is younger than max_age; false until the clock is set
+bool NotionDatabase::is_snapshot_fresh_(uint32_t now) {
+  if (now == 0 || snapshot_checked_at_ == 0) {
+    ESP_LOGD(TAG, "Clock not set, fetching over the snapshot");
+    return false;
+  }
+  uint32_t age = now >= snapshot_checked_at_ ? now - snapshot_checked_at_ : 0;
+  if (age >= snapshot_max_age_) {
+    ESP_LOGD(TAG, "Snapshot is %us old, fetching", age);
+    return false;
+  }
+  ESP_LOGD(TAG, "Snapshot is %us old, skipping the first poll", age);
+  return true;
+}
+
+// Returns the seconds since epoch from the time component when there is one, else from the system
+// clock; 0 until the clock has been set
+uint32_t NotionDatabase::now_epoch_() {
+#ifdef USE_TIME
+  if (time_ != nullptr) {
+    ESPTime now = time_->now();
+    return now.is_valid() ? static_cast<uint32_t>(now.timestamp) : 0;
+  }
+#endif
+  return current_epoch();
+}
+
+bool NotionDatabase::load_snapshot(const uint8_t *data, size_t size, uint32_t *saved_at) {
+  if (source_ != nullptr) {
+    return false;
+  }
+  uint32_t start = micros();
+  SnapshotState state;
+  PageTable pages(page_store_placement_);
+  auto symbols = std::make_shared<SymbolTable>();
+  if (!SnapshotCodec::decode(data, size, state, pages, symbols)) {
+    return false;
+  }
+  if (state.config_hash != snapshot_config_hash_()) {
+    ESP_LOGW(TAG, "Snapshot was saved for another query, ignoring it");
+    return false;
+  }
+
+  // Like a response to the first page; a request in flight is discarded
+  generation_++;
+  page_cache_.clear();
+  current_cursor_.clear();
+  previous_cursors_.clear();
+  has_appended_rows_ = false;
+  evicted_rows_ = 0;
+  symbols_ = symbols;
+  available_properties_ = state.available_properties;
+  has_more_ = state.has_more;
+  next_cursor_ = state.next_cursor;
+  sync_watermark_ = state.watermark;
+  size_t count = pages.size();
+  check_changes_(pages, state.pages_hash);
+  if (saved_at != nullptr) {
+    *saved_at = state.saved_at;
+  }
+  ESP_LOGI(TAG, "Loaded %zu pages from a %u byte snapshot in %uus", count, size, micros() - start);
+  return true;
+}
+
+bool NotionDatabase::save_snapshot(std::vector<uint8_t> &data) {
+  if (source_ != nullptr || !current_cursor_.empty() || has_appended_rows_ || pages_hash_ == 0) {
+    ESP_LOGD(TAG, "No first page of results to save");
+    return false;
+  }
+  SnapshotState state;
+  state.config_hash = snapshot_config_hash_();
+  state.saved_at = now_epoch_();
+  state.pages_hash = pages_hash_;
+  state.has_more = has_more_;
+  state.next_cursor = next_cursor_;
+  state.watermark = sync_watermark_;
+  state.available_properties = available_properties_;
+  if (!SnapshotCodec::encode(state, *pages_, data, snapshot_max_size_)) {
+    ESP_LOGW(TAG, "Snapshot of %zu pages exceeds %u bytes", pages_->size(), snapshot_max_size_);
+    return false;
+  }
+  return true;
+}
+
+// Saves the first page of results after a fetch, once the pages have settled
+void NotionDatabase::schedule_snapshot_() {
+  if (!snapshot_store_.is_enabled() || snapshot_pending_ || !current_cursor_.empty() || has_appended_rows_) {
+    return;
+  }
+  if (!has_page_change_flag_) {
+    save_snapshot_checked_at_();
+    return;
+  }
+  snapshot_pending_ = true;
+  this->set_timeout("snapshot", snapshot_write_delay_, [this]() { this->save_snapshot_(); });
+}
+
+void NotionDatabase::save_snapshot_() {
+  snapshot_pending_ = false;
+  uint32_t start = micros();
+  std::vector<uint8_t> data;
+  // The user may have paged away since the snapshot was scheduled
+  if (save_snapshot(data) && snapshot_store_.save(data)) {
+    snapshot_pages_hash_ = pages_hash_;
+    snapshot_checked_at_ = now_epoch_();
+    ESP_LOGD(TAG, "Saved snapshot of %zu pages, %u bytes in %uus", pages_->size(), data.size(), micros() - start);
+  }
+}
+
+// Records that the saved pages are still current, which decides whether the next boot fetches
+void NotionDatabase::save_snapshot_checked_at_() {
+  uint32_t now = now_epoch_();
+  if (snapshot_max_age_ == 0 || now == 0 || pages_hash_ != snapshot_pages_hash_) {
+    return;
+  }
+  // Within half of max_age the next boot still finds the snapshot fresh, one flash write later
+  if (now >= snapshot_checked_at_ && now - snapshot_checked_at_ < snapshot_max_age_ / 2) {
+    return;
+  }
+  if (snapshot_store_.save_checked_at(now)) {
+    snapshot_checked_at_ = now;
+  }
+}
+
+void NotionDatabase::on_shutdown() {
+  if (snapshot_pending_) {
+    this->cancel_timeout("snapshot");
+    save_snapshot_();
+  }
+}
+
+// Holds back requests until the time the API asked for has passed, then sends the request again
+void NotionDatabase::handle_rate_limit_(uint32_t retry_after) {
+  uint32_t delay = retry_after * 1000;
+  retry_at_ = millis() + delay;
+  retry_pending_ = true;
+  if (scheduler_ != nullptr) {
+    // The limit applies to the integration, so the other databases of the hub wait too
+    scheduler_->pause(delay);
+  }
+  this->set_timeout("retry", delay, [this]() {
+    this->retry_pending_ = false;
+    this->update();
+  });
+}
+
+// Logs the stats of the last fetch as key=value pairs, so they can be collected from the logs
+void NotionDatabase::log_fetch_stats_() {
+  const FetchStats &stats = fetch_stats_;
+  uint32_t pages_per_s = stats.parse_us > 0 ? static_cast<uint64_t>(stats.pages) * 1000000 / stats.parse_us : 0;
+  ESP_LOGD(TAG,
+           "Fetch stats: mode=%s connect_us=%u request_us=%u first_byte_us=%u parse_us=%u apply_us=%u "
+           "response_bytes=%u pages=%u pages_per_s=%u store_bytes=%u buffer_peak=%u buffer_fallbacks=%u "
+           "heap_used_peak=%u largest_free_block=%u heap_fallbacks=%u",
+           fetch_mode_to_string(stats.mode), stats.connect_us, stats.request_us, stats.first_byte_us,
+           stats.parse_us, stats.apply_us, stats.response_bytes,
+           stats.pages, pages_per_s, stats.page_store_bytes, stats.parse_buffer_peak, stats.parse_buffer_fallbacks,
+           stats.heap_used_peak(), stats.largest_free_block, placed_fallback_count());
 }
 
-bool NotionDatabase::add_pagination_cursor_to_query_(std::string &payload) {
+bool NotionDatabase::add_pagination_cursor_to_query_(std::string &payload, const std::string &cursor) {
   JsonDocument doc;
   if (deserializeJson(doc, payload) != DeserializationError::Ok) {
     ESP_LOGE(TAG, "Failed to parse query JSON for adding pagination cursor");
     return false;
   }
 
-  doc["start_cursor"] = current_cursor_;
+  doc["start_cursor"] = cursor;
+
+  payload.clear();
+  serializeJson(doc, payload);
+  return true;
+}
+
+// Restricts the query to pages edited on or after the sync watermark
+bool NotionDatabase::add_watermark_to_query_(std::string &payload) {
+  JsonDocument doc;
+  if (!payload.empty() && deserializeJson(doc, payload) != DeserializationError::Ok) {
+    ESP_LOGE(TAG, "Failed to parse query JSON for adding sync watermark");
+    return false;
+  }
+
+  JsonDocument watermark;
+  watermark["timestamp"] = "last_edited_time";
+  watermark["last_edited_time"]["on_or_after"] = sync_watermark_;
+
+  if (doc["filter"].isNull()) {
+    doc["filter"] = watermark;
+  } else {
+    JsonDocument filter;
+    JsonArray conditions = filter["and"].to<JsonArray>();
+    conditions.add(doc["filter"]);
+    conditions.add(watermark);
+    doc["filter"] = filter;
+  }
 
   payload.clear();
   serializeJson(doc, payload);
   return true;
 }
 
+// Size of the bookkeeping header placed in front of every JSON allocation
+static constexpr size_t JSON_ALLOC_HEADER = alignof(std::max_align_t);
+static_assert(JSON_ALLOC_HEADER >= sizeof(size_t), "JSON allocation header too small");
+
+// Routes ArduinoJson allocations through the response arena
 struct JsonAllocator : ArduinoJson::Allocator {
-  void *allocate(size_t n) override { return ALLOCATOR.allocate(n); }
+  explicit JsonAllocator(ArenaAllocator *arena) : arena(arena) {}
 
-  void deallocate(void *p) override { ALLOCATOR.deallocate(static_cast<uint8_t *>(p), 0); }
+  void *allocate(size_t n) override {
+    uint8_t *base = static_cast<uint8_t *>(arena->allocate(n + JSON_ALLOC_HEADER));
+    if (base == nullptr) return nullptr;
+    *reinterpret_cast<size_t *>(base) = n;
+    return base + JSON_ALLOC_HEADER;
+  }
+
+  void deallocate(void *p) override {
+    if (p == nullptr) return;
+    uint8_t *base = static_cast<uint8_t *>(p) - JSON_ALLOC_HEADER;
+    arena->deallocate(base, *reinterpret_cast<size_t *>(base) + JSON_ALLOC_HEADER);
+  }
 
   void *reallocate(void *p, size_t new_size) override {
-    return ALLOCATOR.reallocate(static_cast<uint8_t *>(p), new_size, MALLOC_CAP_SPIRAM);
+    if (p == nullptr) return allocate(new_size);
+    uint8_t *base = static_cast<uint8_t *>(p) - JSON_ALLOC_HEADER;
+    size_t old_size = *reinterpret_cast<size_t *>(base);
+    base = static_cast<uint8_t *>(arena->reallocate(base, old_size + JSON_ALLOC_HEADER, new_size + JSON_ALLOC_HEADER));
+    if (base == nullptr) return nullptr;
+    *reinterpret_cast<size_t *>(base) = new_size;
+    return base + JSON_ALLOC_HEADER;
   }
+
+  ArenaAllocator *arena;
 };
 
-// Process HTTP response
-uint32_t NotionDatabase::process_response_(Stream &stream, size_t content_size,
-                                           std::vector<Page, Allocator<Page>> &new_pages) {
-  StreamMonitor stream_monitor(stream);
+// Adds the value subtree that parse_page_ reads for a property type
+static void add_property_value_filter(JsonObject prop, NotionPropertyType type) {
+  switch (type) {
+    case NotionPropertyType::TITLE:
+      prop["title"][0]["plain_text"] = true;
+      break;
+    case NotionPropertyType::RICH_TEXT:
+      prop["rich_text"][0]["plain_text"] = true;
+      break;
+    case NotionPropertyType::NUMBER:
+      prop["number"] = true;
+      break;
+    case NotionPropertyType::DATE:
+      prop["date"]["start"] = true;
+      break;
+    case NotionPropertyType::CHECKBOX:
+      prop["checkbox"] = true;
+      break;
+    case NotionPropertyType::SELECT:
+      prop["select"]["name"] = true;
+      break;
+    case NotionPropertyType::MULTI_SELECT:
+      prop["multi_select"][0]["name"] = true;
+      break;
+    case NotionPropertyType::STATUS:
+      prop["status"]["name"] = true;
+      break;
+    case NotionPropertyType::URL:
+      prop["url"] = true;
+      break;
+    case NotionPropertyType::EMAIL:
+      prop["email"] = true;
+      break;
+    case NotionPropertyType::PHONE_NUMBER:
+      prop["phone_number"] = true;
+      break;
+    case NotionPropertyType::CREATED_TIME:
+      prop["created_time"] = true;
+      break;
+    case NotionPropertyType::LAST_EDITED_TIME:
+      prop["last_edited_time"] = true;
+      break;
+    default:
+      break;
+  }
+}
 
-  auto free_heap = ALLOCATOR.get_max_free_block_size();
-  ESP_LOGD(TAG, "Content Size: %d, Free heap: %u, JSON Parse Buffer Size: %u", content_size, free_heap,
-           json_parse_buffer_size_.value());
+// Builds the filter applied to each results[i] object.
+//
+// Only the fields used for hashing, the wanted basic properties and the value subtrees of
+// supported property types are kept. When property filters are set, other properties keep
+// just their "type" so that available_properties_ still lists them.
+const JsonDocument &NotionDatabase::get_page_filter_() {
+  if (!page_filter_.isNull()) {
+    return page_filter_;
+  }
 
-  size_t doc_size =
-      std::min({static_cast<size_t>(free_heap - 2048), static_cast<size_t>(json_parse_buffer_size_.value()),
-                content_size > 0 ? static_cast<size_t>(content_size * 1.5f) : SIZE_MAX});
+  auto is_wanted = [this](const std::string &name) {
+    return property_filters_.empty() || property_filters_.count(name) > 0;
+  };
+
+  page_filter_["id"] = true;
+  page_filter_["last_edited_time"] = true;
+  if (is_wanted(NOTION_CREATED_TIME_KEY)) page_filter_["created_time"] = true;
+  if (is_wanted(NOTION_ARCHIVED_KEY)) page_filter_["archived"] = true;
+  if (is_wanted(NOTION_IN_TRASH_KEY)) page_filter_["in_trash"] = true;
+
+  JsonObject properties = page_filter_["properties"].to<JsonObject>();
+  JsonObject any_prop = properties["*"].to<JsonObject>();
+  any_prop["type"] = true;
+  if (property_filters_.empty()) {
+    for (auto type : supported_property_types_) {
+      add_property_value_filter(any_prop, type);
+    }
+  } else {
+    for (const auto &name : property_filters_) {
+      JsonObject prop = properties[name].to<JsonObject>();
+      prop["type"] = true;
+      for (auto type : supported_property_types_) {
+        add_property_value_filter(prop, type);
+      }
+    }
+  }
 
-  ESP_LOGD(TAG, "Allocating %u bytes for JSON document", doc_size);
+#if ESP_LOG_LEVEL >= ESP_LOG_VERBOSE
+  std::string filter_json;
+  serializeJson(page_filter_, filter_json);
+  ESP_LOGV(TAG, "Page filter: %s", filter_json.c_str());
+#endif
+  return page_filter_;
+}
 
-  if (doc_size < json_parse_buffer_size_.value() / 2) {
-    ESP_LOGW(TAG,
-             "Calculated JSON document size is significantly smaller than configured buffer size. "
-             "Consider reducing json_parse_buffer_size or increasing available heap.");
+// Discards a value without building it
+static const JsonDocument &skip_filter() {
+  static JsonDocument filter;
+  if (filter.isNull()) {
+    filter.set(false);
   }
+  return filter;
+}
 
-  static JsonAllocator allocator;
-  JsonDocument doc(&allocator);
-  DeserializationError error = deserializeJson(doc, stream_monitor);
-  ESP_LOGD(TAG, "Stream read bytes: %u", stream_monitor.get_bytes_read());
-  if (error) {
-    ESP_LOGE(TAG, "JSON parsing failed: %s", error.c_str());
-    doc.clear();
-    return 0;
+// Reads an object key up to its closing quote; the opening quote must already be consumed
+static bool read_json_key(StreamMonitor &stream, std::string &key) {
+  key.clear();
+  char c;
+  while (stream.readBytes(&c, 1) == 1) {
+    if (c == '"') return true;
+    if (c == '\\') {
+      if (stream.readBytes(&c, 1) != 1) return false;
+    }
+    key += c;
   }
+  return false;
+}
+
+// Process HTTP response
+//
+// The response is walked one top-level key at a time so that each entry of "results" is
+// deserialized, converted to a Page and released before the next one is read. Peak memory is
+// therefore bound by the largest single page instead of the whole response.
+uint32_t NotionDatabase::process_response_(Stream &stream, size_t content_size, const QueryRequest &request,
+                                           QueryResult &result) {
+  StreamMonitor stream_monitor(stream);
+
+  ESP_LOGD(TAG, "Content Size: %d, JSON Parse Buffer: %u bytes in %s", content_size, arena_.capacity(),
+           memory_placement_to_string(arena_.placement()));
 
-  JsonArray results = doc["results"];
-  ESP_LOGD(TAG, "Processing %u results", results.size());
-  new_pages.reserve(results.size());
+  JsonAllocator allocator(&arena_);
+  JsonDocument doc(&allocator);
 
+  bool has_results = false;
+  bool has_more = false;
+  std::string new_next_cursor;
   uint32_t pages_hash = 17;
-  int i = 0;
-  for (JsonObject result : results) {
-    Page page;
-    pages_hash = pages_hash * 31 + parse_page_(result, page);
-    new_pages.push_back(std::move(page));
-    App.feed_wdt();
-#if ESP_LOG_LEVEL >= ESP_LOG_VERBOSE
-    ESP_LOGV(TAG, "Free heap(internal) after parse_page %d: %u", ++i, ESP.getFreeHeap());
-#endif
+  std::string key;
+
+  // Time to the first byte is the server's; the rest of the body is read as it is parsed
+  uint32_t start = micros();
+  int first_byte = stream_monitor.timed_peek();
+  result.stats.first_byte_us = micros() - start;
+  if (first_byte < 0 || stream_monitor.peek_token() != '{') {
+    ESP_LOGE(TAG, "JSON parsing failed: response is not an object");
+    return 0;
   }
+  stream_monitor.read();
+
+  bool complete = false;
+  while (!complete) {
+    int c = stream_monitor.peek_token();
+    if (c == '}') {
+      stream_monitor.read();
+      break;
+    }
+    // A body cut short would lose has_more and next_cursor, and leave the connection unusable
+    if (c < 0) {
+      ESP_LOGE(TAG, "JSON parsing failed: response truncated after %u bytes", stream_monitor.get_bytes_read());
+      return 0;
+    }
+    stream_monitor.read();
+    if (c == ',') {
+      continue;
+    }
+    if (c != '"' || !read_json_key(stream_monitor, key) || stream_monitor.peek_token() != ':') {
+      ESP_LOGE(TAG, "JSON parsing failed: malformed response after %u bytes", stream_monitor.get_bytes_read());
+      return 0;
+    }
+    stream_monitor.read();
 
-  has_more_ = doc["has_more"] | false;
-  if (has_more_) {
-    std::string new_next_currsor = doc["next_cursor"] | "";
-    if (new_next_currsor != next_cursor_) {
-      current_cursor_ = next_cursor_;
-      next_cursor_ = new_next_currsor;
+    if (key == "results") {
+      if (!process_results_(stream_monitor, doc, request, result, pages_hash)) {
+        doc.clear();
+        return 0;
+      }
+      has_results = true;
+      continue;
     }
-  }
 
-  ESP_LOGD(TAG, "Parsed %zu Pages", new_pages.size());
-  if (!current_cursor_.empty()) {
-    ESP_LOGD(TAG, "Pagination: Currnet cursor: %s", current_cursor_.c_str());
+    size_t mark = arena_.mark();
+    int first = stream_monitor.peek_token();
+    bool number = first == '-' || (first >= '0' && first <= '9');
+    bool wanted = key == "has_more" || key == "next_cursor";
+    DeserializationError error = wanted ? deserializeJson(doc, stream_monitor)
+                                        : deserializeJson(doc, stream_monitor, DeserializationOption::Filter(skip_filter()));
+    if (error) {
+      ESP_LOGE(TAG, "JSON parsing failed on '%s': %s", key.c_str(), error.c_str());
+      doc.clear();
+      return 0;
+    }
+    if (key == "has_more") {
+      has_more = doc.as<bool>();
+    } else if (key == "next_cursor") {
+      new_next_cursor = doc.as<const char *>() != nullptr ? doc.as<const char *>() : "";
+    }
+    doc.clear();
+    arena_.rewind(mark);
+    // A number ends at the byte after it, which the parser consumes; it may be the closing brace
+    complete = number && stream_monitor.get_last_read() == '}';
   }
-  ESP_LOGD(TAG, "Pagination: Has more: %s", has_more_ ? "true" : "false");
-  if (has_more_) {
-    ESP_LOGD(TAG, "Pagination: Next cursor: %s", next_cursor_.c_str());
+  ESP_LOGD(TAG, "Stream read bytes: %u", stream_monitor.get_bytes_read());
+  result.stats.response_bytes = stream_monitor.get_bytes_read();
+
+  if (!has_results) {
+    ESP_LOGE(TAG, "JSON parsing failed: no results in response");
+    return 0;
   }
-  doc.clear();
+
+  result.has_more = has_more;
+  result.next_cursor = new_next_cursor;
+  ESP_LOGD(TAG, "Parsed %zu Pages, %zu columns, %zu bytes, %zu symbols", result.pages.size(),
+           result.pages.columns().size(), result.pages.memory_usage(), result.symbols->size());
   return pages_hash;
 }
 
-bool NotionDatabase::parse_basic_property_(const JsonObject &property_obj, Page &page,
-                                           const std::string &property_name) {
-  available_properties_.insert(property_name);
+// Parse the "results" array one page at a time
+bool NotionDatabase::process_results_(StreamMonitor &stream, JsonDocument &doc, const QueryRequest &request,
+                                      QueryResult &result, uint32_t &pages_hash) {
+  if (stream.peek_token() != '[') {
+    ESP_LOGE(TAG, "JSON parsing failed: results is not an array");
+    return false;
+  }
+  stream.read();
 
-  if (!property_filters_.empty() && property_filters_.find(property_name) == property_filters_.end()) {
+  int i = 0;
+  while (true) {
+    int c = stream.peek_token();
+    if (c == ']') {
+      stream.read();
+      return true;
+    }
+    if (c == ',') {
+      stream.read();
+      continue;
+    }
+    if (c < 0) {
+      ESP_LOGE(TAG, "JSON parsing failed: response truncated after %u bytes", stream.get_bytes_read());
+      return false;
+    }
+
+    size_t mark = arena_.mark();
+    DeserializationError error = deserializeJson(doc, stream, DeserializationOption::Filter(request.page_filter));
+    if (error) {
+      ESP_LOGE(TAG, "JSON parsing failed on result %d: %s", i, error.c_str());
+      return false;
+    }
+
+    pages_hash = pages_hash * 31 + parse_page_(doc.as<JsonObject>(), request, result);
+    result.stats.heap_free_min =
+        std::min<uint32_t>(result.stats.heap_free_min, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    doc.clear();
+    arena_.rewind(mark);
+    feed_wdt();
+    ++i;
+#if ESP_LOG_LEVEL >= ESP_LOG_VERBOSE
+    ESP_LOGV(TAG, "Free heap(internal) after parse_page %d: %u", i, ESP.getFreeHeap());
+#endif
+  }
+}
+
+bool NotionDatabase::parse_basic_property_(const JsonObject &property_obj, const QueryRequest &request,
+                                           QueryResult &result, const std::string &property_name) {
+  PageTable &pages = result.pages;
+  result.available_properties.insert(property_name);
+
+  if (!request.property_filters.empty() && request.property_filters.find(property_name) == request.property_filters.end()) {
     return false;
   }
 
   if (property_name == NOTION_ID_KEY) {
-    NotionProperty prop;
-    prop.type = NotionPropertyType::TITLE;
-    prop.string_value = property_obj["id"] | "unknown_id";
-    page.set_property(NOTION_ID_KEY, prop);
+    int col = pages.get_or_add_column(Page::hash_key(NOTION_ID_KEY), NotionPropertyType::TITLE);
+    if (col < 0) return false;
+    pages.set_text(col, property_obj["id"] | "unknown_id");
     return true;
   }
 
   if (property_name == NOTION_LAST_EDITED_TIME_KEY) {
-    NotionProperty prop;
-    prop.type = NotionPropertyType::LAST_EDITED_TIME;
-    std::string last_edited_time_str = property_obj["last_edited_time"] | "1970-01-01T00:00:00Z";
-    prop.parse_time_from_iso8601(last_edited_time_str);
-    page.set_property(NOTION_LAST_EDITED_TIME_KEY, prop);
+    int col = pages.get_or_add_column(Page::hash_key(NOTION_LAST_EDITED_TIME_KEY), NotionPropertyType::LAST_EDITED_TIME);
+    if (col < 0) return false;
+    int32_t epoch = 0;
+    parse_iso8601_epoch(property_obj["last_edited_time"] | "1970-01-01T00:00:00Z", epoch);
+    pages.set_epoch(col, epoch);
     return true;
   }
 
   if (property_name == NOTION_CREATED_TIME_KEY) {
-    NotionProperty prop;
-    prop.type = NotionPropertyType::CREATED_TIME;
-    std::string created_time_str = property_obj["created_time"] | "1970-01-01T00:00:00Z";
-    prop.parse_time_from_iso8601(created_time_str);
-    page.set_property(NOTION_CREATED_TIME_KEY, prop);
+    int col = pages.get_or_add_column(Page::hash_key(NOTION_CREATED_TIME_KEY), NotionPropertyType::CREATED_TIME);
+    if (col < 0) return false;
+    int32_t epoch = 0;
+    parse_iso8601_epoch(property_obj["created_time"] | "1970-01-01T00:00:00Z", epoch);
+    pages.set_epoch(col, epoch);
     return true;
   }
 
   if (property_name == NOTION_ARCHIVED_KEY) {
-    NotionProperty archived_prop;
-    archived_prop.type = NotionPropertyType::CHECKBOX;
-    archived_prop.bool_value = property_obj["archived"] | false;
-    page.set_property(NOTION_ARCHIVED_KEY, archived_prop);
+    int col = pages.get_or_add_column(Page::hash_key(NOTION_ARCHIVED_KEY), NotionPropertyType::CHECKBOX);
+    if (col < 0) return false;
+    pages.set_bool(col, property_obj["archived"] | false);
     return true;
   }
 
   if (property_name == NOTION_IN_TRASH_KEY) {
-    NotionProperty prop;
-    prop.type = NotionPropertyType::CHECKBOX;
-    prop.bool_value = property_obj["in_trash"] | false;
-    page.set_property(NOTION_IN_TRASH_KEY, prop);
+    int col = pages.get_or_add_column(Page::hash_key(NOTION_IN_TRASH_KEY), NotionPropertyType::CHECKBOX);
+    if (col < 0) return false;
+    pages.set_bool(col, property_obj["in_trash"] | false);
     return true;
   }
 
   return false;
 }
 
-// Parse individual page
-uint32_t NotionDatabase::parse_page_(const JsonObject &pageJson, Page &page) {
-  parse_basic_property_(pageJson, page, NOTION_ID_KEY);
-  parse_basic_property_(pageJson, page, NOTION_CREATED_TIME_KEY);
-  parse_basic_property_(pageJson, page, NOTION_LAST_EDITED_TIME_KEY);
-  parse_basic_property_(pageJson, page, NOTION_ARCHIVED_KEY);
-  parse_basic_property_(pageJson, page, NOTION_IN_TRASH_KEY);
+// Parse individual page into a new row of pages
+uint32_t NotionDatabase::parse_page_(const JsonObject &pageJson, const QueryRequest &request, QueryResult &result) {
+  PageTable &pages = result.pages;
+  uint32_t row = pages.add_row();
+
+  parse_basic_property_(pageJson, request, result, NOTION_ID_KEY);
+  parse_basic_property_(pageJson, request, result, NOTION_CREATED_TIME_KEY);
+  parse_basic_property_(pageJson, request, result, NOTION_LAST_EDITED_TIME_KEY);
+  parse_basic_property_(pageJson, request, result, NOTION_ARCHIVED_KEY);
+  parse_basic_property_(pageJson, request, result, NOTION_IN_TRASH_KEY);
 
   JsonObject properties = pageJson["properties"].as<JsonObject>();
   for (JsonPair kv : properties) {
     std::string key = kv.key().c_str();
     JsonObject prop_obj = kv.value().as<JsonObject>();
-    std::string type_str = prop_obj["type"] | "";
-    NotionPropertyType np = notion_property_type_from_string(type_str);
+    NotionPropertyType np = notion_property_type_from_string(prop_obj["type"] | "");
 
     if (!supported_property_types_.count(np)) {
       continue;
     }
-    available_properties_.insert(key);
+    result.available_properties.insert(key);
 
-    if (!property_filters_.empty() && property_filters_.find(key) == property_filters_.end()) {
+    if (!request.property_filters.empty() && request.property_filters.find(key) == request.property_filters.end()) {
       continue;
     }
 
-    NotionProperty property;
-    property.type = np;
+    int col = pages.get_or_add_column(Page::hash_key(key), np);
+    if (col < 0) {
+      ESP_LOGW(TAG, "Property '%s' changed type, skipping", key.c_str());
+      continue;
+    }
 
     switch (np) {
       case NotionPropertyType::TITLE: {
-        std::string temp_str;
         JsonArray title_arr = prop_obj["title"].as<JsonArray>();
         for (JsonObject text_obj : title_arr) {
-          temp_str += (const char *)(text_obj["plain_text"] | "");
+          pages.append_text(col, text_obj["plain_text"] | "");
         }
-        property.string_value = std::move(temp_str);
         break;
       }
 
       case NotionPropertyType::RICH_TEXT: {
-        std::vector<std::string> texts;
         JsonArray text_arr = prop_obj["rich_text"].as<JsonArray>();
         for (JsonObject text_obj : text_arr) {
-          texts.push_back((const char *)(text_obj["plain_text"] | ""));
+          pages.append_text(col, text_obj["plain_text"] | "");
         }
-        property.vector_value = texts;
         break;
       }
 
       case NotionPropertyType::NUMBER: {
         if (!prop_obj["number"].isNull()) {
-          property.number_value = prop_obj["number"].as<double>();
-        } else {
-          property.number_value = 0.0;
+          pages.set_number(col, prop_obj["number"].as<double>());
         }
         break;
       }
 
       case NotionPropertyType::DATE: {
         JsonObject date_obj = prop_obj["date"].as<JsonObject>();
-        std::string temp_str = date_obj["start"] | "";
-        property.parse_time_from_iso8601(temp_str);
+        int32_t epoch = 0;
+        if (parse_iso8601_epoch(date_obj["start"] | "", epoch)) {
+          pages.set_epoch(col, epoch);
+        }
         break;
       }
 
       case NotionPropertyType::CHECKBOX: {
-        property.bool_value = prop_obj["checkbox"] | false;
+        pages.set_bool(col, prop_obj["checkbox"] | false);
         break;
       }
 
       case NotionPropertyType::SELECT: {
         JsonObject select_obj = prop_obj["select"].as<JsonObject>();
-        property.string_value = (!select_obj.isNull() && select_obj["name"].is<const char*>())
-                                    ? std::string(select_obj["name"] | "")
-                                    : std::string("");
+        if (!select_obj.isNull() && select_obj["name"].is<const char *>()) {
+          pages.set_symbol(col, result.symbols->intern(select_obj["name"] | ""));
+        }
         break;
       }
 
       case NotionPropertyType::MULTI_SELECT: {
-        std::vector<std::string> names;
         JsonArray ms_array = prop_obj["multi_select"].as<JsonArray>();
+        pages.begin_items(col);
         for (JsonObject ms_obj : ms_array) {
-          names.push_back((const char *)(ms_obj["name"] | ""));
+          pages.add_item(result.symbols->intern(ms_obj["name"] | ""));
         }
-        property.vector_value = names;
         break;
       }
 
       case NotionPropertyType::CREATED_TIME: {
-        std::string temp_str = std::string(prop_obj["created_time"] | "");
-        property.parse_time_from_iso8601(temp_str);
+        int32_t epoch = 0;
+        if (parse_iso8601_epoch(prop_obj["created_time"] | "", epoch)) {
+          pages.set_epoch(col, epoch);
+        }
         break;
       }
 
       case NotionPropertyType::EMAIL: {
-        property.string_value = std::string(prop_obj["email"] | "");
+        pages.set_text(col, prop_obj["email"] | "");
         break;
       }
 
       case NotionPropertyType::LAST_EDITED_TIME: {
-        std::string temp_str = std::string(prop_obj["last_edited_time"] | "");
-        property.parse_time_from_iso8601(temp_str);
+        int32_t epoch = 0;
+        if (parse_iso8601_epoch(prop_obj["last_edited_time"] | "", epoch)) {
+          pages.set_epoch(col, epoch);
+        }
         break;
       }
 
       case NotionPropertyType::PHONE_NUMBER: {
-        property.string_value = std::string(prop_obj["phone_number"] | "");
+        pages.set_text(col, prop_obj["phone_number"] | "");
         break;
       }
 
       case NotionPropertyType::STATUS: {
         JsonObject status_obj = prop_obj["status"].as<JsonObject>();
-        property.string_value = std::string(status_obj["name"] | "");
+        pages.set_symbol(col, result.symbols->intern(status_obj["name"] | ""));
         break;
       }
 
       case NotionPropertyType::URL: {
-        property.string_value = std::string(prop_obj["url"] | "");
+        pages.set_text(col, prop_obj["url"] | "");
         break;
       }
 
       default: {
-        property.type = NotionPropertyType::UNKNOWN;
         break;
       }
     }
-
-    page.set_property(key, property);
   }
 
 #if ESP_LOG_LEVEL >= ESP_LOG_VERBOSE
   ESP_LOGV(TAG, "Database Page:");
-  for (const auto &propertyName : available_properties_) {
-    const NotionProperty *prop = page.get_property(propertyName);
-    if (prop != nullptr) {
+  Page page = pages[row];
+  for (const auto &propertyName : result.available_properties) {
+    NotionProperty prop = page.get_property(propertyName);
+    if (prop) {
       ESP_LOGV(TAG, "  property: %s", propertyName.c_str());
-      ESP_LOGV(TAG, "    type: %s", notion_property_type_to_string(prop->type).c_str());
-      ESP_LOGV(TAG, "    value: %s", notion_property_to_string(*prop).c_str());
+      ESP_LOGV(TAG, "    type: %s", notion_property_type_to_string(prop.type()).c_str());
+      ESP_LOGV(TAG, "    value: %s", notion_property_to_string(prop).c_str());
     }
   }
 #endif
 
-  std::string content =
-      std::string(pageJson["id"].as<const char *>()) + pageJson["last_edited_time"].as<const char *>();
-  return std::hash<std::string>{}(content);
+  const char *last_edited_time = pageJson["last_edited_time"] | "";
+  if (std::strcmp(last_edited_time, result.watermark.c_str()) > 0) {
+    result.watermark = last_edited_time;
+  }
+
+  uint32_t key = fnv1a_hash(pageJson["id"] | "");
+  uint32_t hash = fnv1a_hash(last_edited_time, key);
+  pages.set_row_key(key);
+  pages.set_row_hash(hash);
+  return hash;
 }
 
-// Check for page changes
-void NotionDatabase::check_changes_(const std::vector<Page, Allocator<Page>> &new_pages, uint32_t new_pages_hash) {
+// Check for page changes; returns whether a stored property changed
+bool NotionDatabase::check_changes_(PageTable &new_pages, uint32_t new_pages_hash) {
   ESP_LOGD(TAG, "Previous pages hash: %u", pages_hash_);
   ESP_LOGD(TAG, "New pages hash: %u", new_pages_hash);
 
   // Compare new hash with previous hash
-  if (pages_hash_ != new_pages_hash) {
-    pages_ = std::move(new_pages);
-    pages_hash_ = new_pages_hash;
-    has_page_change_flag_ = true;
-    ESP_LOGI(TAG, "Detected page changes, current count: %zu", pages_.size());
-    on_page_change_trigger_.trigger();
-  } else {
+  if (pages_hash_ == new_pages_hash) {
     // No changes detected
     has_page_change_flag_ = false;
     ESP_LOGD(TAG, "No page changes");
+    return false;
+  }
+  // The first pages are always reported, even when there are none
+  bool first = pages_hash_ == 0;
+  uint32_t previous_hash = pages_hash_;
+  pages_hash_ = new_pages_hash;
+
+  diff_pages(*pages_, new_pages, changes_);
+  if (changes_.empty() && !first) {
+    // Only properties that are not stored were edited; the new pages carry the new row hashes
+    if (snapshot_pages_hash_ == previous_hash) {
+      snapshot_pages_hash_ = new_pages_hash;
+    }
+    publish_pages_(std::move(new_pages));
+    has_page_change_flag_ = false;
+    ESP_LOGD(TAG, "No changes to stored properties");
+    return false;
+  }
+
+  publish_pages_(std::move(new_pages));
+  has_page_change_flag_ = true;
+  ESP_LOGI(TAG, "Detected page changes, current count: %zu (%zu inserted, %zu removed, %zu moved, %zu modified)",
+           pages_->size(), changes_.inserted.size(), changes_.removed.size(), changes_.moved.size(),
+           changes_.modified.size());
+  pages_changed_callback_.call();
+  on_page_change_trigger_.trigger(changes_);
+  return true;
+}
+
+// Replaces the stored pages; the previous pages are freed once the last snapshot of them is released
+void NotionDatabase::publish_pages_(PageTable &&pages) {
+  std::shared_ptr<const PageTable> published = std::make_shared<const PageTable>(std::move(pages));
+  std::atomic_store(&pages_, published);
+}
+
+// Append the next page of results to the current pages
+void NotionDatabase::append_pages_(PageTable &more_pages) {
+  const PageTable &pages = *pages_;
+  PageTable merged(page_store_placement_);
+  merged.set_symbols(symbols_);
+  uint32_t merged_hash = 17;
+  // Rows scrolled past are dropped, so scrolling through a long view holds a bounded window
+  size_t evict = std::min(keep_from_row_, pages.size());
+  keep_from_row_ = 0;
+  for (Page page : pages) {
+    if (page.index() < evict) {
+      continue;
+    }
+    merged.copy_row(pages, page.index());
+    merged_hash = merged_hash * 31 + pages.row_hash(page.index());
   }
+  // Pages may shift between requests, so pages already shown are skipped
+  for (Page page : more_pages) {
+    if (pages.find_row(more_pages.row_key(page.index())) < 0) {
+      merged.copy_row(more_pages, page.index());
+      merged_hash = merged_hash * 31 + more_pages.row_hash(page.index());
+    }
+  }
+  ESP_LOGD(TAG, "Appended %zu pages, dropped %zu", merged.size() + evict - pages.size(), evict);
+  if (!has_appended_rows_) {
+    base_rows_ = pages.size();
+    has_appended_rows_ = true;
+  }
+  base_rows_ -= std::min(base_rows_, evict);
+  evicted_rows_ += evict;
+  check_changes_(merged, merged_hash);
+}
+
+// Keep the rows loaded with load_more() when the first page is fetched again
+void NotionDatabase::keep_appended_rows_(PageTable &new_pages, uint32_t &new_pages_hash) {
+  const PageTable &pages = *pages_;
+  if (evicted_rows_ > 0) {
+    // The top of the first page was dropped, so only the rows still held are refreshed
+    PageTable kept(page_store_placement_);
+    kept.set_symbols(new_pages.get_symbols());
+    uint32_t kept_hash = 17;
+    for (Page page : pages) {
+      int row = new_pages.find_row(pages.row_key(page.index()));
+      if (row >= 0) {
+        kept.copy_row(new_pages, row);
+      } else {
+        kept.copy_row(pages, page.index());
+      }
+      kept_hash = kept_hash * 31 + kept.row_hash(kept.size() - 1);
+    }
+    new_pages = std::move(kept);
+    new_pages_hash = kept_hash;
+    return;
+  }
+
+  size_t base_rows = new_pages.size();
+  for (size_t row = base_rows_; row < pages.size(); row++) {
+    if (new_pages.find_row(pages.row_key(row)) < 0) {
+      new_pages.copy_row(pages, row);
+      new_pages_hash = new_pages_hash * 31 + pages.row_hash(row);
+    }
+  }
+  base_rows_ = base_rows;
+}
+
+// Returns the page cache key of the page of the current query starting at a cursor
+uint32_t NotionDatabase::page_cache_key_(const std::string &cursor) {
+  return fnv1a_hash(cursor.c_str(), fnv1a_hash(query_.value().c_str()));
+}
+
+// Stores a copy of the current pages in the page cache
+void NotionDatabase::cache_current_page_() {
+  if (!page_cache_.is_enabled() || has_appended_rows_) {
+    return;
+  }
+  const PageTable &pages = *pages_;
+  PageTable copy(page_store_placement_);
+  copy.set_symbols(pages.get_symbols());
+  for (Page page : pages) {
+    copy.copy_row(pages, page.index());
+  }
+  page_cache_.put(page_cache_key_(current_cursor_), std::move(copy), pages_hash_, has_more_,
+                  has_more_ ? next_cursor_ : "");
+}
+
+// Shows the cached page starting at the current cursor; returns false if it is not cached
+bool NotionDatabase::show_cached_page_() {
+  if (!page_cache_.is_enabled()) {
+    return false;
+  }
+  const PageCache::Entry *entry = page_cache_.find(page_cache_key_(current_cursor_));
+  if (entry == nullptr) {
+    return false;
+  }
+  ESP_LOGD(TAG, "Showing %zu cached pages", entry->pages.size());
+  PageTable pages(page_store_placement_);
+  pages.set_symbols(entry->pages.get_symbols());
+  for (Page page : entry->pages) {
+    pages.copy_row(entry->pages, page.index());
+  }
+  has_more_ = entry->has_more;
+  next_cursor_ = entry->next_cursor;
+  base_rows_ = pages.size();
+  check_changes_(pages, entry->pages_hash);
+  schedule_prefetch_();
+  return true;
+}
+
+// Fetches the page after the current one into the cache once the main loop is idle
+void NotionDatabase::schedule_prefetch_() {
+  if (!page_cache_.is_enabled() || !has_more_ || next_cursor_.empty() ||
+      page_cache_.contains(page_cache_key_(next_cursor_))) {
+    return;
+  }
+  // Deferred so that the page change trigger has redrawn the display first
+  this->defer("prefetch", [this]() {
+    request_fetch_(FetchMode::PREFETCH);
+  });
+}
+
+// Merge the pages edited since the watermark into the current pages by page ID
+void NotionDatabase::merge_pages_(PageTable &edited_pages) {
+  if (edited_pages.empty()) {
+    has_page_change_flag_ = false;
+    ESP_LOGD(TAG, "No page changes");
+    return;
+  }
+
+  const PageTable &pages = *pages_;
+  PageTable merged(page_store_placement_);
+  merged.set_symbols(symbols_);
+  std::vector<bool> merged_rows(edited_pages.size(), false);
+  uint32_t merged_hash = 17;
+  for (Page page : pages) {
+    int row = edited_pages.find_row(pages.row_key(page.index()));
+    if (row >= 0) {
+      merged.copy_row(edited_pages, row);
+      merged_rows[row] = true;
+    } else {
+      merged.copy_row(pages, page.index());
+    }
+    merged_hash = merged_hash * 31 + merged.row_hash(merged.size() - 1);
+  }
+  // Pages that are new to the view are appended; the next full sync puts them in query order.
+  // When the view has more pages, a new page may belong to a later one, so it is left to the
+  // full sync instead of growing the first page.
+  size_t deferred = 0;
+  for (Page page : edited_pages) {
+    if (merged_rows[page.index()]) {
+      continue;
+    }
+    if (has_more_) {
+      deferred++;
+      continue;
+    }
+    merged.copy_row(edited_pages, page.index());
+    merged_hash = merged_hash * 31 + merged.row_hash(merged.size() - 1);
+  }
+  if (deferred > 0) {
+    ESP_LOGD(TAG, "Incremental sync: %zu pages new to a paginated view, scheduling a full sync", deferred);
+    full_sync_pending_ = true;
+  }
+
+  check_changes_(merged, merged_hash);
+}
+
+// Filter and sort the pages of the source database
+void NotionDatabase::apply_source_() {
+  std::shared_ptr<const PageTable> source_pages = source_->get_pages_snapshot();
+  PageTable new_pages(page_store_placement_);
+  new_pages.set_symbols(source_pages->get_symbols());
+  uint32_t new_pages_hash = local_query_.apply(*source_pages, new_pages);
+  ESP_LOGD(TAG, "Selected %zu of %zu pages from source", new_pages.size(), source_pages->size());
+
+  check_changes_(new_pages, new_pages_hash);
+  this->status_clear_warning();
+}
+
+void NotionDatabase::load_more() {
+  if (source_ != nullptr || !has_more_ || next_cursor_.empty()) {
+    ESP_LOGD(TAG, "No more pages to load");
+    return;
+  }
+  ESP_LOGI(TAG, "Loading more pages");
+  request_fetch_(FetchMode::APPEND);
+}
+
+void NotionDatabase::request_more(size_t first_row) {
+  // After a failed append, waits for the next successful fetch instead of retrying every frame
+  if (load_more_failed_ || (waiting_modes_ & fetch_mode_bit(FetchMode::APPEND)) ||
+      (is_fetching() && request_.mode == FetchMode::APPEND)) {
+    return;
+  }
+  keep_from_row_ = first_row;
+  this->defer("load_more", [this]() { this->load_more(); });
 }
 
 void NotionDatabase::first_page() {
   ESP_LOGI(TAG, "Fetching first page");
   reset_state();
   previous_cursors_.clear();
-  update();
+  request_fetch_(FetchMode::PAGE);
 }
 
 void NotionDatabase::next_page() {
@@ -466,7 +1558,12 @@ void NotionDatabase::next_page() {
   if (has_more_) {
     previous_cursors_.push_back(current_cursor_);
     current_cursor_ = next_cursor_;
-    update();
+    full_sync_pending_ = true;
+    has_appended_rows_ = false;
+    evicted_rows_ = 0;
+    if (!show_cached_page_()) {
+      request_fetch_(FetchMode::PAGE);
+    }
   } else {
     ESP_LOGD(TAG, "No more pages available");
   }
@@ -477,16 +1574,34 @@ void NotionDatabase::previous_page() {
   if (!previous_cursors_.empty()) {
     current_cursor_ = previous_cursors_.back();
     previous_cursors_.pop_back();
-    update();
+    full_sync_pending_ = true;
+    has_appended_rows_ = false;
+    evicted_rows_ = 0;
+    if (!show_cached_page_()) {
+      request_fetch_(FetchMode::PAGE);
+    }
   } else {
     ESP_LOGD(TAG, "No previous page available");
   }
 }
 
 void NotionDatabase::reset_state() {
+  page_filter_.clear();
+  changes_.clear();
+  has_appended_rows_ = false;
+  evicted_rows_ = 0;
+  // A response to a request sent before the reset is discarded
+  generation_++;
+  // Cached pages refer to the symbols cleared below
+  page_cache_.clear();
+  sync_watermark_.clear();
+  full_sync_pending_ = true;
   pages_hash_ = 0;
   has_page_change_flag_ = false;
-  pages_.clear();
+  snapshot_restored_ = false;
+  publish_pages_(PageTable(page_store_placement_));
+  // Snapshots and derived databases holding the old pages keep the old symbols alive
+  symbols_ = std::make_shared<SymbolTable>();
   available_properties_.clear();
   has_more_ = false;
   current_cursor_ = "";
@@ -495,19 +1610,20 @@ void NotionDatabase::reset_state() {
 }
 
 // Parse ISO8601 date strings
-bool NotionProperty::parse_time_from_iso8601(const std::string &iso_time) {
-  if (iso_time.empty()) return false;
+bool parse_iso8601_epoch(const char *iso_time, int32_t &epoch) {
+  if (iso_time == nullptr || *iso_time == '\0') return false;
 
+  std::tm time_value;
   std::memset(&time_value, 0, sizeof(time_value));
 
   int year, month, day, hour = 0, min = 0, sec = 0;
 
   int matched;
-  if (iso_time.find('T') != std::string::npos) {
-    matched = sscanf(iso_time.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &min, &sec);
+  if (std::strchr(iso_time, 'T') != nullptr) {
+    matched = sscanf(iso_time, "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &min, &sec);
     if (matched < 3) return false;
   } else {
-    matched = sscanf(iso_time.c_str(), "%d-%d-%d", &year, &month, &day);
+    matched = sscanf(iso_time, "%d-%d-%d", &year, &month, &day);
     if (matched != 3) return false;
   }
 
@@ -522,9 +1638,7 @@ bool NotionProperty::parse_time_from_iso8601(const std::string &iso_time) {
 
   time_t epoch_time = mktime(&time_value);
 
-  epoch_time += tz_offset;
-
-  time_value = *localtime(&epoch_time);
+  epoch = static_cast<int32_t>(epoch_time + tz_offset);
 
   return true;
 }
@@ -4,16 +4,30 @@
  * @brief Header for Notion Database component.
  */
 
+#include <cstdio>
+#include <ctime>
+#include <memory>
 #include <set>
-#include <sstream>  // add if not already included
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "allocator.h"
+#include "change_set.h"
+#include "adaptive_polling.h"
 #include "esphome.h"
+#include "fetch_task.h"
+#include "local_query.h"
+#include "page_cache.h"
+#include "page_table.h"
+#include "snapshot.h"
+#include "stream_monitor.h"
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
+#include "http_session.h"
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
 
 namespace esphome {
 namespace notion_database {
@@ -21,50 +35,11 @@ namespace notion_database {
 std::string tm_to_date(const std::tm &tm_time);
 std::string tm_to_iso8601(const std::tm &tm_time);
 
-enum class NotionPropertyType {
-  TITLE,
-  RICH_TEXT,
-  NUMBER,
-  DATE,
-  CHECKBOX,
-  SELECT,
-  MULTI_SELECT,
-  CREATED_BY,
-  CREATED_TIME,
-  EMAIL,
-  FILES,
-  FORMULA,
-  LAST_EDITED_BY,
-  LAST_EDITED_TIME,
-  PEOPLE,
-  PHONE_NUMBER,
-  RELATION,
-  ROLLUP,
-  STATUS,
-  URL,
-  UNKNOWN
-};
-
-/**
- * @brief Represents a Notion property.
- */
-struct NotionProperty {
-  NotionPropertyType type;
-  // Use these members depending on which type is active.
-  std::string string_value;
-  double number_value;
-  bool bool_value;
-  std::vector<std::string> vector_value;
-  std::tm time_value;
-
-  NotionProperty() : type(NotionPropertyType::UNKNOWN), number_value(0.0), bool_value(false) {
-    // Initialize time_value to epoch (1970-01-01)
-    std::memset(&time_value, 0, sizeof(time_value));
-  }
+// Parses an ISO8601 date or date-time string into seconds since epoch
+bool parse_iso8601_epoch(const char *iso_time, int32_t &epoch);
 
-  // Helper method to parse ISO8601 date strings into time_value
-  bool parse_time_from_iso8601(const std::string &iso_time);
-};
+// Returns the delay in seconds of a Retry-After header value
+uint32_t parse_retry_after(const char *value);
 
 // Common Notion page properties
 const static std::string NOTION_ID_KEY = "ID";
@@ -73,72 +48,61 @@ const static std::string NOTION_LAST_EDITED_TIME_KEY = "Last Edited Time";
 const static std::string NOTION_ARCHIVED_KEY = "Archived";
 const static std::string NOTION_IN_TRASH_KEY = "In Trash";
 
-struct Page {
-  std::vector<std::pair<uint32_t, NotionProperty>> properties;
-
-  uint32_t hash_key(const std::string &key) const { return static_cast<uint32_t>(std::hash<std::string>{}(key)); }
-
-  const NotionProperty *get_property(const std::string &key) const {
-    uint32_t h = hash_key(key);
-    for (const auto &kv : properties) {
-      if (kv.first == h) return &kv.second;
-    }
-    return nullptr;
-  }
-
-  void set_property(const std::string &key, const NotionProperty &prop) {
-    uint32_t h = hash_key(key);
-    for (auto &kv : properties) {
-      if (kv.first == h) {
-        kv.second = prop;
-        return;
-      }
-    }
-    properties.push_back({h, prop});
-  }
-};
-
-inline std::string notion_property_to_string(const NotionProperty &prop) {
-  switch (prop.type) {
+// Returns the text of a property without allocating. Text properties point into the page store;
+// other types are formatted into buffer, and multi-select items that do not fit are cut off.
+inline const char *notion_property_format(const NotionProperty &prop, char *buffer, size_t size) {
+  switch (prop.type()) {
     case NotionPropertyType::TITLE:
+    case NotionPropertyType::RICH_TEXT:
     case NotionPropertyType::SELECT:
     case NotionPropertyType::EMAIL:
     case NotionPropertyType::PHONE_NUMBER:
     case NotionPropertyType::STATUS:
     case NotionPropertyType::URL:
-      return prop.string_value;
+      return prop.string_value();
 
     case NotionPropertyType::DATE:
-      return tm_to_date(prop.time_value);
-
     case NotionPropertyType::CREATED_TIME:
-    case NotionPropertyType::LAST_EDITED_TIME:
-      return tm_to_iso8601(prop.time_value);
-
-    case NotionPropertyType::RICH_TEXT: {
-      std::ostringstream oss;
-      for (const auto &text : prop.vector_value) {
-        oss << text;
-      }
-      return oss.str();
+    case NotionPropertyType::LAST_EDITED_TIME: {
+      std::tm tm_time = prop.time_value();
+      const char *format = prop.type() == NotionPropertyType::DATE ? "%Y-%m-%d" : "%Y-%m-%dT%H:%M:%SZ";
+      if (std::strftime(buffer, size, format, &tm_time) == 0 && size > 0) buffer[0] = '\0';
+      return buffer;
     }
+
     case NotionPropertyType::NUMBER:
-      return std::to_string(prop.number_value);
+      snprintf(buffer, size, "%f", prop.number_value());
+      return buffer;
     case NotionPropertyType::CHECKBOX:
-      return prop.bool_value ? "Y" : "N";
+      return prop.bool_value() ? "Y" : "N";
     case NotionPropertyType::MULTI_SELECT: {
-      std::ostringstream oss;
-      for (size_t i = 0; i < prop.vector_value.size(); ++i) {
-        oss << prop.vector_value[i];
-        if (i + 1 < prop.vector_value.size()) oss << ", ";
+      size_t length = 0;
+      if (size > 0) buffer[0] = '\0';
+      for (size_t i = 0; i < prop.item_count() && length < size; ++i) {
+        int written = snprintf(buffer + length, size - length, i == 0 ? "%s" : ", %s", prop.item(i));
+        if (written < 0) break;
+        length += written;
       }
-      return oss.str();
+      return buffer;
     }
     default:
       return "UNKNOWN";
   }
 }
 
+inline std::string notion_property_to_string(const NotionProperty &prop) {
+  if (prop.type() == NotionPropertyType::MULTI_SELECT) {
+    std::string result;
+    for (size_t i = 0; i < prop.item_count(); ++i) {
+      if (i > 0) result += ", ";
+      result += prop.item(i);
+    }
+    return result;
+  }
+  char buffer[32];
+  return notion_property_format(prop, buffer, sizeof(buffer));
+}
+
 inline std::string notion_property_type_to_string(NotionPropertyType type) {
   switch (type) {
     case NotionPropertyType::TITLE:
@@ -220,6 +184,95 @@ inline bool operator==(const std::tm &lhs, const std::tm &rhs) {
 
 inline bool operator!=(const std::tm &lhs, const std::tm &rhs) { return !(lhs == rhs); }
 
+class NotionDatabase;
+
+// How a response is combined with the pages already held
+enum class FetchMode { PAGE, INCREMENTAL, APPEND, PREFETCH };
+
+const char *fetch_mode_to_string(FetchMode mode);
+
+// Timings in microseconds and sizes in bytes of one fetch
+struct FetchStats {
+  FetchMode mode{FetchMode::PAGE};
+  // Opening the connection, including the TLS handshake; zero when the connection was reused
+  uint32_t connect_us{0};
+  // From sending the request until the response headers arrived
+  uint32_t request_us{0};
+  // From the response headers until the first byte of the body arrived
+  uint32_t first_byte_us{0};
+  // Streaming parse of the body into a PageTable; the body is read as it is parsed, so this
+  // includes waiting for the rest of it to arrive
+  uint32_t parse_us{0};
+  // Diff, merge and publish on the main loop
+  uint32_t apply_us{0};
+  uint32_t response_bytes{0};
+  uint32_t pages{0};
+  uint32_t page_store_bytes{0};
+  uint32_t parse_buffer_peak{0};
+  uint32_t parse_buffer_fallbacks{0};
+  // Free heap before the parse and the lowest seen between pages
+  uint32_t heap_free_before{0};
+  uint32_t heap_free_min{0};
+  // Largest free heap block once the pages were applied
+  uint32_t largest_free_block{0};
+
+  // Returns how much heap the parse took at its peak
+  uint32_t heap_used_peak() const { return heap_free_before - heap_free_min; }
+};
+
+// Everything a query request needs, captured on the main loop so it can be sent from another task
+struct QueryRequest {
+  FetchMode mode{FetchMode::PAGE};
+  // Sent by update() or the adaptive poll timer rather than a page flip; only these move the poll schedule
+  bool poll{false};
+  // Incremented by reset_state(); responses to requests of an older generation are dropped
+  uint32_t generation{0};
+  std::string url;
+  std::string api_token;
+  std::string payload;
+  // Start cursor of the request, empty for the first page
+  std::string cursor;
+  uint32_t connect_timeout{0};
+  uint32_t timeout{0};
+  std::set<std::string> property_filters;
+  JsonDocument page_filter;
+};
+
+// A parsed response, applied to the database on the main loop
+struct QueryResult {
+  explicit QueryResult(MemoryPlacement placement) : pages(placement) {}
+
+  int http_code{0};
+  std::string error;
+  // Seconds to wait before the next request, from the Retry-After header of a 429 response
+  uint32_t retry_after{0};
+  PageTable pages;
+  // 0 when the response could not be parsed
+  uint32_t pages_hash{0};
+  bool has_more{false};
+  std::string next_cursor;
+  // The state changed while the request was in flight, so the response was dropped
+  bool outdated{false};
+  // The database's symbol table, which this response adds its new symbols to
+  std::shared_ptr<SymbolTable> symbols;
+  std::set<std::string> available_properties;
+  std::string watermark;
+  FetchStats stats;
+};
+
+/**
+ * @brief Runs the requests of several databases over one shared connection.
+ */
+class RequestScheduler {
+ public:
+  // Queues a request for the database; the scheduler calls NotionDatabase::fetch(mode) when it is its turn
+  virtual void submit(NotionDatabase *database, FetchMode mode) = 0;
+  // Holds back all requests for a while, after the API reported that the rate limit was exceeded
+  virtual void pause(uint32_t duration) = 0;
+  // Returns the connection shared by the scheduled databases
+  virtual HttpSession &get_session() = 0;
+};
+
 class NotionDatabase : public PollingComponent {
  public:
   // Returns the setup priority
@@ -228,14 +281,25 @@ class NotionDatabase : public PollingComponent {
   void setup() override;
   // Update the component
   void update() override;
+  // Applies the response of an asynchronous fetch
+  void loop() override;
+  // Sends the query now, bypassing the request scheduler
+  void fetch(FetchMode mode = FetchMode::PAGE);
+  // Returns whether an asynchronous fetch is in flight or waiting to be applied
+  bool is_fetching() const { return !fetch_task_.is_idle(); }
   // Dump configuration
   void dump_config() override;
+  // Writes a pending snapshot before a reboot or deep sleep
+  void on_shutdown() override;
 
   // Sets the API token
   template <typename V>
   void set_api_token(V token) {
     api_token_ = token;
   }
+  // Sets the scheme and host requests are sent to, e.g. to point at a local stand-in for the API
+  void set_base_url(const std::string &base_url) { base_url_ = base_url; }
+
   // Sets the database ID
   template <typename V>
   void set_database_id(V id) {
@@ -248,7 +312,7 @@ class NotionDatabase : public PollingComponent {
   }
 
   // Returns the on_page_change trigger
-  Trigger<> *get_on_page_change_trigger() { return &this->on_page_change_trigger_; }
+  Trigger<const ChangeSet &> *get_on_page_change_trigger() { return &this->on_page_change_trigger_; }
 
   // Sets the watchdog timeout
   template <typename V>
@@ -268,20 +332,110 @@ class NotionDatabase : public PollingComponent {
     http_timeout_ = http_timeout;
   }
 
+  // Enables reusing the HTTPS connection between requests
+  void set_keep_alive(bool keep_alive) { session_.set_keep_alive(keep_alive); }
+
+  // Sets how long an unused connection is kept before reconnecting
+  void set_keep_alive_timeout(uint32_t keep_alive_timeout) { session_.set_idle_timeout(keep_alive_timeout); }
+
+  // Sets the database whose pages are filtered and sorted locally instead of querying the API
+  void set_source(NotionDatabase *source) { source_ = source; }
+  // Adds a local filter condition; conditions are ANDed
+  void add_local_condition(const std::string &property, FilterOperator op, const std::string &value) {
+    local_query_.add_condition(property, op, value);
+  }
+  // Adds a local sort
+  void add_local_sort(const std::string &property, bool ascending) { local_query_.add_sort(property, ascending); }
+  // Registers a callback invoked after the pages have changed
+  void add_on_pages_changed_callback(std::function<void()> &&callback) {
+    pages_changed_callback_.add(std::move(callback));
+  }
+
+  // Enables fetching only the pages edited since the last sync
+  void set_incremental_sync(bool incremental_sync) { incremental_sync_ = incremental_sync; }
+  // Sets how often the whole view is fetched again when syncing incrementally
+  void set_full_sync_interval(uint32_t full_sync_interval) { full_sync_interval_ = full_sync_interval; }
+
+  // Sets how many cursor pages are kept for instant page flips; 0 disables the cache and prefetching
+  void set_page_cache_entries(size_t entries) { page_cache_.set_max_entries(entries); }
+  // Sets the memory budget of the page cache
+  void set_page_cache_bytes(size_t bytes) { page_cache_.set_max_bytes(bytes); }
+  const PageCache &get_page_cache() const { return page_cache_; }
+
+  // Sends requests from a task of their own instead of blocking the main loop
+  void set_async_fetch(bool async_fetch) { async_fetch_ = async_fetch; }
+  // Sets the stack size of the fetch task in bytes
+  void set_fetch_task_stack_size(uint32_t stack_size) { fetch_task_stack_size_ = stack_size; }
+  // Sets the core the fetch task runs on, or -1 for either
+  void set_fetch_task_core(int core) { fetch_task_core_ = core; }
+
+  // Replaces update_interval with an interval between min_interval and max_interval, in milliseconds
+  void set_adaptive_polling(uint32_t min_interval, uint32_t max_interval, float backoff_factor) {
+    adaptive_polling_.set_intervals(min_interval, max_interval);
+    adaptive_polling_.set_backoff_factor(backoff_factor);
+  }
+  // Sets the window in seconds since midnight during which adaptive polling is paused
+  void set_quiet_hours(uint32_t start, uint32_t end) { adaptive_polling_.set_quiet_hours(start, end); }
+#ifdef USE_TIME
+  // Sets the clock the quiet hours and the age of the snapshot are read from
+  void set_time(time::RealTimeClock *time) { time_ = time; }
+#endif
+  // Returns the delay before the next poll when polling adaptively
+  uint32_t get_poll_interval() const { return adaptive_polling_.get_interval(); }
+
+  // Saves the first page of results to flash and shows it on boot; key identifies the component
+  void set_snapshot(uint32_t key, size_t max_size) {
+    snapshot_store_.set_key(key);
+    snapshot_max_size_ = max_size;
+  }
+  // Sets how long after a change the snapshot is written, so that bursts of edits cost one write
+  void set_snapshot_write_delay(uint32_t write_delay) { snapshot_write_delay_ = write_delay; }
+  // Sets the age in seconds below which a restored snapshot replaces the first fetch; 0 always fetches
+  void set_snapshot_max_age(uint32_t max_age) { snapshot_max_age_ = max_age; }
+  // Encodes the first page of results as a snapshot, e.g. to send to another device; false if not shown
+  bool save_snapshot(std::vector<uint8_t> &data);
+  // Shows the pages of a snapshot saved by a database with the same configuration
+  bool load_snapshot(const uint8_t *data, size_t size, uint32_t *saved_at = nullptr);
+
+  // Sets the scheduler that serializes requests with other databases
+  void set_scheduler(RequestScheduler *scheduler) { scheduler_ = scheduler; }
+
   // Sets the JSON parse buffer size
   template <typename V>
   void set_json_parse_buffer_size(V json_parse_buffer_size) {
     json_parse_buffer_size_ = json_parse_buffer_size;
   }
 
+  // Sets where the JSON parse buffer is allocated
+  void set_json_parse_buffer_placement(MemoryPlacement placement) { json_parse_buffer_placement_ = placement; }
+  // Sets where the page store is allocated
+  void set_page_store_placement(MemoryPlacement placement) { page_store_placement_ = placement; }
+  // Sets where small caches that are read on every draw are allocated
+  void set_cache_placement(MemoryPlacement placement) { cache_placement_ = placement; }
+  MemoryPlacement get_cache_placement() const { return cache_placement_; }
+
   // Returns the available properties
   const std::set<std::string> &get_available_properties() { return available_properties_; }
   // Returns the page count
-  int get_page_count() const { return pages_.size(); }
+  int get_page_count() const { return pages_->size(); }
   // Returns the has_page_change flag
   bool has_page_change() const { return has_page_change_flag_; }
-  // Returns the pages
-  const std::vector<Page, Allocator<Page>> &get_pages() const { return pages_; }
+  // Returns the pages; the reference is valid until the pages change on the main loop
+  const PageTable &get_pages() const { return *pages_; }
+  // Returns the current pages, which stay valid and unchanged for as long as the handle is held
+  std::shared_ptr<const PageTable> get_pages_snapshot() const { return std::atomic_load(&pages_); }
+  // Returns the hash of the pages, which changes whenever their content does
+  uint32_t get_pages_hash() const { return pages_hash_; }
+  // Returns the changes of the last update that changed the pages
+  const ChangeSet &get_changes() const { return changes_; }
+  // Returns the timings and sizes of the last applied fetch
+  const FetchStats &get_fetch_stats() const { return fetch_stats_; }
+  // Returns the number of fetches that failed since the last successful one
+  uint32_t get_consecutive_failures() const { return consecutive_failures_; }
+  // Registers a callback invoked after every fetch, with the stats of the last successful one
+  void add_on_fetch_callback(std::function<void(const FetchStats &, bool)> &&callback) {
+    fetch_callback_.add(std::move(callback));
+  }
 
   // Adds a property filter
   void add_property_filter(const std::string &property_name) {
@@ -312,6 +466,19 @@ class NotionDatabase : public PollingComponent {
   // Fetches the previous page
   void previous_page();
 
+  // Returns whether Notion has more pages after the ones held
+  bool has_more() const { return has_more_; }
+
+  // Appends the next page of results to the current pages
+  void load_more();
+
+  // Calls load_more() from the main loop; safe to call from a display lambda on every frame.
+  // Rows before first_row are dropped when the next page is appended, to bound the rows held.
+  void request_more(size_t first_row = 0);
+
+  // Returns how many rows were dropped from the top by request_more() since the last page flip
+  size_t get_evicted_row_count() const { return evicted_rows_; }
+
   // Resets the state
   void reset_state();
 
@@ -319,22 +486,87 @@ class NotionDatabase : public PollingComponent {
   TemplatableValue<std::string> api_token_;
   TemplatableValue<std::string> database_id_;
   TemplatableValue<std::string> query_;
-  Trigger<> on_page_change_trigger_{};
+  std::string base_url_{"https://api.notion.com"};
+  // millis() before which no request is sent, after a 429 response
+  uint32_t retry_at_{0};
+  bool retry_pending_{false};
+  Trigger<const ChangeSet &> on_page_change_trigger_{};
 
   TemplatableValue<uint32_t> watchdog_timeout_;
   TemplatableValue<uint32_t> http_connect_timeout_;
   TemplatableValue<uint32_t> http_timeout_;
   TemplatableValue<uint32_t> json_parse_buffer_size_;
+  MemoryPlacement json_parse_buffer_placement_{MemoryPlacement::PSRAM};
+  MemoryPlacement page_store_placement_{MemoryPlacement::PSRAM};
+  MemoryPlacement cache_placement_{MemoryPlacement::INTERNAL};
+  ArenaAllocator arena_;
+  HttpSession session_;
+  RequestScheduler *scheduler_{nullptr};
+  NotionDatabase *source_{nullptr};
+  LocalQuery local_query_;
+  CallbackManager<void()> pages_changed_callback_;
 
   std::set<std::string> available_properties_;
   std::set<std::string> property_filters_;
-  std::vector<Page, Allocator<Page>> pages_;
+  // Published with an atomic swap; a reader holding the old pages keeps them alive
+  std::shared_ptr<const PageTable> pages_{std::make_shared<const PageTable>()};
+  // Only ever grows within a generation, so it resolves the symbols of every table built since reset_state()
+  std::shared_ptr<SymbolTable> symbols_{std::make_shared<SymbolTable>()};
+  JsonDocument page_filter_;
   uint32_t pages_hash_ = 0;
+  ChangeSet changes_;
   bool has_page_change_flag_{false};
   bool has_more_{false};
   std::string current_cursor_;
   std::string next_cursor_;
   std::vector<std::string> previous_cursors_;
+  bool incremental_sync_{false};
+  uint32_t full_sync_interval_{900000};
+  uint32_t last_full_sync_{0};
+  bool full_sync_pending_{true};
+  PageCache page_cache_;
+  bool has_appended_rows_{false};
+  // Rows of the last full page, followed by the rows added by load_more()
+  size_t base_rows_{0};
+  // Rows dropped from the top while appending, and the first row to keep on the next append
+  size_t evicted_rows_{0};
+  size_t keep_from_row_{0};
+  // Set when appending failed; request_more() waits for the next successful fetch
+  bool load_more_failed_{false};
+  // Largest last_edited_time seen, as sent by Notion
+  std::string sync_watermark_;
+  uint32_t generation_{0};
+  FetchStats fetch_stats_;
+  uint32_t consecutive_failures_{0};
+  CallbackManager<void(const FetchStats &, bool)> fetch_callback_;
+  AdaptivePolling adaptive_polling_;
+#ifdef USE_TIME
+  time::RealTimeClock *time_{nullptr};
+#endif
+
+  bool async_fetch_{false};
+  uint32_t fetch_task_stack_size_{16384};
+  int fetch_task_core_{-1};
+  FetchTask fetch_task_;
+  // Owned by the fetch task while a fetch is in flight
+  QueryRequest request_;
+  std::unique_ptr<QueryResult> async_result_;
+  // Modes requested but not yet sent, one bit per FetchMode
+  uint8_t waiting_modes_{0};
+  // A scheduled poll is waiting; the next first page request carries it
+  bool poll_waiting_{false};
+
+  SnapshotStore snapshot_store_;
+  size_t snapshot_max_size_{4096};
+  uint32_t snapshot_write_delay_{60000};
+  uint32_t snapshot_max_age_{0};
+  bool snapshot_pending_{false};
+  // A snapshot was restored; the first scheduled poll is skipped if it is younger than max_age by
+  // then, as the clock is rarely set this early in boot
+  bool snapshot_restored_{false};
+  // Hash of the pages in the saved snapshot, and when they were last known to be current
+  uint32_t snapshot_pages_hash_{0};
+  uint32_t snapshot_checked_at_{0};
 
   std::set<NotionPropertyType> supported_property_types_ = {
       NotionPropertyType::CREATED_TIME, NotionPropertyType::DATE,   NotionPropertyType::EMAIL,
@@ -343,13 +575,45 @@ class NotionDatabase : public PollingComponent {
       NotionPropertyType::STATUS,       NotionPropertyType::TITLE,  NotionPropertyType::URL,
   };
 
-  bool send_request_();
-  bool add_pagination_cursor_to_query_(std::string &payload);
-  uint32_t process_response_(Stream &stream, size_t content_size, std::vector<Page, Allocator<Page>> &new_pages);
-  uint32_t parse_page_(const JsonObject &pageJson, Page &page);
-  bool parse_basic_property_(const JsonObject &property_obj, Page &page, const std::string &property_name);
+  bool send_request_(FetchMode mode, QueryResult &result);
+  void request_fetch_(FetchMode mode, bool poll = false);
+  void start_async_fetch_(FetchMode mode);
+  void finish_fetch_(bool success, bool outdated = false);
+  void schedule_poll_(uint32_t delay);
+  void poll_();
+  uint32_t snapshot_config_hash_();
+  void restore_snapshot_();
+  bool is_snapshot_fresh_(uint32_t now);
+  uint32_t now_epoch_();
+  void schedule_snapshot_();
+  void save_snapshot_();
+  void save_snapshot_checked_at_();
+  bool prepare_request_(FetchMode mode, QueryRequest &request, QueryResult &result);
+  void execute_request_(const QueryRequest &request, QueryResult &result);
+  bool apply_result_(const QueryRequest &request, QueryResult &result);
+  void log_fetch_stats_();
+  void handle_rate_limit_(uint32_t retry_after);
+  void log_heap_(const char *stage);
+  bool add_pagination_cursor_to_query_(std::string &payload, const std::string &cursor);
+  bool add_watermark_to_query_(std::string &payload);
+  uint32_t process_response_(Stream &stream, size_t content_size, const QueryRequest &request, QueryResult &result);
+  const JsonDocument &get_page_filter_();
+  bool process_results_(StreamMonitor &stream, JsonDocument &doc, const QueryRequest &request, QueryResult &result,
+                        uint32_t &pages_hash);
+  uint32_t parse_page_(const JsonObject &pageJson, const QueryRequest &request, QueryResult &result);
+  bool parse_basic_property_(const JsonObject &property_obj, const QueryRequest &request, QueryResult &result,
+                             const std::string &property_name);
   bool validate_config_();
-  void check_changes_(const std::vector<Page, Allocator<Page>> &new_pages, uint32_t new_pages_hash);
+  bool check_changes_(PageTable &new_pages, uint32_t new_pages_hash);
+  void publish_pages_(PageTable &&pages);
+  void merge_pages_(PageTable &edited_pages);
+  void append_pages_(PageTable &more_pages);
+  void keep_appended_rows_(PageTable &new_pages, uint32_t &new_pages_hash);
+  uint32_t page_cache_key_(const std::string &cursor);
+  void cache_current_page_();
+  bool show_cached_page_();
+  void schedule_prefetch_();
+  void apply_source_();
 };
 
 template <typename... Ts>
@@ -0,0 +1,69 @@
+#include "page_cache.h"
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.page_cache";
+
+size_t PageCache::entry_size_(const Entry &entry) {
+  return sizeof(Entry) + entry.pages.memory_usage() + entry.next_cursor.capacity();
+}
+
+const PageCache::Entry *PageCache::find(uint32_t key) {
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->key == key) {
+      entries_.splice(entries_.begin(), entries_, it);
+      hits_++;
+      return &entries_.front();
+    }
+  }
+  misses_++;
+  return nullptr;
+}
+
+bool PageCache::contains(uint32_t key) const {
+  for (const auto &entry : entries_) {
+    if (entry.key == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageCache::put(uint32_t key, PageTable &&pages, uint32_t pages_hash, bool has_more,
+                    const std::string &next_cursor) {
+  if (max_entries_ == 0) {
+    return;
+  }
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->key == key) {
+      bytes_ -= entry_size_(*it);
+      entries_.erase(it);
+      break;
+    }
+  }
+
+  entries_.push_front(Entry{key, std::move(pages), pages_hash, has_more, next_cursor});
+  size_t size = entry_size_(entries_.front());
+  bytes_ += size;
+  if (size > max_bytes_) {
+    ESP_LOGD(TAG, "Page of %u bytes exceeds the cache budget of %u bytes", size, max_bytes_);
+  }
+
+  // The newest entry is dropped too if it alone exceeds the budget
+  while (!entries_.empty() && (entries_.size() > max_entries_ || bytes_ > max_bytes_)) {
+    bytes_ -= entry_size_(entries_.back());
+    entries_.pop_back();
+  }
+  ESP_LOGV(TAG, "%u entries, %u bytes", entries_.size(), bytes_);
+}
+
+void PageCache::clear() {
+  entries_.clear();
+  bytes_ = 0;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,68 @@
+#pragma once
+/**
+ * @file page_cache.h
+ * @brief Keeps recently fetched cursor pages of a query.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "page_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief A least recently used cache of query result pages.
+ *
+ * Entries are keyed by a hash of the query and the start cursor, and hold the parsed pages
+ * together with the pagination state that followed them. The cache is bounded by both an entry
+ * count and a byte budget; the least recently used entries are dropped first. The tables share
+ * the symbol table of the database, so the cache must be cleared whenever that is.
+ */
+class PageCache {
+ public:
+  struct Entry {
+    uint32_t key;
+    PageTable pages;
+    uint32_t pages_hash;
+    bool has_more;
+    std::string next_cursor;
+  };
+
+  // Sets the maximum number of entries; 0 disables the cache
+  void set_max_entries(size_t max_entries) { max_entries_ = max_entries; }
+  // Sets the maximum number of bytes held by the cached tables
+  void set_max_bytes(size_t max_bytes) { max_bytes_ = max_bytes; }
+  bool is_enabled() const { return max_entries_ > 0; }
+
+  // Returns the entry with the given key and marks it as most recently used, or nullptr
+  const Entry *find(uint32_t key);
+  // Returns whether an entry with the given key is cached, without touching its age
+  bool contains(uint32_t key) const;
+  // Adds or replaces an entry, evicting old entries to stay within the limits
+  void put(uint32_t key, PageTable &&pages, uint32_t pages_hash, bool has_more, const std::string &next_cursor);
+  // Removes all entries
+  void clear();
+
+  size_t size() const { return entries_.size(); }
+  size_t memory_usage() const { return bytes_; }
+  uint32_t get_hits() const { return hits_; }
+  uint32_t get_misses() const { return misses_; }
+
+ protected:
+  static size_t entry_size_(const Entry &entry);
+
+  // Most recently used first
+  std::list<Entry> entries_;
+  size_t max_entries_{0};
+  size_t max_bytes_{0};
+  size_t bytes_{0};
+  uint32_t hits_{0};
+  uint32_t misses_{0};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
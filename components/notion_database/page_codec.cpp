@@ -0,0 +1,344 @@
+#include "page_codec.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace notion_database {
+
+// Whole numbers in this range are written as varints; anything else as a double
+static const double MAX_VARINT_NUMBER = 1 << 30;
+
+void ByteWriter::u32(uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out_.push_back(value >> (8 * i));
+  }
+}
+
+void ByteWriter::varint(uint32_t value) {
+  while (value >= 0x80) {
+    out_.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out_.push_back(value);
+}
+
+void ByteWriter::f64(double value) {
+  uint8_t bytes[sizeof(double)];
+  std::memcpy(bytes, &value, sizeof(bytes));
+  out_.insert(out_.end(), bytes, bytes + sizeof(bytes));
+}
+
+void ByteWriter::str(const char *text) {
+  size_t len = std::strlen(text);
+  varint(len);
+  if (len > 0) {
+    out_.insert(out_.end(), text, text + len + 1);
+  }
+}
+
+bool ByteReader::take_(size_t size) {
+  if (!ok_ || static_cast<size_t>(end_ - pos_) < size) {
+    ok_ = false;
+    return false;
+  }
+  pos_ += size;
+  return true;
+}
+
+uint8_t ByteReader::u8() { return take_(1) ? pos_[-1] : 0; }
+
+uint32_t ByteReader::u32() {
+  if (!take_(4)) {
+    return 0;
+  }
+  return pos_[-4] | (pos_[-3] << 8) | (pos_[-2] << 16) | (static_cast<uint32_t>(pos_[-1]) << 24);
+}
+
+uint32_t ByteReader::varint() {
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    uint8_t byte = u8();
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  // More than five bytes is not a 32-bit varint
+  ok_ = false;
+  return 0;
+}
+
+double ByteReader::f64() {
+  double value = 0.0;
+  if (take_(sizeof(double))) {
+    std::memcpy(&value, pos_ - sizeof(double), sizeof(double));
+  }
+  return value;
+}
+
+const char *ByteReader::str() {
+  uint32_t len = varint();
+  if (len == 0 || !take_(len + 1)) {
+    return "";
+  }
+  const char *text = reinterpret_cast<const char *>(pos_ - len - 1);
+  // An embedded or missing NUL would make the text disagree with its length
+  if (text[len] != '\0' || std::memchr(text, '\0', len) != nullptr) {
+    ok_ = false;
+    return "";
+  }
+  return text;
+}
+
+// Numbers the symbols the rows use in the order they first appear, starting at 1; returns the
+// stored ID of each, and sets ids to the dense ID of every stored one, or EMPTY if unused
+static std::vector<uint16_t> collect_symbols(const PageTable &pages, std::vector<uint16_t> &ids) {
+  std::vector<uint16_t> used;
+  const SymbolTable *symbols = pages.get_symbols().get();
+  ids.assign(symbols != nullptr ? symbols->size() : 1, uint16_t{SymbolTable::EMPTY});
+  auto use = [&](uint16_t id) {
+    if (id != SymbolTable::EMPTY && id < ids.size() && ids[id] == SymbolTable::EMPTY) {
+      used.push_back(id);
+      ids[id] = used.size();
+    }
+  };
+  const auto &columns = pages.columns();
+  for (size_t row = 0; row < pages.size(); row++) {
+    for (const auto &column : columns) {
+      if (column.type == NotionPropertyType::SELECT || column.type == NotionPropertyType::STATUS) {
+        use(column.slots[row]);
+      } else if (column.type == NotionPropertyType::MULTI_SELECT) {
+        uint32_t offset = column.slots[row];
+        for (uint32_t item = 0; item < pages.item_count_at(offset); item++) {
+          use(pages.item_at(offset, item));
+        }
+      }
+    }
+  }
+  return used;
+}
+
+void encode_page_set(const PageTable &pages, ByteWriter &writer) {
+  // The symbol table is shared by every table of a generation, so only the symbols these rows use
+  // are written, renumbered densely
+  std::vector<uint16_t> ids;
+  std::vector<uint16_t> used = collect_symbols(pages, ids);
+  writer.varint(used.size());
+  for (uint16_t id : used) {
+    writer.str(pages.symbol_at(id));
+  }
+
+  const auto &columns = pages.columns();
+  writer.varint(columns.size());
+  for (const auto &column : columns) {
+    writer.u32(column.key);
+    writer.u8(static_cast<uint8_t>(column.type));
+  }
+
+  std::vector<uint32_t> epochs(columns.size(), 0);
+  writer.varint(pages.size());
+  for (size_t row = 0; row < pages.size(); row++) {
+    // Keys and hashes are hashes, which varints would only make longer
+    writer.u32(pages.row_key(row));
+    writer.u32(pages.row_hash(row));
+    for (size_t i = 0; i < columns.size(); i++) {
+      const auto &column = columns[i];
+      switch (column.type) {
+        case NotionPropertyType::NUMBER: {
+          double value = column.numbers[row];
+          // The low bit tags a double; negative zero is one too, as a varint would lose its sign
+          if (value == std::floor(value) && std::fabs(value) < MAX_VARINT_NUMBER &&
+              !(value == 0 && std::signbit(value))) {
+            writer.varint(zigzag_encode(static_cast<int32_t>(value)) << 1);
+          } else {
+            writer.varint(1);
+            writer.f64(value);
+          }
+          break;
+        }
+        case NotionPropertyType::CHECKBOX:
+          writer.u8(column.flags[row]);
+          break;
+        case NotionPropertyType::DATE:
+        case NotionPropertyType::CREATED_TIME:
+        case NotionPropertyType::LAST_EDITED_TIME:
+          // Wrapping arithmetic keeps any two times one int32 apart
+          writer.zigzag(static_cast<int32_t>(column.slots[row] - epochs[i]));
+          epochs[i] = column.slots[row];
+          break;
+        case NotionPropertyType::SELECT:
+        case NotionPropertyType::STATUS:
+          writer.varint(ids[column.slots[row]]);
+          break;
+        case NotionPropertyType::MULTI_SELECT: {
+          uint32_t offset = column.slots[row];
+          uint32_t count = pages.item_count_at(offset);
+          writer.varint(count);
+          for (uint32_t item = 0; item < count; item++) {
+            writer.varint(ids[pages.item_at(offset, item)]);
+          }
+          break;
+        }
+        default:
+          writer.str(pages.string_at(column.slots[row]));
+          break;
+      }
+    }
+  }
+}
+
+bool PageSetReader::open(ByteReader &reader) {
+  reader_ = &reader;
+  symbols_.clear();
+  columns_.clear();
+  row_ = 0;
+  column_ = 0;
+
+  // A bogus count runs out of data long before it runs out of memory
+  uint32_t symbol_count = reader.varint();
+  symbols_.push_back("");
+  for (uint32_t i = 0; i < symbol_count && reader.ok(); i++) {
+    symbols_.push_back(reader.str());
+  }
+  if (symbols_.size() > SymbolTable::MAX_SYMBOLS) {
+    reader.fail();
+  }
+
+  uint32_t column_count = reader.varint();
+  for (uint32_t i = 0; i < column_count && reader.ok(); i++) {
+    uint32_t key = reader.u32();
+    uint8_t type = reader.u8();
+    if (type >= static_cast<uint8_t>(NotionPropertyType::UNKNOWN)) {
+      reader.fail();
+    }
+    columns_.push_back(Column{key, static_cast<NotionPropertyType>(type)});
+  }
+  epochs_.assign(columns_.size(), 0);
+  rows_ = reader.varint();
+  return reader.ok();
+}
+
+const char *PageSetReader::symbol(uint16_t id) const { return id < symbols_.size() ? symbols_[id] : ""; }
+
+bool PageSetReader::next_row() {
+  if (row_ >= rows_ || !reader_->ok()) {
+    return false;
+  }
+  row_++;
+  column_ = 0;
+  row_key_ = reader_->u32();
+  row_hash_ = reader_->u32();
+  return reader_->ok();
+}
+
+uint16_t PageSetReader::read_symbol_() {
+  uint32_t symbol = reader_->varint();
+  if (symbol >= symbols_.size()) {
+    reader_->fail();
+    return SymbolTable::EMPTY;
+  }
+  return symbol;
+}
+
+bool PageSetReader::next_cell(PageSetCell &cell) {
+  if (column_ >= columns_.size()) {
+    return false;
+  }
+  size_t i = column_++;
+  cell.type = columns_[i].type;
+  switch (cell.type) {
+    case NotionPropertyType::NUMBER: {
+      uint32_t tag = reader_->varint();
+      cell.number = (tag & 1) != 0 ? reader_->f64() : zigzag_decode(tag >> 1);
+      break;
+    }
+    case NotionPropertyType::CHECKBOX:
+      cell.flag = reader_->u8() != 0;
+      break;
+    case NotionPropertyType::DATE:
+    case NotionPropertyType::CREATED_TIME:
+    case NotionPropertyType::LAST_EDITED_TIME:
+      epochs_[i] += static_cast<uint32_t>(reader_->zigzag());
+      cell.epoch = static_cast<int32_t>(epochs_[i]);
+      break;
+    case NotionPropertyType::SELECT:
+    case NotionPropertyType::STATUS:
+      cell.symbol = read_symbol_();
+      break;
+    case NotionPropertyType::MULTI_SELECT:
+      cell.item_count = reader_->varint();
+      break;
+    default:
+      cell.text = reader_->str();
+      break;
+  }
+  return reader_->ok();
+}
+
+uint16_t PageSetReader::next_item() { return read_symbol_(); }
+
+bool decode_page_set(ByteReader &reader, PageTable &pages, const std::shared_ptr<SymbolTable> &symbols) {
+  PageSetReader set;
+  if (!set.open(reader)) {
+    return false;
+  }
+
+  symbols->clear();
+  for (size_t id = 1; id < set.symbol_count(); id++) {
+    // Interning in order gives every symbol its encoded ID, unless the symbols repeat
+    if (symbols->intern(set.symbol(id)) != id) {
+      return false;
+    }
+  }
+  pages.clear();
+  pages.set_symbols(symbols);
+  for (size_t i = 0; i < set.columns().size(); i++) {
+    if (pages.get_or_add_column(set.columns()[i].key, set.columns()[i].type) != static_cast<int>(i)) {
+      return false;
+    }
+  }
+
+  PageSetCell cell;
+  while (set.next_row()) {
+    pages.add_row();
+    pages.set_row_key(set.row_key());
+    pages.set_row_hash(set.row_hash());
+    for (uint16_t column = 0; set.next_cell(cell); column++) {
+      switch (cell.type) {
+        case NotionPropertyType::NUMBER:
+          pages.set_number(column, cell.number);
+          break;
+        case NotionPropertyType::CHECKBOX:
+          pages.set_bool(column, cell.flag);
+          break;
+        case NotionPropertyType::DATE:
+        case NotionPropertyType::CREATED_TIME:
+        case NotionPropertyType::LAST_EDITED_TIME:
+          pages.set_epoch(column, cell.epoch);
+          break;
+        case NotionPropertyType::SELECT:
+        case NotionPropertyType::STATUS:
+          pages.set_symbol(column, cell.symbol);
+          break;
+        case NotionPropertyType::MULTI_SELECT:
+          pages.begin_items(column);
+          for (uint16_t item = 0; item < cell.item_count && reader.ok(); item++) {
+            pages.add_item(set.next_item());
+          }
+          break;
+        default:
+          pages.set_text(column, cell.text);
+          break;
+      }
+    }
+  }
+  if (!reader.ok() || pages.size() != set.row_count()) {
+    pages.clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
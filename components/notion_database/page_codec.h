@@ -0,0 +1,150 @@
+#pragma once
+/**
+ * @file page_codec.h
+ * @brief Compact binary encoding of a PageTable, and a reader that decodes it in place.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "page_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+// Maps signed values to unsigned ones so that small magnitudes of either sign stay small
+inline uint32_t zigzag_encode(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+inline int32_t zigzag_decode(uint32_t value) { return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1)); }
+
+/**
+ * @brief Appends little-endian integers, LEB128 varints and strings to a buffer.
+ *
+ * Strings are a varint length followed by the bytes and a NUL, so that a reader can hand out
+ * pointers into the buffer; the empty string is the length 0 alone.
+ */
+class ByteWriter {
+ public:
+  explicit ByteWriter(std::vector<uint8_t> &out) : out_(out) {}
+
+  void u8(uint8_t value) { out_.push_back(value); }
+  void u32(uint32_t value);
+  void varint(uint32_t value);
+  void zigzag(int32_t value) { varint(zigzag_encode(value)); }
+  void f64(double value);
+  void str(const char *text);
+  size_t size() const { return out_.size(); }
+
+ protected:
+  std::vector<uint8_t> &out_;
+};
+
+/**
+ * @brief Reads what ByteWriter wrote, without copying.
+ *
+ * Once a read runs past the end or finds malformed data, the reader fails and every later read
+ * returns zero or the empty string, so callers check ok() once after a batch of reads.
+ */
+class ByteReader {
+ public:
+  ByteReader(const uint8_t *data, size_t size) : pos_(data), end_(data + size) {}
+
+  bool ok() const { return ok_; }
+  bool at_end() const { return pos_ == end_; }
+  void fail() { ok_ = false; }
+
+  uint8_t u8();
+  uint32_t u32();
+  uint32_t varint();
+  int32_t zigzag() { return zigzag_decode(varint()); }
+  double f64();
+  // Returns a NUL-terminated string within the buffer
+  const char *str();
+
+ protected:
+  bool take_(size_t size);
+
+  const uint8_t *pos_;
+  const uint8_t *end_;
+  bool ok_{true};
+};
+
+// One decoded cell; strings point into the encoded buffer
+struct PageSetCell {
+  NotionPropertyType type{NotionPropertyType::UNKNOWN};
+  const char *text{""};
+  double number{0.0};
+  int32_t epoch{0};
+  bool flag{false};
+  uint16_t symbol{SymbolTable::EMPTY};
+  // Number of MULTI_SELECT items, read with PageSetReader::next_item()
+  uint16_t item_count{0};
+};
+
+/**
+ * @brief Encodes the pages of a table.
+ *
+ * The encoding is the symbols the rows use, the schema as one key and type tag per column, and
+ * then the rows, each with its key, hash and one cell per column. Symbols are renumbered from 1
+ * in the order the rows first use them. Symbol IDs are varints, and times are zigzag varint
+ * deltas from the same column of the previous row, so a sorted date column costs a byte or two
+ * per row. Whole numbers are varints too, with a tag bit for the rest.
+ */
+void encode_page_set(const PageTable &pages, ByteWriter &writer);
+
+/**
+ * @brief Walks an encoded page set in place.
+ *
+ * Only the offsets of the symbols are kept; every other value is decoded on the fly as the rows
+ * and cells are read in order, so reading allocates nothing per row or cell. The buffer must
+ * outlive the reader.
+ */
+class PageSetReader {
+ public:
+  struct Column {
+    uint32_t key;
+    NotionPropertyType type;
+  };
+
+  // Reads the symbols and the schema; returns false if they are malformed
+  bool open(ByteReader &reader);
+
+  size_t symbol_count() const { return symbols_.size(); }
+  // Returns the text of a symbol ID, or the empty string
+  const char *symbol(uint16_t id) const;
+  const std::vector<Column> &columns() const { return columns_; }
+  size_t row_count() const { return rows_; }
+
+  // Moves to the next row once every cell of the current one has been read; returns false after the
+  // last row or on malformed data
+  bool next_row();
+  uint32_t row_key() const { return row_key_; }
+  uint32_t row_hash() const { return row_hash_; }
+  // Reads the cell of the next column of the current row
+  bool next_cell(PageSetCell &cell);
+  // Reads the next symbol ID of the MULTI_SELECT cell just read; every item must be read before the next cell
+  uint16_t next_item();
+
+ protected:
+  uint16_t read_symbol_();
+
+  ByteReader *reader_{nullptr};
+  // Symbol ID 0 is the empty string and is not encoded
+  std::vector<const char *> symbols_;
+  std::vector<Column> columns_;
+  // Previous time of each column, for the deltas
+  std::vector<uint32_t> epochs_;
+  size_t rows_{0};
+  size_t row_{0};
+  size_t column_{0};
+  uint32_t row_key_{0};
+  uint32_t row_hash_{0};
+};
+
+// Decodes an encoded page set into a table, interning its symbols into an empty symbol table
+bool decode_page_set(ByteReader &reader, PageTable &pages, const std::shared_ptr<SymbolTable> &symbols);
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,304 @@
+#include "page_table.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace notion_database {
+
+// Returns the property type
+NotionPropertyType NotionProperty::type() const { return table_->column(column_).type; }
+
+// Returns the text of text-like properties
+const char *NotionProperty::string_value() const {
+  switch (type()) {
+    case NotionPropertyType::NUMBER:
+    case NotionPropertyType::CHECKBOX:
+    case NotionPropertyType::DATE:
+    case NotionPropertyType::CREATED_TIME:
+    case NotionPropertyType::LAST_EDITED_TIME:
+    case NotionPropertyType::MULTI_SELECT:
+      return "";
+    case NotionPropertyType::SELECT:
+    case NotionPropertyType::STATUS:
+      return table_->symbol_at(symbol_value());
+    default:
+      return table_->string_at(table_->column(column_).slots[row_]);
+  }
+}
+
+// Returns the symbol ID of SELECT and STATUS properties
+uint16_t NotionProperty::symbol_value() const {
+  const auto &slots = table_->column(column_).slots;
+  return slots.empty() ? SymbolTable::EMPTY : slots[row_];
+}
+
+// Returns the value of NUMBER properties
+double NotionProperty::number_value() const {
+  const auto &numbers = table_->column(column_).numbers;
+  return numbers.empty() ? 0.0 : numbers[row_];
+}
+
+// Returns the value of CHECKBOX properties
+bool NotionProperty::bool_value() const {
+  const auto &flags = table_->column(column_).flags;
+  return flags.empty() ? false : flags[row_];
+}
+
+// Returns the seconds since epoch of time properties
+int32_t NotionProperty::epoch_value() const {
+  const auto &slots = table_->column(column_).slots;
+  return slots.empty() ? 0 : static_cast<int32_t>(slots[row_]);
+}
+
+// Returns the local time of time properties
+std::tm NotionProperty::time_value() const {
+  time_t epoch = epoch_value();
+  std::tm tm_time;
+  localtime_r(&epoch, &tm_time);
+  return tm_time;
+}
+
+// Returns the number of MULTI_SELECT items
+size_t NotionProperty::item_count() const {
+  if (type() != NotionPropertyType::MULTI_SELECT) return 0;
+  return table_->item_count_at(table_->column(column_).slots[row_]);
+}
+
+// Returns the MULTI_SELECT item at index
+const char *NotionProperty::item(size_t index) const { return table_->symbol_at(item_symbol(index)); }
+
+// Returns the symbol ID of the MULTI_SELECT item at index
+uint16_t NotionProperty::item_symbol(size_t index) const {
+  return table_->item_at(table_->column(column_).slots[row_], index);
+}
+
+// Returns the property with the given key hash
+NotionProperty Page::get_property(uint32_t key) const {
+  int column = table_->find_column(key);
+  if (column < 0) return NotionProperty();
+  return NotionProperty(table_, column, row_);
+}
+
+PageTable::PageTable(MemoryPlacement placement)
+    : placement_(placement),
+      columns_(Allocator<Column>(placement)),
+      row_hashes_(Allocator<uint32_t>(placement)),
+      row_keys_(Allocator<uint32_t>(placement)),
+      strings_(Allocator<char>(placement)),
+      items_(Allocator<uint32_t>(placement)) {
+  clear();
+}
+
+// Returns the index of the column with the given key, or -1
+int PageTable::find_column(uint32_t key) const {
+  for (size_t i = 0; i < columns_.size(); i++) {
+    if (columns_[i].key == key) return i;
+  }
+  return -1;
+}
+
+// Returns the index of the column with the given key, adding it if needed
+int PageTable::get_or_add_column(uint32_t key, NotionPropertyType type) {
+  int index = find_column(key);
+  if (index >= 0) {
+    return columns_[index].type == type ? index : -1;
+  }
+
+  Column column(key, type, placement_);
+  switch (type) {
+    case NotionPropertyType::NUMBER:
+      column.numbers.resize(rows_, 0.0);
+      break;
+    case NotionPropertyType::CHECKBOX:
+      column.flags.resize(rows_, false);
+      break;
+    default:
+      column.slots.resize(rows_, 0);
+      break;
+  }
+  columns_.push_back(std::move(column));
+  return columns_.size() - 1;
+}
+
+// Returns the index of the row with the given key, or -1
+int PageTable::find_row(uint32_t key) const {
+  for (size_t i = 0; i < rows_; i++) {
+    if (row_keys_[i] == key) return i;
+  }
+  return -1;
+}
+
+// Appends a row with default values
+uint32_t PageTable::add_row() {
+  for (auto &column : columns_) {
+    switch (column.type) {
+      case NotionPropertyType::NUMBER:
+        column.numbers.push_back(0.0);
+        break;
+      case NotionPropertyType::CHECKBOX:
+        column.flags.push_back(false);
+        break;
+      default:
+        column.slots.push_back(0);
+        break;
+    }
+  }
+  row_hashes_.push_back(0);
+  row_keys_.push_back(0);
+  return rows_++;
+}
+
+// Appends a copy of a row of another table
+uint32_t PageTable::copy_row(const PageTable &source, uint32_t row) {
+  uint32_t index = add_row();
+  set_row_hash(source.row_hash(row));
+  set_row_key(source.row_key(row));
+  for (const auto &src : source.columns()) {
+    int col = get_or_add_column(src.key, src.type);
+    if (col < 0) continue;
+
+    switch (src.type) {
+      case NotionPropertyType::NUMBER:
+        set_number(col, src.numbers[row]);
+        break;
+      case NotionPropertyType::CHECKBOX:
+        set_bool(col, src.flags[row]);
+        break;
+      case NotionPropertyType::DATE:
+      case NotionPropertyType::CREATED_TIME:
+      case NotionPropertyType::LAST_EDITED_TIME:
+      case NotionPropertyType::SELECT:
+      case NotionPropertyType::STATUS:
+        columns_[col].slots.back() = src.slots[row];
+        break;
+      case NotionPropertyType::MULTI_SELECT: {
+        uint32_t offset = src.slots[row];
+        begin_items(col);
+        for (uint32_t i = 0; i < source.item_count_at(offset); i++) {
+          add_item(source.item_at(offset, i));
+        }
+        break;
+      }
+      default:
+        set_text(col, source.string_at(src.slots[row]));
+        break;
+    }
+  }
+  return index;
+}
+
+// Sets the text of a cell in the last row
+void PageTable::set_text(uint16_t column, const char *text) { columns_[column].slots.back() = add_string_(text); }
+
+// Appends text to a cell in the last row
+void PageTable::append_text(uint16_t column, const char *text) {
+  uint32_t &slot = columns_[column].slots.back();
+  if (slot == 0) {
+    slot = add_string_(text);
+    return;
+  }
+  size_t len = std::strlen(text);
+  strings_.pop_back();
+  strings_.insert(strings_.end(), text, text + len);
+  strings_.push_back('\0');
+}
+
+// Sets the number of a cell in the last row
+void PageTable::set_number(uint16_t column, double value) { columns_[column].numbers.back() = value; }
+
+// Sets the checkbox of a cell in the last row
+void PageTable::set_bool(uint16_t column, bool value) { columns_[column].flags.back() = value; }
+
+// Sets the epoch of a cell in the last row
+void PageTable::set_epoch(uint16_t column, int32_t epoch) {
+  columns_[column].slots.back() = static_cast<uint32_t>(epoch);
+}
+
+// Sets the symbol ID of a cell in the last row
+void PageTable::set_symbol(uint16_t column, uint16_t symbol) { columns_[column].slots.back() = symbol; }
+
+// Starts an empty item list in a cell of the last row
+void PageTable::begin_items(uint16_t column) {
+  open_items_ = items_.size();
+  items_.push_back(0);
+  columns_[column].slots.back() = open_items_;
+}
+
+// Appends a symbol ID to the open item list
+void PageTable::add_item(uint16_t symbol) {
+  items_.push_back(symbol);
+  items_[open_items_]++;
+}
+
+// Returns whether two cells of the same type hold the same value
+bool PageTable::cell_equals(const PageTable &a, uint16_t a_column, uint32_t a_row, const PageTable &b,
+                            uint16_t b_column, uint32_t b_row) {
+  const Column &a_col = a.column(a_column);
+  const Column &b_col = b.column(b_column);
+  switch (a_col.type) {
+    case NotionPropertyType::NUMBER:
+      return a_col.numbers[a_row] == b_col.numbers[b_row];
+    case NotionPropertyType::CHECKBOX:
+      return a_col.flags[a_row] == b_col.flags[b_row];
+    case NotionPropertyType::DATE:
+    case NotionPropertyType::CREATED_TIME:
+    case NotionPropertyType::LAST_EDITED_TIME:
+      return a_col.slots[a_row] == b_col.slots[b_row];
+    case NotionPropertyType::SELECT:
+    case NotionPropertyType::STATUS:
+      // Tables sharing a symbol table compare IDs; others compare the text
+      if (a.symbols_ == b.symbols_) return a_col.slots[a_row] == b_col.slots[b_row];
+      return std::strcmp(a.symbol_at(a_col.slots[a_row]), b.symbol_at(b_col.slots[b_row])) == 0;
+    case NotionPropertyType::MULTI_SELECT: {
+      uint32_t a_offset = a_col.slots[a_row];
+      uint32_t b_offset = b_col.slots[b_row];
+      uint32_t count = a.item_count_at(a_offset);
+      if (count != b.item_count_at(b_offset)) return false;
+      for (uint32_t i = 0; i < count; i++) {
+        uint16_t a_item = a.item_at(a_offset, i);
+        uint16_t b_item = b.item_at(b_offset, i);
+        if (a.symbols_ == b.symbols_ ? a_item != b_item : std::strcmp(a.symbol_at(a_item), b.symbol_at(b_item)) != 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      return std::strcmp(a.string_at(a_col.slots[a_row]), b.string_at(b_col.slots[b_row])) == 0;
+  }
+}
+
+// Removes all rows and columns
+void PageTable::clear() {
+  rows_ = 0;
+  columns_.clear();
+  row_hashes_.clear();
+  row_keys_.clear();
+  strings_.clear();
+  strings_.push_back('\0');
+  items_.clear();
+  items_.push_back(0);
+  open_items_ = 0;
+}
+
+// Returns the approximate number of bytes held by the table
+size_t PageTable::memory_usage() const {
+  size_t size = sizeof(PageTable) + strings_.capacity() + items_.capacity() * sizeof(uint32_t) +
+                (row_hashes_.capacity() + row_keys_.capacity()) * sizeof(uint32_t);
+  for (const auto &column : columns_) {
+    size += sizeof(Column) + column.slots.capacity() * sizeof(uint32_t) + column.numbers.capacity() * sizeof(double) +
+            column.flags.capacity() / 8;
+  }
+  return size;
+}
+
+// Adds a NUL-terminated string to the arena
+uint32_t PageTable::add_string_(const char *text) {
+  if (text == nullptr || *text == '\0') return 0;
+  uint32_t offset = strings_.size();
+  strings_.insert(strings_.end(), text, text + std::strlen(text) + 1);
+  return offset;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,232 @@
+#pragma once
+/**
+ * @file page_table.h
+ * @brief Columnar storage for the pages returned by a Notion database query.
+ */
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allocator.h"
+#include "symbol_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+enum class NotionPropertyType {
+  TITLE,
+  RICH_TEXT,
+  NUMBER,
+  DATE,
+  CHECKBOX,
+  SELECT,
+  MULTI_SELECT,
+  CREATED_BY,
+  CREATED_TIME,
+  EMAIL,
+  FILES,
+  FORMULA,
+  LAST_EDITED_BY,
+  LAST_EDITED_TIME,
+  PEOPLE,
+  PHONE_NUMBER,
+  RELATION,
+  ROLLUP,
+  STATUS,
+  URL,
+  UNKNOWN
+};
+
+class PageTable;
+
+/**
+ * @brief Read-only view of one property (cell) of a page stored in a PageTable.
+ *
+ * A default constructed view refers to no property and converts to false.
+ */
+class NotionProperty {
+ public:
+  NotionProperty() = default;
+  NotionProperty(const PageTable *table, uint16_t column, uint32_t row) : table_(table), column_(column), row_(row) {}
+
+  explicit operator bool() const { return table_ != nullptr; }
+
+  // Returns the property type
+  NotionPropertyType type() const;
+  // Returns the text of TITLE, RICH_TEXT, SELECT, STATUS, EMAIL, PHONE_NUMBER and URL properties
+  const char *string_value() const;
+  // Returns the symbol ID of SELECT and STATUS properties
+  uint16_t symbol_value() const;
+  // Returns the value of NUMBER properties
+  double number_value() const;
+  // Returns the value of CHECKBOX properties
+  bool bool_value() const;
+  // Returns the seconds since epoch of DATE, CREATED_TIME and LAST_EDITED_TIME properties
+  int32_t epoch_value() const;
+  // Returns the local time of DATE, CREATED_TIME and LAST_EDITED_TIME properties
+  std::tm time_value() const;
+  // Returns the number of MULTI_SELECT items
+  size_t item_count() const;
+  // Returns the MULTI_SELECT item at index
+  const char *item(size_t index) const;
+  // Returns the symbol ID of the MULTI_SELECT item at index
+  uint16_t item_symbol(size_t index) const;
+
+ protected:
+  const PageTable *table_{nullptr};
+  uint16_t column_{0};
+  uint32_t row_{0};
+};
+
+/**
+ * @brief Read-only view of one page (row) stored in a PageTable.
+ */
+class Page {
+ public:
+  Page(const PageTable *table, uint32_t row) : table_(table), row_(row) {}
+
+  static uint32_t hash_key(const std::string &key) { return static_cast<uint32_t>(std::hash<std::string>{}(key)); }
+
+  // Returns the property with the given name, or an empty view if the page has none
+  NotionProperty get_property(const std::string &key) const { return get_property(hash_key(key)); }
+  NotionProperty get_property(uint32_t key) const;
+
+  // Returns the row index of the page
+  uint32_t index() const { return row_; }
+
+ protected:
+  const PageTable *table_;
+  uint32_t row_;
+};
+
+/**
+ * @brief Stores pages column by column.
+ *
+ * The schema is a list of columns (property name hash and type) shared by every row. Each
+ * column keeps one typed array: epochs, string offsets, symbol IDs and item list offsets in
+ * `slots`, numbers in `numbers` and checkboxes in the `flags` bitset. Free text lives
+ * NUL-terminated in one string arena, so a whole query result is held in a handful of
+ * allocations. SELECT, STATUS and MULTI_SELECT values are IDs into a SymbolTable that the
+ * table shares with the other tables built from the same responses and keeps alive.
+ *
+ * Rows are built one at a time: add_row() appends a row with default values, and the set_*
+ * methods fill the cells of that last row.
+ */
+class PageTable {
+ public:
+  struct Column {
+    Column(uint32_t key, NotionPropertyType type, MemoryPlacement placement)
+        : key(key), type(type), slots(Allocator<uint32_t>(placement)), numbers(Allocator<double>(placement)),
+          flags(Allocator<bool>(placement)) {}
+
+    uint32_t key;
+    NotionPropertyType type;
+    std::vector<uint32_t, Allocator<uint32_t>> slots;
+    std::vector<double, Allocator<double>> numbers;
+    std::vector<bool, Allocator<bool>> flags;
+  };
+
+  class Iterator {
+   public:
+    Iterator(const PageTable *table, uint32_t row) : table_(table), row_(row) {}
+    Page operator*() const { return Page(table_, row_); }
+    Iterator &operator++() {
+      ++row_;
+      return *this;
+    }
+    bool operator!=(const Iterator &other) const { return row_ != other.row_; }
+
+   protected:
+    const PageTable *table_;
+    uint32_t row_;
+  };
+
+  explicit PageTable(MemoryPlacement placement = MemoryPlacement::PSRAM);
+
+  // Returns the number of rows
+  size_t size() const { return rows_; }
+  bool empty() const { return rows_ == 0; }
+  Page operator[](size_t row) const { return Page(this, row); }
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, rows_); }
+
+  // Returns the columns of the schema
+  const std::vector<Column, Allocator<Column>> &columns() const { return columns_; }
+  // Returns the index of the column with the given key, or -1
+  int find_column(uint32_t key) const;
+  // Returns the index of the column with the given key, adding it if needed, or -1 on a type mismatch
+  int get_or_add_column(uint32_t key, NotionPropertyType type);
+
+  // Appends a row with default values and returns its index
+  uint32_t add_row();
+  // Appends a copy of a row of another table whose symbols are a subset of this table's, with the same IDs
+  uint32_t copy_row(const PageTable &source, uint32_t row);
+  // Sets the hash of the last row, derived from its ID and last edited time
+  void set_row_hash(uint32_t hash) { row_hashes_.back() = hash; }
+  // Sets the key of the last row, derived from its page ID
+  void set_row_key(uint32_t key) { row_keys_.back() = key; }
+  // Returns the index of the row with the given key, or -1
+  int find_row(uint32_t key) const;
+  // Sets the text of a cell in the last row
+  void set_text(uint16_t column, const char *text);
+  // Appends text to a cell in the last row; the cell must hold the most recently written string
+  void append_text(uint16_t column, const char *text);
+  // Sets the number of a cell in the last row
+  void set_number(uint16_t column, double value);
+  // Sets the checkbox of a cell in the last row
+  void set_bool(uint16_t column, bool value);
+  // Sets the epoch of a cell in the last row
+  void set_epoch(uint16_t column, int32_t epoch);
+  // Sets the symbol ID of a cell in the last row
+  void set_symbol(uint16_t column, uint16_t symbol);
+  // Starts an empty item list in a cell of the last row
+  void begin_items(uint16_t column);
+  // Appends a symbol ID to the list most recently started with begin_items()
+  void add_item(uint16_t symbol);
+
+  // Returns whether a cell holds the same value as a cell of the same type in another table
+  static bool cell_equals(const PageTable &a, uint16_t a_column, uint32_t a_row, const PageTable &b, uint16_t b_column,
+                          uint32_t b_row);
+
+  // Sets the symbol table used to resolve symbol IDs
+  void set_symbols(std::shared_ptr<const SymbolTable> symbols) { symbols_ = std::move(symbols); }
+  const std::shared_ptr<const SymbolTable> &get_symbols() const { return symbols_; }
+
+  // Removes all rows and columns
+  void clear();
+  // Returns the approximate number of bytes held by the table
+  size_t memory_usage() const;
+  // Returns where the table allocates its storage
+  MemoryPlacement placement() const { return placement_; }
+
+  // Cell accessors used by the views
+  const Column &column(uint16_t column) const { return columns_[column]; }
+  uint32_t row_hash(uint32_t row) const { return row_hashes_[row]; }
+  uint32_t row_key(uint32_t row) const { return row_keys_[row]; }
+  const char *string_at(uint32_t offset) const { return strings_.data() + offset; }
+  const char *symbol_at(uint16_t symbol) const { return symbols_ != nullptr ? symbols_->lookup(symbol) : ""; }
+  uint32_t item_count_at(uint32_t offset) const { return items_[offset]; }
+  uint16_t item_at(uint32_t offset, size_t index) const { return items_[offset + 1 + index]; }
+
+ protected:
+  uint32_t add_string_(const char *text);
+
+  MemoryPlacement placement_;
+  size_t rows_{0};
+  std::vector<Column, Allocator<Column>> columns_;
+  std::vector<uint32_t, Allocator<uint32_t>> row_hashes_;
+  std::vector<uint32_t, Allocator<uint32_t>> row_keys_;
+  // NUL-terminated strings; offset 0 is the empty string
+  std::vector<char, Allocator<char>> strings_;
+  // Item lists stored as [count, symbol ID...]; offset 0 is the empty list
+  std::vector<uint32_t, Allocator<uint32_t>> items_;
+  uint32_t open_items_{0};
+  std::shared_ptr<const SymbolTable> symbols_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#include "rolling_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace notion_database {
+
+const char *statistic_to_string(Statistic statistic) {
+  switch (statistic) {
+    case Statistic::LAST:
+      return "last";
+    case Statistic::MIN:
+      return "min";
+    case Statistic::AVG:
+      return "avg";
+    case Statistic::P95:
+      return "p95";
+    case Statistic::MAX:
+      return "max";
+  }
+  return "unknown";
+}
+
+void RollingStats::set_window_size(size_t window_size) {
+  values_.assign(std::max<size_t>(window_size, 1), 0.0f);
+  next_ = 0;
+  count_ = 0;
+}
+
+void RollingStats::add(float value) {
+  if (values_.empty()) {
+    return;
+  }
+  values_[next_] = value;
+  next_ = (next_ + 1) % values_.size();
+  count_ = std::min(count_ + 1, values_.size());
+}
+
+float RollingStats::last() const { return values_[(next_ + values_.size() - 1) % values_.size()]; }
+
+float RollingStats::min() const { return *std::min_element(values_.begin(), values_.begin() + count_); }
+
+float RollingStats::max() const { return *std::max_element(values_.begin(), values_.begin() + count_); }
+
+float RollingStats::average() const {
+  float sum = 0.0f;
+  for (size_t i = 0; i < count_; i++) {
+    sum += values_[i];
+  }
+  return sum / count_;
+}
+
+float RollingStats::percentile(float p) const {
+  std::vector<float> sorted(values_.begin(), values_.begin() + count_);
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0f * count_));
+  size_t index = rank > 0 ? std::min(rank - 1, count_ - 1) : 0;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+float RollingStats::get(Statistic statistic) const {
+  if (count_ == 0) {
+    return NAN;
+  }
+  switch (statistic) {
+    case Statistic::LAST:
+      return last();
+    case Statistic::MIN:
+      return min();
+    case Statistic::AVG:
+      return average();
+    case Statistic::P95:
+      return percentile(95.0f);
+    case Statistic::MAX:
+      return max();
+  }
+  return NAN;
+}
+
+}  // namespace notion_database
+}  // namespace esphome
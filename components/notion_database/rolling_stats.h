@@ -0,0 +1,50 @@
+#pragma once
+/**
+ * @file rolling_stats.h
+ * @brief Summary statistics over the most recent samples of a measurement.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace notion_database {
+
+enum class Statistic : uint8_t { LAST, MIN, AVG, P95, MAX };
+
+const char *statistic_to_string(Statistic statistic);
+
+/**
+ * @brief Keeps the last N samples in a ring buffer.
+ *
+ * Samples are added whenever a measurement is taken and the statistics are computed when they
+ * are published, so adding a sample costs nothing but a store.
+ */
+class RollingStats {
+ public:
+  explicit RollingStats(size_t window_size = 20) : values_(window_size) {}
+
+  // Sets the number of samples kept; drops the samples taken so far
+  void set_window_size(size_t window_size);
+  void add(float value);
+  bool empty() const { return count_ == 0; }
+  size_t size() const { return count_; }
+
+  float last() const;
+  float min() const;
+  float max() const;
+  float average() const;
+  // Returns the nearest-rank percentile, p in [0, 100]
+  float percentile(float p) const;
+  // Returns a statistic, or NAN when there are no samples
+  float get(Statistic statistic) const;
+
+ protected:
+  std::vector<float> values_;
+  size_t next_{0};
+  size_t count_{0};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,94 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_BYTES,
+    UNIT_MILLISECOND,
+)
+from . import NotionDatabase, notion_database_ns
+
+DEPENDENCIES = ["notion_database"]
+
+NotionDatabaseSensor = notion_database_ns.class_("NotionDatabaseSensor", cg.PollingComponent)
+DatabaseMetric = notion_database_ns.enum("DatabaseMetric", is_class=True)
+Statistic = notion_database_ns.enum("Statistic", is_class=True)
+
+STATISTICS = {
+    "last": Statistic.LAST,
+    "min": Statistic.MIN,
+    "avg": Statistic.AVG,
+    "p95": Statistic.P95,
+    "max": Statistic.MAX,
+}
+
+CONF_NOTION_DATABASE_ID = "notion_database_id"
+CONF_WINDOW_SIZE = "window_size"
+CONF_STATISTIC = "statistic"
+CONF_CONNECT_TIME = "connect_time"
+CONF_REQUEST_TIME = "request_time"
+CONF_FIRST_BYTE_TIME = "first_byte_time"
+CONF_PARSE_TIME = "parse_time"
+CONF_APPLY_TIME = "apply_time"
+CONF_BYTES_READ = "bytes_read"
+CONF_PAGES = "pages"
+CONF_PARSE_HEAP = "parse_heap"
+CONF_LARGEST_FREE_BLOCK = "largest_free_block"
+CONF_CONSECUTIVE_FAILURES = "consecutive_failures"
+
+UNIT_PAGES = "pages"
+UNIT_FAILURES = "failures"
+
+SENSORS = {
+    CONF_CONNECT_TIME: (DatabaseMetric.CONNECT_TIME, UNIT_MILLISECOND, "mdi:timer-outline", 1, "avg"),
+    CONF_REQUEST_TIME: (DatabaseMetric.REQUEST_TIME, UNIT_MILLISECOND, "mdi:timer-outline", 1, "avg"),
+    CONF_FIRST_BYTE_TIME: (DatabaseMetric.FIRST_BYTE_TIME, UNIT_MILLISECOND, "mdi:timer-outline", 1, "avg"),
+    CONF_PARSE_TIME: (DatabaseMetric.PARSE_TIME, UNIT_MILLISECOND, "mdi:timer-outline", 1, "avg"),
+    CONF_APPLY_TIME: (DatabaseMetric.APPLY_TIME, UNIT_MILLISECOND, "mdi:timer-outline", 1, "avg"),
+    CONF_BYTES_READ: (DatabaseMetric.BYTES_READ, UNIT_BYTES, "mdi:download", 0, "last"),
+    CONF_PAGES: (DatabaseMetric.PAGES, UNIT_PAGES, "mdi:table-row", 0, "last"),
+    CONF_PARSE_HEAP: (DatabaseMetric.PARSE_HEAP, UNIT_BYTES, "mdi:memory", 0, "max"),
+    CONF_LARGEST_FREE_BLOCK: (DatabaseMetric.LARGEST_FREE_BLOCK, UNIT_BYTES, "mdi:memory", 0, "min"),
+    CONF_CONSECUTIVE_FAILURES: (DatabaseMetric.CONSECUTIVE_FAILURES, UNIT_FAILURES, "mdi:alert-circle-outline", 0, "last"),
+}
+
+
+def metric_schema(unit, icon, accuracy, statistic):
+    return sensor.sensor_schema(
+        unit_of_measurement=unit,
+        icon=icon,
+        accuracy_decimals=accuracy,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ).extend({
+        cv.Optional(CONF_STATISTIC, default=statistic): cv.enum(STATISTICS, lower=True),
+    })
+
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.GenerateID(): cv.declare_id(NotionDatabaseSensor),
+    cv.GenerateID(CONF_NOTION_DATABASE_ID): cv.use_id(NotionDatabase),
+    cv.Optional(CONF_WINDOW_SIZE, default=20): cv.int_range(min=1, max=100),
+    **{
+        cv.Optional(key): metric_schema(unit, icon, accuracy, statistic)
+        for key, (_, unit, icon, accuracy, statistic) in SENSORS.items()
+    },
+}).extend(cv.polling_component_schema("60s"))
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    database = await cg.get_variable(config[CONF_NOTION_DATABASE_ID])
+    cg.add(var.set_database(database))
+    cg.add(var.set_window_size(config[CONF_WINDOW_SIZE]))
+
+    for key, (metric, *_) in SENSORS.items():
+        if key not in config:
+            continue
+        conf = config[key]
+        sens = await sensor.new_sensor(conf)
+        cg.add(var.add_sensor(metric, conf[CONF_STATISTIC], sens))
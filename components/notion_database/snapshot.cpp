@@ -0,0 +1,175 @@
+#include "snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <esp_rom_crc.h>
+#include <nvs.h>
+
+#include "esphome/core/log.h"
+#include "page_codec.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.snapshot";
+static const char *const NVS_NAMESPACE = "notion_db";
+
+bool SnapshotCodec::encode(const SnapshotState &state, const PageTable &pages, std::vector<uint8_t> &out,
+                           size_t max_size) {
+  out.clear();
+  ByteWriter writer(out);
+  writer.u32(MAGIC);
+  writer.u8(VERSION);
+  writer.u8(VERSION >> 8);
+  writer.u8(0);  // reserved
+  writer.u8(0);
+  writer.u32(0);  // payload size
+  writer.u32(0);  // payload CRC
+
+  writer.u32(state.config_hash);
+  writer.u32(state.saved_at);
+  writer.u32(state.pages_hash);
+  writer.u8(state.has_more);
+  writer.str(state.next_cursor.c_str());
+  writer.str(state.watermark.c_str());
+  writer.varint(state.available_properties.size());
+  for (const auto &property : state.available_properties) {
+    writer.str(property.c_str());
+  }
+  encode_page_set(pages, writer);
+  if (out.size() > max_size) {
+    return false;
+  }
+
+  const uint8_t *payload = out.data() + HEADER_SIZE;
+  uint32_t payload_size = out.size() - HEADER_SIZE;
+  uint32_t crc = esp_rom_crc32_le(0, payload, payload_size);
+  for (int i = 0; i < 4; i++) {
+    out[8 + i] = payload_size >> (8 * i);
+    out[12 + i] = crc >> (8 * i);
+  }
+  return true;
+}
+
+bool SnapshotCodec::decode(const uint8_t *data, size_t size, SnapshotState &state, PageTable &pages,
+                           const std::shared_ptr<SymbolTable> &symbols) {
+  ByteReader header(data, size);
+  if (header.u32() != MAGIC) {
+    ESP_LOGW(TAG, "Not a snapshot");
+    return false;
+  }
+  uint16_t version = header.u8();
+  version |= header.u8() << 8;
+  if (version != VERSION) {
+    ESP_LOGW(TAG, "Snapshot format %u is not supported", version);
+    return false;
+  }
+  uint16_t reserved = header.u8();
+  reserved |= header.u8() << 8;
+  uint32_t payload_size = header.u32();
+  uint32_t crc = header.u32();
+  if (!header.ok() || reserved != 0 || payload_size != size - HEADER_SIZE ||
+      esp_rom_crc32_le(0, data + HEADER_SIZE, payload_size) != crc) {
+    ESP_LOGW(TAG, "Snapshot is corrupt");
+    return false;
+  }
+
+  ByteReader reader(data + HEADER_SIZE, payload_size);
+  state.config_hash = reader.u32();
+  state.saved_at = reader.u32();
+  state.pages_hash = reader.u32();
+  state.has_more = reader.u8() != 0;
+  state.next_cursor = reader.str();
+  state.watermark = reader.str();
+  state.available_properties.clear();
+  for (uint32_t count = reader.varint(); count > 0 && reader.ok(); count--) {
+    state.available_properties.insert(reader.str());
+  }
+  return reader.ok() && decode_page_set(reader, pages, symbols) && reader.at_end();
+}
+
+void SnapshotStore::set_key(uint32_t key) {
+  // NVS keys hold at most 15 characters
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "snap_%08x", static_cast<unsigned>(key));
+  key_ = buffer;
+  std::snprintf(buffer, sizeof(buffer), "snapt_%08x", static_cast<unsigned>(key));
+  checked_at_key_ = buffer;
+}
+
+bool SnapshotStore::load(std::vector<uint8_t> &data) const {
+  nvs_handle_t handle;
+  if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+    return false;
+  }
+  size_t size = 0;
+  esp_err_t err = nvs_get_blob(handle, key_.c_str(), nullptr, &size);
+  if (err == ESP_OK) {
+    data.resize(size);
+    err = nvs_get_blob(handle, key_.c_str(), data.data(), &size);
+  }
+  nvs_close(handle);
+  if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(TAG, "Failed to read snapshot: %s", esp_err_to_name(err));
+  }
+  return err == ESP_OK;
+}
+
+bool SnapshotStore::save(const std::vector<uint8_t> &data) const {
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(handle, key_.c_str(), data.data(), data.size());
+    if (err == ESP_OK) {
+      err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to write snapshot: %s", esp_err_to_name(err));
+  }
+  return err == ESP_OK;
+}
+
+bool SnapshotStore::load_checked_at(uint32_t &checked_at) const {
+  nvs_handle_t handle;
+  if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+    return false;
+  }
+  esp_err_t err = nvs_get_u32(handle, checked_at_key_.c_str(), &checked_at);
+  nvs_close(handle);
+  return err == ESP_OK;
+}
+
+bool SnapshotStore::save_checked_at(uint32_t checked_at) const {
+  nvs_handle_t handle;
+  esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (err == ESP_OK) {
+    err = nvs_set_u32(handle, checked_at_key_.c_str(), checked_at);
+    if (err == ESP_OK) {
+      err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to write snapshot check time: %s", esp_err_to_name(err));
+  }
+  return err == ESP_OK;
+}
+
+void SnapshotStore::erase() const {
+  nvs_handle_t handle;
+  if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+    return;
+  }
+  bool erased = nvs_erase_key(handle, key_.c_str()) == ESP_OK;
+  erased |= nvs_erase_key(handle, checked_at_key_.c_str()) == ESP_OK;
+  if (erased) {
+    nvs_commit(handle);
+  }
+  nvs_close(handle);
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * @file snapshot.h
+ * @brief Binary snapshot of the stored pages, restored on boot for a warm start.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "page_table.h"
+
+namespace esphome {
+namespace notion_database {
+
+// The state of a database saved along with its pages
+struct SnapshotState {
+  // Hash of the configuration the pages were fetched with; a snapshot of another query is ignored
+  uint32_t config_hash{0};
+  // Seconds since epoch when the pages were last fetched, or 0 if the clock was not set
+  uint32_t saved_at{0};
+  uint32_t pages_hash{0};
+  bool has_more{false};
+  std::string next_cursor;
+  std::string watermark;
+  std::set<std::string> available_properties;
+};
+
+/**
+ * @brief Encodes and decodes snapshots.
+ *
+ * A snapshot is a fixed header (magic, format version, payload size and CRC-32 of the payload)
+ * followed by the payload: the state and the pages as encoded by encode_page_set(). A snapshot
+ * that fails any check is rejected as a whole, so a half-written or outdated one never reaches
+ * the display.
+ */
+class SnapshotCodec {
+ public:
+  static const uint32_t MAGIC = 0x5342444E;  // "NDBS"
+  static const uint16_t VERSION = 2;
+  static const size_t HEADER_SIZE = 16;
+
+  // Encodes the pages and their symbols; returns false if the snapshot exceeds max_size
+  static bool encode(const SnapshotState &state, const PageTable &pages, std::vector<uint8_t> &out,
+                     size_t max_size);
+  // Decodes a snapshot into a table, interning its symbols into an empty symbol table
+  static bool decode(const uint8_t *data, size_t size, SnapshotState &state, PageTable &pages,
+                     const std::shared_ptr<SymbolTable> &symbols);
+};
+
+/**
+ * @brief Keeps one snapshot per database in the NVS partition.
+ *
+ * NVS survives deep sleep, reboots and power loss, and spreads writes over its pages, but
+ * writes still wear the flash; callers save only when the pages changed. When a fetch finds the
+ * pages unchanged, only the time of that check is saved, under a key of its own.
+ */
+class SnapshotStore {
+ public:
+  // Sets the key the snapshot is stored under, derived from the component ID
+  void set_key(uint32_t key);
+  bool is_enabled() const { return !key_.empty(); }
+
+  bool load(std::vector<uint8_t> &data) const;
+  bool save(const std::vector<uint8_t> &data) const;
+  // Loads and saves the seconds since epoch when the saved pages were last found unchanged
+  bool load_checked_at(uint32_t &checked_at) const;
+  bool save_checked_at(uint32_t checked_at) const;
+  void erase() const;
+
+ protected:
+  std::string key_;
+  std::string checked_at_key_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
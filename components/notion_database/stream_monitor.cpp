@@ -1,47 +1,75 @@
 #include "stream_monitor.h"
 
+#include "fetch_task.h"
+
 using namespace esphome;
 
 // Constructor
-StreamMonitor::StreamMonitor(Stream &inner) : inner_(inner), bytes_read_(0), bytes_written_(0) {}
+StreamMonitor::StreamMonitor(Stream &inner) : inner_(inner), bytes_read_(0), bytes_written_(0) {
+  setTimeout(inner.getTimeout());
+}
 
 // Returns the number of bytes available
 int StreamMonitor::available() {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   return inner_.available();
 }
 
 // Reads a byte from the stream
 int StreamMonitor::read() {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   int result = inner_.read();
   // Increment bytes_read_ if a byte was read
   if (result >= 0) {
     bytes_read_++;
+    last_read_ = result;
   }
   return result;
 }
 
 // Reads up to size bytes from the stream
 int StreamMonitor::read(uint8_t *buf, size_t size) {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   int result = inner_.readBytes(reinterpret_cast<char *>(buf), size);
   // Increment bytes_read_ by the number of bytes read
   if (result > 0) {
     bytes_read_ += result;
+    last_read_ = buf[result - 1];
   }
   return result;
 }
 
 // Peeks at the next byte in the stream
 int StreamMonitor::peek() {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   return inner_.peek();
 }
 
+// Peeks at the next byte, waiting up to the stream timeout for it to arrive
+int StreamMonitor::timed_peek() {
+  uint32_t start = esphome::millis();
+  do {
+    notion_database::feed_wdt();
+    int c = inner_.peek();
+    if (c >= 0) return c;
+    esphome::delay(1);
+  } while (esphome::millis() - start < getTimeout());
+  return -1;
+}
+
+// Skips whitespace and peeks at the next byte
+int StreamMonitor::peek_token() {
+  int c = timed_peek();
+  while (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+    read();
+    c = timed_peek();
+  }
+  return c;
+}
+
 // Writes a single byte to the stream
 size_t StreamMonitor::write(uint8_t byte) {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   size_t res = inner_.write(byte);
   if (res > 0) bytes_written_ += res;
   return res;
@@ -49,7 +77,7 @@ size_t StreamMonitor::write(uint8_t byte) {
 
 // Writes multiple bytes to the stream
 size_t StreamMonitor::write(const uint8_t *buf, size_t size) {
-  App.feed_wdt();
+  notion_database::feed_wdt();
   size_t res = inner_.write(buf, size);
   if (res > 0) bytes_written_ += res;
   return res;
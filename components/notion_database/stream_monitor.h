@@ -20,6 +20,10 @@ class StreamMonitor : public Stream {
   int read(uint8_t *buf, size_t size);
   // Peeks at the next byte in the stream
   int peek() override;
+  // Peeks at the next byte, waiting up to the stream timeout for it to arrive
+  int timed_peek();
+  // Skips whitespace and peeks at the next byte
+  int peek_token();
   // Writes a single byte to the stream
   size_t write(uint8_t byte) override;
   // Writes multiple bytes to the stream
@@ -28,9 +32,12 @@ class StreamMonitor : public Stream {
   size_t get_bytes_read() const;
   // Returns the number of bytes written
   size_t get_bytes_written() const;
+  // Returns the last byte read, or -1 if none has been
+  int get_last_read() const { return last_read_; }
 
  private:
   Stream &inner_;
   size_t bytes_read_;
   size_t bytes_written_;
+  int last_read_{-1};
 };
\ No newline at end of file
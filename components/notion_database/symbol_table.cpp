@@ -0,0 +1,72 @@
+#include "symbol_table.h"
+
+#include <cstring>
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "notion_database.symbols";
+
+// Returns the ID of text, adding it if needed
+uint16_t SymbolTable::intern(const char *text) {
+  if (text == nullptr || *text == '\0') return EMPTY;
+
+  int id = find(text);
+  if (id >= 0) return id;
+
+  size_t count = size_.load(std::memory_order_relaxed);
+  if (count >= MAX_SYMBOLS) {
+    ESP_LOGW(TAG, "Symbol table full, dropping '%s'", text);
+    return EMPTY;
+  }
+  slot_(count) = text;
+  size_.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+// Returns the ID of text, or -1
+int SymbolTable::find(const char *text) const {
+  size_t count = size();
+  for (size_t i = 0; i < count; i++) {
+    if (std::strcmp(at_(i).c_str(), text) == 0) return i;
+  }
+  return -1;
+}
+
+// Removes all symbols
+void SymbolTable::clear() {
+  for (auto &chunk : chunks_) {
+    chunk.reset();
+  }
+  slot_(0).clear();
+  size_.store(1, std::memory_order_release);
+}
+
+// Returns the chunk and the offset in it of an ID
+size_t SymbolTable::chunk_of_(size_t id, size_t &offset) {
+  size_t chunk = 31 - __builtin_clz(id / FIRST_CHUNK + 1);
+  offset = id - FIRST_CHUNK * ((1u << chunk) - 1);
+  return chunk;
+}
+
+// Returns the symbol of an ID below size()
+const std::string &SymbolTable::at_(size_t id) const {
+  size_t offset;
+  size_t chunk = chunk_of_(id, offset);
+  return chunks_[chunk][offset];
+}
+
+// Returns the slot for a new symbol, allocating its chunk when needed
+std::string &SymbolTable::slot_(size_t id) {
+  size_t offset;
+  size_t chunk = chunk_of_(id, offset);
+  if (chunks_[chunk] == nullptr) {
+    chunks_[chunk].reset(new std::string[FIRST_CHUNK << chunk]);
+  }
+  return chunks_[chunk][offset];
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,63 @@
+#pragma once
+/**
+ * @file symbol_table.h
+ * @brief Interned strings for the small vocabularies of select-like properties.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief Maps strings to small integer IDs.
+ *
+ * Select, status and multi-select values repeat across pages and polls, so they are stored
+ * once here and referenced by ID. ID 0 is always the empty string.
+ *
+ * The table only grows, and a symbol never moves once added, so one task may intern while
+ * others look up the symbols added before. The database shares one table with its fetch task
+ * this way, and tables built from the same one can compare symbols by ID.
+ */
+class SymbolTable {
+ public:
+  static const uint16_t EMPTY = 0;
+  static const size_t MAX_SYMBOLS = 0xFFFF;
+
+  SymbolTable() { clear(); }
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  // Returns the ID of text, adding it if needed; returns EMPTY when the table is full
+  uint16_t intern(const char *text);
+  // Returns the ID of text, or -1 if it has not been interned
+  int find(const char *text) const;
+  // Returns the text of an ID
+  const char *lookup(uint16_t id) const { return id < size() ? at_(id).c_str() : ""; }
+  // Returns the number of symbols, including the empty string
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+  // Removes all symbols; only while no other task uses the table
+  void clear();
+
+ protected:
+  // Chunk k holds FIRST_CHUNK << k symbols, so chunks are never reallocated
+  static const size_t FIRST_CHUNK = 16;
+  static const size_t CHUNK_COUNT = 13;
+
+  // Returns the chunk and the offset in it of an ID
+  static size_t chunk_of_(size_t id, size_t &offset);
+  // Returns the symbol of an ID below size()
+  const std::string &at_(size_t id) const;
+  // Returns the slot for a new symbol, allocating its chunk when needed
+  std::string &slot_(size_t id);
+
+  std::unique_ptr<std::string[]> chunks_[CHUNK_COUNT];
+  // Published after the symbol is written, so readers never see a partial one
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,36 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.const import CONF_ID
+from esphome.components.notion_database import NotionDatabase
+
+DEPENDENCIES = ["notion_database"]
+
+notion_database_ns = cg.esphome_ns.namespace('notion_database')
+NotionDatabaseHub = notion_database_ns.class_('NotionDatabaseHub', cg.Component)
+
+CONF_DATABASES = "databases"
+CONF_RATE_LIMIT = "rate_limit"
+CONF_BURST = "burst"
+CONF_KEEP_ALIVE = "keep_alive"
+CONF_KEEP_ALIVE_TIMEOUT = "keep_alive_timeout"
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.GenerateID(): cv.declare_id(NotionDatabaseHub),
+    cv.Required(CONF_DATABASES): cv.All(cv.ensure_list(cv.use_id(NotionDatabase)), cv.Length(min=1)),
+    cv.Optional(CONF_RATE_LIMIT, default=3.0): cv.positive_float,
+    cv.Optional(CONF_BURST, default=3): cv.int_range(min=1, max=255),
+    cv.Optional(CONF_KEEP_ALIVE, default=True): cv.boolean,
+    cv.Optional(CONF_KEEP_ALIVE_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
+}).extend(cv.COMPONENT_SCHEMA)
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    for database_id in config[CONF_DATABASES]:
+        database = await cg.get_variable(database_id)
+        cg.add(var.add_database(database))
+    cg.add(var.set_rate_limit(config[CONF_RATE_LIMIT]))
+    cg.add(var.set_burst(config[CONF_BURST]))
+    cg.add(var.set_keep_alive(config[CONF_KEEP_ALIVE]))
+    cg.add(var.set_keep_alive_timeout(config[CONF_KEEP_ALIVE_TIMEOUT]))
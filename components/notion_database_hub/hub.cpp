@@ -0,0 +1,112 @@
+#include "hub.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace notion_database {
+
+static const char *TAG = "notion_database_hub";
+
+void NotionDatabaseHub::setup() {
+  tokens_ = burst_;
+  last_refill_ = millis();
+
+  // Spread the polls of the databases evenly over their update interval
+  size_t count = databases_.size();
+  for (size_t i = 0; i < count; i++) {
+    NotionDatabase *database = databases_[i];
+    uint32_t interval = database->get_update_interval();
+    if (interval == SCHEDULER_DONT_RUN || i == 0) {
+      continue;
+    }
+    uint32_t offset = static_cast<uint32_t>(static_cast<uint64_t>(interval) * i / count);
+    database->stop_poller();
+    this->set_timeout(offset, [database]() { database->start_poller(); });
+  }
+}
+
+void NotionDatabaseHub::loop() {
+  if (queue_.empty() || is_busy_() || !take_token_()) {
+    return;
+  }
+  QueuedFetch fetch = queue_.front();
+  queue_.pop_front();
+  run_(fetch);
+}
+
+void NotionDatabaseHub::dump_config() {
+  ESP_LOGCONFIG(TAG, "Notion Database Hub:");
+  ESP_LOGCONFIG(TAG, "  Databases: %u", databases_.size());
+  ESP_LOGCONFIG(TAG, "  Rate Limit: %.1f req/s", rate_limit_);
+  ESP_LOGCONFIG(TAG, "  Burst: %u", burst_);
+  ESP_LOGCONFIG(TAG, "  Keep Alive: %s", YESNO(session_.get_keep_alive()));
+  if (session_.get_keep_alive()) {
+    ESP_LOGCONFIG(TAG, "  Keep Alive Timeout: %u", session_.get_idle_timeout());
+  }
+}
+
+void NotionDatabaseHub::add_database(NotionDatabase *database) {
+  database->set_scheduler(this);
+  databases_.push_back(database);
+}
+
+void NotionDatabaseHub::submit(NotionDatabase *database, FetchMode mode) {
+  // Run right away when nothing is waiting; requests made while another one is in flight,
+  // e.g. from an on_page_change trigger, always go through the queue
+  if (queue_.empty() && !is_busy_() && take_token_()) {
+    run_({database, mode});
+    return;
+  }
+  // A poll and a page load of the same database are separate requests
+  auto queued = [database, mode](const QueuedFetch &fetch) { return fetch.database == database && fetch.mode == mode; };
+  if (std::find_if(queue_.begin(), queue_.end(), queued) != queue_.end()) {
+    ESP_LOGV(TAG, "Request already queued");
+    return;
+  }
+  queue_.push_back({database, mode});
+  ESP_LOGD(TAG, "Request queued (%u waiting)", queue_.size());
+}
+
+void NotionDatabaseHub::refill_() {
+  uint32_t now = millis();
+  tokens_ = std::min<float>(burst_, tokens_ + (now - last_refill_) * rate_limit_ / 1000.0f);
+  last_refill_ = now;
+}
+
+bool NotionDatabaseHub::take_token_() {
+  refill_();
+  if (tokens_ < 1.0f) {
+    return false;
+  }
+  tokens_ -= 1.0f;
+  return true;
+}
+
+void NotionDatabaseHub::run_(const QueuedFetch &fetch) {
+  busy_ = true;
+  running_ = fetch.database;
+  fetch.database->fetch(fetch.mode);
+  busy_ = false;
+}
+
+bool NotionDatabaseHub::is_busy_() {
+  if (paused_) {
+    if (static_cast<int32_t>(millis() - paused_until_) < 0) {
+      return true;
+    }
+    paused_ = false;
+  }
+  return busy_ || (running_ != nullptr && running_->is_fetching());
+}
+
+void NotionDatabaseHub::pause(uint32_t duration) {
+  uint32_t until = millis() + duration;
+  if (!paused_ || static_cast<int32_t>(until - paused_until_) > 0) {
+    paused_until_ = until;
+  }
+  paused_ = true;
+  ESP_LOGD(TAG, "Requests paused for %u ms", duration);
+}
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "esphome.h"
+#include "esphome/components/notion_database/http_session.h"
+#include "esphome/components/notion_database/notion_database.h"
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief Shares one Notion API connection between several notion_database components.
+ *
+ * Requests are queued in FIFO order and sent one at a time over a single HttpSession, so only
+ * one TLS context is ever allocated. A token bucket keeps the request rate under the Notion
+ * API limit, and the poll intervals of the databases are staggered at startup so they do not
+ * fire in the same loop iteration.
+ */
+class NotionDatabaseHub : public Component, public RequestScheduler {
+ public:
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+  // Run after the databases so their pollers can be staggered
+  float get_setup_priority() const override { return setup_priority::LATE - 1.0f; }
+
+  void add_database(NotionDatabase *database);
+  void set_rate_limit(float rate_limit) { rate_limit_ = rate_limit; }
+  void set_burst(uint8_t burst) { burst_ = burst; }
+  void set_keep_alive(bool keep_alive) { session_.set_keep_alive(keep_alive); }
+  void set_keep_alive_timeout(uint32_t keep_alive_timeout) { session_.set_idle_timeout(keep_alive_timeout); }
+
+  void submit(NotionDatabase *database, FetchMode mode) override;
+  void pause(uint32_t duration) override;
+  HttpSession &get_session() override { return session_; }
+
+  // Returns the number of requests waiting for their turn
+  size_t get_queue_size() const { return queue_.size(); }
+
+ protected:
+  void refill_();
+  bool take_token_();
+  struct QueuedFetch {
+    NotionDatabase *database;
+    FetchMode mode;
+  };
+
+  void run_(const QueuedFetch &fetch);
+  bool is_busy_();
+
+  HttpSession session_;
+  std::vector<NotionDatabase *> databases_;
+  std::deque<QueuedFetch> queue_;
+  float rate_limit_{3.0f};
+  uint8_t burst_{3};
+  float tokens_{0.0f};
+  uint32_t last_refill_{0};
+  bool busy_{false};
+  // millis() before which no request is sent
+  uint32_t paused_until_{0};
+  bool paused_{false};
+  // The database whose request was sent last; an asynchronous fetch holds the connection until it finishes
+  NotionDatabase *running_{nullptr};
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -29,6 +29,7 @@ CONF_DATE_FORMAT = "date_format"
 CONF_DATETIME_FORMAT = "datetime_format"
 CONF_LIST_STYLE_TYPE = "list_style_type"
 CONF_ENABLE_LIST_STYLE = "enable_list_style"
+CONF_PREFETCH_ROWS = "prefetch_rows"
 
 
 CONFIG_SCHEMA =  cv.All(
@@ -53,6 +54,7 @@ CONFIG_SCHEMA =  cv.All(
             }, upper=True)),
             cv.Optional(CONF_DATE_FORMAT, default="%Y-%m-%d"): cv.templatable(cv.string),
             cv.Optional(CONF_DATETIME_FORMAT, default="%Y-%m-%d %H:%M"): cv.templatable(cv.string),
+            cv.Optional(CONF_PREFETCH_ROWS, default=0): cv.templatable(cv.positive_int),
         }).extend(cv.COMPONENT_SCHEMA)
     )
 )
@@ -93,4 +95,5 @@ async def to_code(configs):
             cg.add(var.set_date_format(date_format))
         if datetime_format := await cg.templatable(config[CONF_DATETIME_FORMAT], [], cg.std_string):
             cg.add(var.set_datetime_format(datetime_format))
-
+        if prefetch_rows := await cg.templatable(config[CONF_PREFETCH_ROWS], [], cg.int_):
+            cg.add(var.set_prefetch_rows(prefetch_rows))
@@ -0,0 +1,113 @@
+#include "glyph_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace esphome {
+namespace notion_database {
+
+// First key past the last code point, for bytes that are not valid UTF-8
+static const uint32_t INVALID_KEY = 0x110000;
+// Smallest code point of a sequence of each length; smaller ones are overlong encodings
+static const uint32_t MIN_CODE_POINT[] = {0, 0, 0x80, 0x800, 0x10000};
+
+// Returns the length of the UTF-8 sequence starting with lead, or 1 for invalid bytes
+static size_t utf8_length(uint8_t lead) {
+  if (lead < 0x80) return 1;
+  if ((lead & 0xE0) == 0xC0) return 2;
+  if ((lead & 0xF0) == 0xE0) return 3;
+  if ((lead & 0xF8) == 0xF0) return 4;
+  return 1;
+}
+
+GlyphCache &GlyphCache::get(font::Font *font) {
+  static std::unordered_map<font::Font *, std::unique_ptr<GlyphCache>> caches;
+  std::unique_ptr<GlyphCache> &cache = caches[font];
+  if (!cache) {
+    cache.reset(new GlyphCache(font));
+  }
+  return *cache;
+}
+
+// Returns the cached advance of the code point at the start of text
+const GlyphCache::Glyph &GlyphCache::glyph_(const char *text, size_t length, size_t &consumed) {
+  uint8_t lead = static_cast<uint8_t>(text[0]);
+  size_t expected = utf8_length(lead);
+  consumed = std::min(expected, length);
+  // The payload bits of the lead byte, then six bits per continuation byte
+  uint32_t key = expected == 1 ? lead : lead & (0x7F >> expected);
+  for (size_t i = 1; i < consumed; i++) {
+    uint8_t byte = static_cast<uint8_t>(text[i]);
+    if ((byte & 0xC0) != 0x80) {
+      consumed = i;
+      break;
+    }
+    key = (key << 6) | (byte & 0x3F);
+  }
+  // A lone continuation byte, a cut-short sequence or an overlong one is measured, and cached, byte by byte
+  if ((expected == 1 && lead >= 0x80) || consumed < expected || key < MIN_CODE_POINT[expected] ||
+      key >= INVALID_KEY) {
+    consumed = 1;
+    key = INVALID_KEY + lead;
+  }
+  auto it = glyphs_.find(key);
+  if (it != glyphs_.end()) {
+    return it->second;
+  }
+
+  char buffer[5] = {};
+  std::memcpy(buffer, text, consumed);
+  int width = 0;
+  int x_offset = 0;
+  int baseline = 0;
+  int height = 0;
+  font_->measure(buffer, &width, &x_offset, &baseline, &height);
+  return glyphs_.emplace(key, Glyph{static_cast<int16_t>(width + x_offset), static_cast<int16_t>(x_offset)})
+      .first->second;
+}
+
+// Returns the width of text as font::Font::measure() would report it
+int GlyphCache::text_width(const char *text, size_t length) {
+  int width = 0;
+  int min_x = 0;
+  size_t consumed = 0;
+  for (size_t i = 0; i < length; i += consumed) {
+    const Glyph &glyph = glyph_(text + i, length - i, consumed);
+    min_x = i == 0 ? glyph.x_offset : std::min(min_x, width + glyph.x_offset);
+    width += glyph.advance;
+  }
+  return width - min_x;
+}
+
+// Returns the length in bytes of the longest prefix of text that fits in max_width together with suffix
+size_t GlyphCache::fit_prefix(const char *text, size_t length, const char *suffix, int max_width) {
+  int suffix_width = 0;
+  size_t consumed = 0;
+  size_t suffix_length = std::strlen(suffix);
+  for (size_t i = 0; i < suffix_length; i += consumed) {
+    suffix_width += glyph_(suffix + i, suffix_length - i, consumed).advance;
+  }
+
+  // Widths of every prefix ending on a code point boundary, in one pass
+  prefix_widths_.assign(1, 0);
+  prefix_bytes_.assign(1, 0);
+  int first_x_offset = 0;
+  int width = 0;
+  for (size_t i = 0; i < length; i += consumed) {
+    const Glyph &glyph = glyph_(text + i, length - i, consumed);
+    if (i == 0) first_x_offset = glyph.x_offset;
+    width += glyph.advance;
+    prefix_widths_.push_back(width - first_x_offset + suffix_width);
+    prefix_bytes_.push_back(i + consumed);
+  }
+  prefix_widths_[0] = suffix_width;
+
+  // Prefix widths never decrease, so the cut point can be found by binary search
+  auto it = std::upper_bound(prefix_widths_.begin(), prefix_widths_.end(), max_width);
+  size_t count = it - prefix_widths_.begin();
+  return count == 0 ? 0 : prefix_bytes_[count - 1];
+}
+
+}  // namespace notion_database
+}  // namespace esphome
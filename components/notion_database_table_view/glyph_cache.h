@@ -0,0 +1,60 @@
+#pragma once
+/**
+ * @file glyph_cache.h
+ * @brief Per-font glyph advances for measuring and truncating text without re-measuring strings.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "esphome/components/font/font.h"
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief Caches the advance of every code point measured with one font.
+ *
+ * Fonts do not kern, so the width of a string is the sum of its advances minus the x offset of
+ * its first glyph, which is what font::Font::measure() computes. Advances are measured lazily
+ * one code point at a time. There is one cache per font, shared by every view that draws with
+ * it, so switching fonts or adding views never measures a glyph twice. Like the fonts, the
+ * caches live as long as the program; they are only used from the main loop.
+ */
+class GlyphCache {
+ public:
+  // Returns the cache of a font, creating it on first use
+  static GlyphCache &get(font::Font *font);
+
+  // Returns the width of text as font::Font::measure() would report it
+  int text_width(const char *text, size_t length);
+  int text_width(const std::string &text) { return text_width(text.data(), text.size()); }
+
+  // Returns the length in bytes of the longest prefix of text that fits in max_width together with suffix
+  size_t fit_prefix(const char *text, size_t length, const char *suffix, int max_width);
+
+  // Returns the number of cached code points
+  size_t size() const { return glyphs_.size(); }
+
+ protected:
+  struct Glyph {
+    int16_t advance;
+    int16_t x_offset;
+  };
+
+  explicit GlyphCache(font::Font *font) : font_(font) {}
+
+  const Glyph &glyph_(const char *text, size_t length, size_t &consumed);
+
+  font::Font *font_;
+  // Keyed by code point; bytes that are not valid UTF-8 get keys above the last code point
+  std::unordered_map<uint32_t, Glyph> glyphs_;
+  // Prefix widths of the string being truncated, reused between calls
+  std::vector<int> prefix_widths_;
+  std::vector<uint32_t> prefix_bytes_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
@@ -0,0 +1,60 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.components.notion_database.sensor import STATISTICS
+from esphome.const import (
+    CONF_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_MILLISECOND,
+)
+from . import NotionDatabaseTableView, notion_database_ns
+
+DEPENDENCIES = ["notion_database_table_view"]
+
+TableViewSensor = notion_database_ns.class_("TableViewSensor", cg.PollingComponent)
+
+CONF_TABLE_VIEW_ID = "table_view_id"
+CONF_WINDOW_SIZE = "window_size"
+CONF_STATISTIC = "statistic"
+CONF_LAYOUT_TIME = "layout_time"
+CONF_RENDER_TIME = "render_time"
+CONF_DRAW_TIME = "draw_time"
+
+TIME_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    icon="mdi:timer-outline",
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+).extend({
+    cv.Optional(CONF_STATISTIC, default="avg"): cv.enum(STATISTICS, lower=True),
+})
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.GenerateID(): cv.declare_id(TableViewSensor),
+    cv.GenerateID(CONF_TABLE_VIEW_ID): cv.use_id(NotionDatabaseTableView),
+    cv.Optional(CONF_WINDOW_SIZE, default=20): cv.int_range(min=1, max=100),
+    cv.Optional(CONF_LAYOUT_TIME): TIME_SCHEMA,
+    cv.Optional(CONF_RENDER_TIME): TIME_SCHEMA,
+    cv.Optional(CONF_DRAW_TIME): TIME_SCHEMA,
+}).extend(cv.polling_component_schema("60s"))
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    table_view = await cg.get_variable(config[CONF_TABLE_VIEW_ID])
+    cg.add(var.set_table_view(table_view))
+    cg.add(var.set_window_size(config[CONF_WINDOW_SIZE]))
+
+    if CONF_LAYOUT_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_LAYOUT_TIME])
+        cg.add(var.set_layout_time_sensor(sens, config[CONF_LAYOUT_TIME][CONF_STATISTIC]))
+    if CONF_RENDER_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_RENDER_TIME])
+        cg.add(var.set_render_time_sensor(sens, config[CONF_RENDER_TIME][CONF_STATISTIC]))
+    if CONF_DRAW_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_DRAW_TIME])
+        cg.add(var.set_draw_time_sensor(sens, config[CONF_DRAW_TIME][CONF_STATISTIC]))
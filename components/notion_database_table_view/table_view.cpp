@@ -3,15 +3,125 @@
 #include "esphome/components/display/display.h"
 #include "esphome/components/notion_database/notion_database.h"
 
+#include <cstring>
+
 namespace esphome {
 namespace notion_database {
 
+bool TableLayoutKey::operator==(const TableLayoutKey &other) const {
+  return pages_hash == other.pages_hash && font == other.font && width == other.width && height == other.height &&
+         line_height == other.line_height && title_enabled == other.title_enabled &&
+         header_enabled == other.header_enabled && text_overflow == other.text_overflow &&
+         columns == other.columns && column_widths == other.column_widths && date_format == other.date_format &&
+         datetime_format == other.datetime_format && list_style_type == other.list_style_type &&
+         first_row == other.first_row;
+}
+
+// Returns whether a row shows the same text as a row of another frame with the same layout
+bool TableFrame::same_row(size_t row, const TableFrame &other) const {
+  for (size_t i = 0; i < widths.size(); i++) {
+    if (std::strcmp(cell(row, i), other.cell(row, i)) != 0) return false;
+  }
+  return true;
+}
+
+// Returns whether everything but the rows is the same
+bool TableFrame::same_layout(const TableFrame &other) const {
+  return valid && other.valid && x == other.x && y == other.y && width == other.width && height == other.height &&
+         font == other.font && color_on == other.color_on && color_off == other.color_off &&
+         line_height == other.line_height && grid_line == other.grid_line && title_enabled == other.title_enabled &&
+         invert_title == other.invert_title && header_enabled == other.header_enabled &&
+         invert_header == other.invert_header && title == other.title && widths == other.widths &&
+         header == other.header && rows_y == other.rows_y;
+}
+
+// Returns the area of a row; its top grid line belongs to the row above
+display::Rect TableFrame::row_rect(size_t row) const {
+  return display::Rect(x, rows_y + row * line_height + 1, width, line_height);
+}
+
 void NotionDatabaseTableView::draw(display::Display &it, int x, int y, int width, int height, font::Font *font,
                                          Color color_on, Color color_off) {
+  uint32_t start = micros();
+  if (!build_frame_(it, x, y, width, height, font, color_on, color_off, next_frame_)) {
+    return;
+  }
+  uint32_t built = micros();
+  render_frame_(it, next_frame_);
+
+  dirty_regions_.assign(1, display::Rect(x, y, width, height));
+  record_draw_stats_(start, built);
+  std::swap(frame_, next_frame_);
+}
+
+void NotionDatabaseTableView::draw_dirty(display::Display &it, int x, int y, int width, int height, font::Font *font,
+                                         Color color_on, Color color_off) {
+  uint32_t start = micros();
+  if (!build_frame_(it, x, y, width, height, font, color_on, color_off, next_frame_)) {
+    return;
+  }
+  uint32_t built = micros();
+  const TableFrame &frame = next_frame_;
+  dirty_regions_.clear();
+
+  if (!frame.same_layout(frame_)) {
+    it.filled_rectangle(x, y, width, height, color_off);
+    render_frame_(it, frame);
+    dirty_regions_.emplace_back(x, y, width, height);
+  } else {
+    size_t rows = std::max(frame.row_count(), frame_.row_count());
+    for (size_t i = 0; i < rows; i++) {
+      if (i < frame.row_count() && i < frame_.row_count() && frame.same_row(i, frame_)) {
+        continue;
+      }
+      display::Rect rect = frame.row_rect(i);
+      it.filled_rectangle(rect.x, rect.y, rect.w, rect.h, color_off);
+      if (i < frame.row_count()) {
+        render_row_(it, frame, i);
+      }
+      // Adjacent rows are merged into one region
+      if (!dirty_regions_.empty() && dirty_regions_.back().y + dirty_regions_.back().h == rect.y) {
+        dirty_regions_.back().h += rect.h;
+      } else {
+        dirty_regions_.push_back(rect);
+      }
+    }
+  }
+
+  ESP_LOGV("table_view", "%u dirty regions", dirty_regions_.size());
+  record_draw_stats_(start, built);
+  std::swap(frame_, next_frame_);
+}
+
+// Records the cost of the frame just drawn; next_frame_ is the frame drawn
+void NotionDatabaseTableView::record_draw_stats_(uint32_t start, uint32_t built) {
+  uint32_t now = micros();
+  draw_stats_.layout_us = built - start;
+  draw_stats_.render_us = now - built;
+  draw_stats_.rows = next_frame_.row_count();
+  draw_stats_.dirty_regions = dirty_regions_.size();
+  draw_stats_.layout_cached = frame_.valid && next_frame_.layout_key == frame_.layout_key;
+  ESP_LOGV("table_view", "Draw stats: layout_us=%u render_us=%u rows=%u dirty_regions=%u layout_cached=%d",
+           draw_stats_.layout_us, draw_stats_.render_us, draw_stats_.rows, draw_stats_.dirty_regions,
+           draw_stats_.layout_cached);
+  draw_callback_.call(draw_stats_);
+}
+
+void NotionDatabaseTableView::scroll_by(int rows) {
+  if (rows < 0 && static_cast<size_t>(-rows) > scroll_offset_) {
+    scroll_offset_ = 0;
+  } else {
+    scroll_offset_ += rows;
+  }
+}
+
+// Lays out the table and fits every visible cell to its column
+bool NotionDatabaseTableView::build_frame_(display::Display &it, int x, int y, int width, int height,
+                                           font::Font *font, Color color_on, Color color_off, TableFrame &frame) {
   // Check if the database parent is valid
   if (this->database_parent_ == nullptr) {
     ESP_LOGW("table_view", "database_parent_ is null, skipping draw");
-    return;
+    return false;
   }
   if (this->columns_.empty()) {
     ESP_LOGW("table_view", "Columns are empty, fetching available properties from database_parent_");
@@ -19,83 +129,193 @@ void NotionDatabaseTableView::draw(display::Display &it, int x, int y, int width
     this->columns_ = std::vector<std::string>(available_properties.begin(), available_properties.end());
   }
 
-  auto pages = this->database_parent_->get_pages();
-  std::vector<int> col_widths = calculate_column_widths_(it, width, font, pages);
+  // Held for the whole layout, so the pages cannot change underneath it
+  std::shared_ptr<const PageTable> snapshot = this->database_parent_->get_pages_snapshot();
+  const PageTable &pages = *snapshot;
+  frame.x = x;
+  frame.y = y;
+  frame.width = width;
+  frame.height = height;
+  frame.font = font;
+  frame.color_on = color_on;
+  frame.color_off = color_off;
+  frame.line_height = line_height_.value();
+  frame.grid_line = enable_grid_line_.value();
+  frame.title_enabled = enable_title_.value() && !title_.value().empty();
+  frame.invert_title = invert_title_color_.value();
+  frame.header_enabled = enable_header_.value() && !columns_.empty();
+  frame.invert_header = invert_header_color_.value();
+  frame.title = frame.title_enabled ? title_.value() : "";
+  frame.rows_y = y + (frame.title_enabled ? frame.line_height : 0) + (frame.header_enabled ? frame.line_height : 0);
+
+  // Only the rows in the viewport are measured and fitted
+  visible_rows_ = frame.line_height > 0 ? std::max(0, (y + height - frame.rows_y) / frame.line_height) : 0;
+  // Rows dropped from the top of the database shift the rows still held up
+  size_t evicted_rows = this->database_parent_->get_evicted_row_count();
+  if (evicted_rows > evicted_rows_) {
+    scroll_offset_ -= std::min(scroll_offset_, evicted_rows - evicted_rows_);
+  }
+  evicted_rows_ = evicted_rows;
+  size_t max_offset = pages.size() > visible_rows_ ? pages.size() - visible_rows_ : 0;
+  scroll_offset_ = std::min(scroll_offset_, max_offset);
+  size_t first_row = scroll_offset_;
+  size_t last_row = std::min(pages.size(), first_row + visible_rows_);
+
+  int prefetch_rows = prefetch_rows_.value();
+  if (prefetch_rows > 0 && this->database_parent_->has_more() && last_row + prefetch_rows >= pages.size()) {
+    // Rows more than prefetch_rows above the viewport may be dropped
+    size_t keep_from_row = first_row > static_cast<size_t>(prefetch_rows) ? first_row - prefetch_rows : 0;
+    this->database_parent_->request_more(keep_from_row);
+  }
+
+  TableLayoutKey &key = frame.layout_key;
+  key.pages_hash = this->database_parent_->get_pages_hash();
+  key.columns = columns_;
+  key.column_widths = column_widths_;
+  key.font = font;
+  key.width = width;
+  key.height = height;
+  key.line_height = frame.line_height;
+  key.title_enabled = frame.title_enabled;
+  key.header_enabled = frame.header_enabled;
+  key.text_overflow = text_overflow_.value();
+  key.date_format = date_format_.value();
+  key.datetime_format = datetime_format_.value();
+  key.list_style_type = enable_list_style_.value() ? list_style_type_.value() : "";
+  key.first_row = first_row;
+
+  // Measuring and fitting the cells is only needed when the data or the view changed
+  if (frame_.valid && key == frame_.layout_key) {
+    frame.widths = frame_.widths;
+    frame.header = frame_.header;
+    frame.text = frame_.text;
+    frame.cells = frame_.cells;
+    frame.valid = true;
+    return true;
+  }
+
+  column_keys_.clear();
+  for (const auto &column : columns_) {
+    column_keys_.push_back(Page::hash_key(column));
+  }
+  frame.widths = calculate_column_widths_(it, width, font, pages, first_row, last_row, key);
+
+  frame.header.resize(columns_.size());
+  for (size_t i = 0; i < columns_.size(); i++) {
+    frame.header[i].clear();
+    if (frame.header_enabled && frame.widths[i] > 0) {
+      fit_text_(frame.header[i], columns_[i].c_str(), columns_[i].size(), frame.widths[i], font, key.text_overflow);
+    }
+  }
 
-  int current_y = y;
+  // All visible cells go into one buffer, so an unchanged table is rebuilt without allocating
+  frame.text.assign(1, '\0');
+  frame.cells.clear();
+  for (size_t row = first_row; row < last_row; row++) {
+    Page page = pages[row];
+    for (size_t i = 0; i < columns_.size(); i++) {
+      if (frame.widths[i] == 0) {
+        frame.cells.push_back(0);
+        continue;
+      }
+      frame.cells.push_back(frame.text.size());
+      compose_cell_(page, i, key);
+      fit_text_(frame.text, scratch_.data(), scratch_.size(), frame.widths[i], font, key.text_overflow);
+      frame.text.push_back('\0');
+    }
+  }
+  frame.valid = true;
+  return true;
+}
+
+// Draws a whole frame
+void NotionDatabaseTableView::render_frame_(display::Display &it, const TableFrame &frame) {
+  int x = frame.x;
+  int width = frame.width;
+  int line_height = frame.line_height;
+  font::Font *font = frame.font;
+  Color color_on = frame.color_on;
+  Color color_off = frame.color_off;
+  int current_y = frame.y;
 
   // Draw the top grid line if enabled
-  if (enable_grid_line_.value()) {
+  if (frame.grid_line) {
     it.line(x, current_y, x + width, current_y, color_on);
   }
 
   // Draw the title if enabled and not empty
-  if (enable_title_.value() && !title_.value().empty()) {
+  if (frame.title_enabled) {
     // Invert the title color if enabled
-    if (invert_title_color_.value()) {
-      it.filled_rectangle(x, current_y, width, line_height_.value(), color_on);
-      it.printf(x + width / 2, current_y + line_height_.value() / 2, font, color_off, display::TextAlign::CENTER,
-                title_.value().c_str());
+    if (frame.invert_title) {
+      it.filled_rectangle(x, current_y, width, line_height, color_on);
+      it.print(x + width / 2, current_y + line_height / 2, font, color_off, display::TextAlign::CENTER,
+               frame.title.c_str());
     } else {
-      it.printf(x + width / 2, current_y + line_height_.value() / 2, font, color_on, display::TextAlign::CENTER,
-                title_.value().c_str());
+      it.print(x + width / 2, current_y + line_height / 2, font, color_on, display::TextAlign::CENTER,
+               frame.title.c_str());
     }
-    current_y += line_height_.value();
+    current_y += line_height;
   }
 
   // Draw the top grid line if enabled
-  if (enable_grid_line_.value()) {
+  if (frame.grid_line) {
     it.line(x, current_y, x + width, current_y, color_on);
   }
 
   // Draw the header if enabled and columns are defined
-  if (enable_header_.value() && !columns_.empty()) {
+  if (frame.header_enabled) {
     // Invert the header color if enabled
-    if (invert_header_color_.value()) {
+    if (frame.invert_header) {
       int saved_y = current_y;
-      it.filled_rectangle(x, current_y, width, line_height_.value(), color_on);
-      print_row_(it, x, current_y, width, true, columns_, col_widths, font, color_off, color_on);
+      it.filled_rectangle(x, current_y, width, line_height, color_on);
+      print_row_(it, current_y, frame, -1, color_off);
 
       int current_x = x;
-      for (size_t i = 0; i < col_widths.size() - 1; i++) {
-        if (col_widths[i] == 0) continue;
+      for (size_t i = 0; i < frame.widths.size() - 1; i++) {
+        if (frame.widths[i] == 0) continue;
 
-        current_x += col_widths[i];
+        current_x += frame.widths[i];
         int grid_x = (current_x > x + width) ? x + width : current_x;
         it.line(grid_x, saved_y, grid_x, current_y, color_on);
       }
     } else {
-      print_row_(it, x, current_y, width, true, columns_, col_widths, font, color_on, color_off);
+      print_row_(it, current_y, frame, -1, color_on);
     }
   }
 
   // Draw each row of the table
-  for (const auto &page : pages) {
-    if (current_y + line_height_.value() > y + height) break;
-
-    std::vector<std::string> row_texts;
-    for (size_t i = 0; i < columns_.size(); i++) {
-      row_texts.push_back(get_cell_text_(page, columns_[i], i == 0, false));
-    }
-    print_row_(it, x, current_y, width, false, row_texts, col_widths, font, color_on, color_off);
+  for (size_t row = 0; row < frame.row_count(); row++) {
+    print_row_(it, current_y, frame, row, color_on);
   }
 
   // Draw the vertical grid lines if enabled
-  if (enable_grid_line_.value()) {
-    it.line(x, y, x, current_y, color_on);
-    it.line(x + width - 1, y, x + width - 1, current_y, color_on);
+  if (frame.grid_line) {
+    it.line(x, frame.y, x, current_y, color_on);
+    it.line(x + width - 1, frame.y, x + width - 1, current_y, color_on);
   }
 }
 
-std::vector<int> NotionDatabaseTableView::calculate_column_widths_(display::Display &it, int width, font::Font *font,
-                                                                   const std::vector<Page, Allocator<Page>> &pages) {
+// Draws a single row together with its part of the outer grid lines
+void NotionDatabaseTableView::render_row_(display::Display &it, const TableFrame &frame, size_t row) {
+  int current_y = frame.rows_y + row * frame.line_height;
+  print_row_(it, current_y, frame, row, frame.color_on);
+  if (frame.grid_line) {
+    int top = current_y - frame.line_height;
+    it.line(frame.x, top, frame.x, current_y, frame.color_on);
+    it.line(frame.x + frame.width - 1, top, frame.x + frame.width - 1, current_y, frame.color_on);
+  }
+}
+
+ColumnWidths NotionDatabaseTableView::calculate_column_widths_(display::Display &it, int width, font::Font *font,
+                                                               const PageTable &pages, size_t first_row,
+                                                               size_t last_row, const TableLayoutKey &key) {
   const int right_padding = 10;
-  std::vector<int> col_widths(columns_.size(), 0);
+  ColumnWidths col_widths(columns_.size(), 0, Allocator<int>(this->database_parent_->get_cache_placement()));
   int total_width = 0;
 
   // Calculate column widths based on predefined widths or content
   if (!column_widths_.empty() && column_widths_.size() == columns_.size()) {
-    col_widths = column_widths_;
+    col_widths.assign(column_widths_.begin(), column_widths_.end());
     for (size_t i = 0; i < col_widths.size(); i++) {
       if (total_width + col_widths[i] <= width) {
         total_width += col_widths[i];
@@ -105,12 +325,13 @@ std::vector<int> NotionDatabaseTableView::calculate_column_widths_(display::Disp
       }
     }
   } else {
+    GlyphCache &glyphs = GlyphCache::get(font);
     for (size_t i = 0; i < columns_.size(); i++) {
-      int max_w = enable_header_.value() ? text_width_(&it, font, columns_[i]) : 0;
-      for (const auto &page : pages) {
-        const std::string &cell_text = get_cell_text_(page, columns_[i], i == 0, false);
-        if (!cell_text.empty()) {
-          max_w = std::max(max_w, text_width_(&it, font, cell_text));
+      int max_w = enable_header_.value() ? glyphs.text_width(columns_[i]) : 0;
+      for (size_t row = first_row; row < last_row; row++) {
+        compose_cell_(pages[row], i, key);
+        if (!scratch_.empty()) {
+          max_w = std::max(max_w, glyphs.text_width(scratch_));
         }
       }
       max_w += right_padding;
@@ -142,108 +363,81 @@ std::vector<int> NotionDatabaseTableView::calculate_column_widths_(display::Disp
   return col_widths;
 }
 
-int NotionDatabaseTableView::text_width_(display::Display *it, font::Font *font, const std::string &buffer) {
-  int x1 = 0;
-  int y1 = 0;
-  int w = 0;
-  int h = 0;
-  it->get_text_bounds(0, 0, buffer.c_str(), font, display::TextAlign::TOP_LEFT, &x1, &y1, &w, &h);
-  return w;
-}
-
-std::string NotionDatabaseTableView::truncate_text_(const std::string &text, int column_width, display::Display &it,
-                                                    font::Font *font, const std::string &suffix) {
-  std::string result = text;
-  // Truncate text to fit within the column width
-  while (!result.empty() && text_width_(&it, font, result + suffix) > column_width) {
-    size_t lastCharPos = result.size() - 1;
-    while (lastCharPos > 0 && (result[lastCharPos] & 0xC0) == 0x80) {
-      lastCharPos--;
-    }
-    result.erase(lastCharPos);
-  }
-  return result + suffix;
-}
-
-std::string NotionDatabaseTableView::format_text_for_column_(const std::string &text, int column_width,
-                                                             display::Display &it, font::Font *font,
-                                                             bool is_first_column, bool is_header_row) {
-  std::string result_text = text;
-  if (result_text.empty()) {
-    return result_text;
-  }
-
-  int text_w = text_width_(&it, font, result_text);
-  // Format text based on overflow settings
-  if (text_w <= column_width) {
-    return result_text;
+// Appends text to out, truncated to the column width according to the overflow mode
+void NotionDatabaseTableView::fit_text_(std::string &out, const char *text, size_t length, int column_width,
+                                        font::Font *font, TextOverflow overflow) {
+  GlyphCache &glyphs = GlyphCache::get(font);
+  if (length == 0 || glyphs.text_width(text, length) <= column_width) {
+    out.append(text, length);
+    return;
   }
 
-  if (text_overflow_.value() == TextOverflow::ELLIPSIS) {
-    return truncate_text_(result_text, column_width, it, font, "...");
-  } else if (text_overflow_.value() == TextOverflow::CLIP) {
-    return truncate_text_(result_text, column_width, it, font, "");
-  } else {
-    return result_text;
-  }
+  const char *suffix = overflow == TextOverflow::ELLIPSIS ? "..." : "";
+  out.append(text, glyphs.fit_prefix(text, length, suffix, column_width));
+  out.append(suffix);
 }
 
-void NotionDatabaseTableView::print_row_(display::Display &it, int x, int &current_y, int table_width,
-                                         bool is_header_row, const std::vector<std::string> &texts,
-                                         const std::vector<int> &col_widths, font::Font *font, Color color_on,
-                                         Color color_off) {
+void NotionDatabaseTableView::print_row_(display::Display &it, int &current_y, const TableFrame &frame, int row,
+                                         Color color) {
+  int x = frame.x;
+  int table_width = frame.width;
   int current_x = x;
+  size_t columns = frame.widths.size();
 
-  // Print each cell in the row
-  for (size_t i = 0; i < texts.size(); i++) {
-    if (col_widths[i] == 0) continue;
+  // Print each cell in the row; the texts are already fitted to the columns
+  for (size_t i = 0; i < columns; i++) {
+    if (frame.widths[i] == 0) continue;
 
-    std::string display_text = format_text_for_column_(texts[i], col_widths[i], it, font, i == 0, is_header_row);
-    it.printf(current_x + 2, current_y + 2 + line_height_.value() / 2, font, color_on, display::TextAlign::CENTER_LEFT,
-              display_text.c_str());
-    if (i < texts.size() - 1) {
-      current_x += col_widths[i];
+    const char *text = row < 0 ? frame.header[i].c_str() : frame.cell(row, i);
+    it.print(current_x + 2, current_y + 2 + frame.line_height / 2, frame.font, color, display::TextAlign::CENTER_LEFT,
+             text);
+    if (i < columns - 1) {
+      current_x += frame.widths[i];
       // Draw vertical grid lines between cells if enabled
-      if (enable_grid_line_.value()) {
+      if (frame.grid_line) {
         int grid_x = (current_x > x + table_width) ? x + table_width : current_x;
-        it.line(grid_x, current_y, grid_x, current_y + line_height_.value(), color_on);
+        it.line(grid_x, current_y, grid_x, current_y + frame.line_height, frame.color_on);
       }
     } else {
       current_x = x + table_width;
     }
   }
-  current_y += line_height_.value();
+  current_y += frame.line_height;
   // Draw horizontal grid line below the row if enabled
-  if (enable_grid_line_.value()) {
-    it.line(x, current_y, x + table_width, current_y, color_on);
+  if (frame.grid_line) {
+    it.line(x, current_y, x + table_width, current_y, frame.color_on);
   }
 }
 
-std::string NotionDatabaseTableView::get_cell_text_(const Page &page, const std::string &col, bool is_first_column,
-                                                    bool is_header_row) {
-  std::string result_text;
+// Writes the text of a cell, with the list style for the first column, into scratch_
+void NotionDatabaseTableView::compose_cell_(const Page &page, size_t column, const TableLayoutKey &key) {
+  scratch_.clear();
+  if (column == 0 && !key.list_style_type.empty()) {
+    scratch_.append(key.list_style_type);
+  }
 
   // Retrieve the property value for the cell
-  const NotionProperty *prop = page.get_property(col);
-  if (prop != nullptr) {
-    if (prop->type == NotionPropertyType::DATE) {
-      result_text = tm_to_datetime(prop->time_value, date_format_.value());
-    } else if (prop->type == NotionPropertyType::CREATED_TIME || prop->type == NotionPropertyType::LAST_EDITED_TIME) {
-      result_text = tm_to_datetime(prop->time_value, datetime_format_.value());
-    } else {
-      result_text = notion_property_to_string(*prop);
-    }
+  NotionProperty prop = page.get_property(column_keys_[column]);
+  if (!prop) {
+    return;
   }
-
-  // Add symbol for the first column if enabled
-  if (is_first_column && !is_header_row && enable_list_style_.value()) {
-    auto list_style_type = list_style_type_.value();
-    if (!list_style_type.empty()) {
-      result_text = list_style_type + result_text;
+  char buffer[64];
+  if (prop.type() == NotionPropertyType::DATE) {
+    std::tm tm_time = prop.time_value();
+    scratch_.append(buffer, std::strftime(buffer, sizeof(buffer), key.date_format.c_str(), &tm_time));
+  } else if (prop.type() == NotionPropertyType::CREATED_TIME || prop.type() == NotionPropertyType::LAST_EDITED_TIME) {
+    std::tm tm_time = prop.time_value();
+    scratch_.append(buffer, std::strftime(buffer, sizeof(buffer), key.datetime_format.c_str(), &tm_time));
+  } else if (prop.type() == NotionPropertyType::MULTI_SELECT) {
+    for (size_t i = 0; i < prop.item_count(); i++) {
+      if (i > 0) scratch_.append(", ");
+      scratch_.append(prop.item(i));
     }
+  } else {
+    // Text properties are read straight from the page store
+    scratch_.append(notion_property_format(prop, buffer, sizeof(buffer)));
   }
-  return result_text;
 }
 
 }  // namespace notion_database
-}  // namespace esphome
\ No newline at end of file
+}  // namespace esphome
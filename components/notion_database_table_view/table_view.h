@@ -5,14 +5,91 @@
 #include "esphome/components/display/display.h"
 #include "esphome/components/notion_database/allocator.h"
 #include "esphome/components/notion_database/notion_database.h"
+#include "glyph_cache.h"
 
 namespace esphome {
 namespace notion_database {
-class Page;
 class NotionDatabase;
 
 enum class TextOverflow { ELLIPSIS, CLIP };
 
+// Column widths are read for every cell drawn, so they live in the database's cache placement
+using ColumnWidths = std::vector<int, Allocator<int>>;
+
+/**
+ * @brief Everything the column widths and fitted cell text depend on.
+ */
+struct TableLayoutKey {
+  uint32_t pages_hash{0};
+  std::vector<std::string> columns;
+  std::vector<int> column_widths;
+  font::Font *font{nullptr};
+  int width{0};
+  int height{0};
+  int line_height{0};
+  bool title_enabled{false};
+  bool header_enabled{false};
+  TextOverflow text_overflow{TextOverflow::ELLIPSIS};
+  std::string date_format;
+  std::string datetime_format;
+  std::string list_style_type;
+  size_t first_row{0};
+
+  bool operator==(const TableLayoutKey &other) const;
+  bool operator!=(const TableLayoutKey &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Everything a table view puts on the display, with cell text already fitted to the columns.
+ *
+ * The view keeps the frame it drew last so the next one can be compared against it.
+ */
+struct TableFrame {
+  int x{0};
+  int y{0};
+  int width{0};
+  int height{0};
+  font::Font *font{nullptr};
+  Color color_on;
+  Color color_off;
+  int line_height{0};
+  bool grid_line{false};
+  bool title_enabled{false};
+  bool invert_title{false};
+  bool header_enabled{false};
+  bool invert_header{false};
+  std::string title;
+  ColumnWidths widths;
+  std::vector<std::string> header;
+  // Y coordinate of the first row
+  int rows_y{0};
+  // Fitted text of the visible cells, each NUL-terminated, and the offset of every cell row by row
+  std::string text;
+  std::vector<uint32_t> cells;
+  // The inputs the widths, header and rows were computed from
+  TableLayoutKey layout_key;
+  bool valid{false};
+
+  size_t row_count() const { return widths.empty() ? 0 : cells.size() / widths.size(); }
+  const char *cell(size_t row, size_t column) const { return text.c_str() + cells[row * widths.size() + column]; }
+  bool same_row(size_t row, const TableFrame &other) const;
+  // Returns whether everything but the rows is the same
+  bool same_layout(const TableFrame &other) const;
+  // Returns the area of a row, including its bottom grid line
+  display::Rect row_rect(size_t row) const;
+};
+
+// Cost of the last frame in microseconds
+struct TableDrawStats {
+  // Building the frame: column widths and fitted cell text
+  uint32_t layout_us{0};
+  // Painting it on the display buffer
+  uint32_t render_us{0};
+  uint32_t rows{0};
+  uint32_t dirty_regions{0};
+  bool layout_cached{false};
+};
+
 class NotionDatabaseTableView : public Component {
  public:
   // Sets the line height for the table view
@@ -87,6 +164,12 @@ class NotionDatabaseTableView : public Component {
     this->enable_list_style_ = enable;
   }
 
+  // Sets how many rows before the end of the loaded pages the next page is requested; 0 disables it
+  template <typename T>
+  void set_prefetch_rows(const T &rows) {
+    this->prefetch_rows_ = rows;
+  }
+
   // Sets the parent database
   void set_database_parent(NotionDatabase *database) { this->database_parent_ = database; }
 
@@ -94,6 +177,34 @@ class NotionDatabaseTableView : public Component {
   void draw(display::Display &it, int x, int y, int width, int height, font::Font *font, Color color_on,
                   Color color_off);
 
+  // Redraws only what changed since the last draw. The display must keep its buffer between updates,
+  // e.g. with auto_clear_enabled: false, since unchanged areas are not painted again.
+  void draw_dirty(display::Display &it, int x, int y, int width, int height, font::Font *font, Color color_on,
+                  Color color_off);
+
+  // Returns the areas painted by the last draw() or draw_dirty(), for displays with partial updates
+  const std::vector<display::Rect> &get_dirty_regions() const { return this->dirty_regions_; }
+
+  // Returns the cost of the last draw() or draw_dirty()
+  const TableDrawStats &get_draw_stats() const { return this->draw_stats_; }
+
+  // Adds a callback called with the cost of every frame drawn
+  void add_on_draw_callback(std::function<void(const TableDrawStats &)> &&callback) {
+    this->draw_callback_.add(std::move(callback));
+  }
+
+  // Makes the row the first one shown; the offset is clamped when the table is drawn
+  void scroll_to(size_t row) { this->scroll_offset_ = row; }
+
+  // Moves the viewport by a number of rows, up when negative
+  void scroll_by(int rows);
+
+  // Returns the index of the first row shown
+  size_t get_scroll_offset() const { return this->scroll_offset_; }
+
+  // Returns how many rows fit below the title and header, as of the last draw
+  size_t get_visible_row_count() const { return this->visible_rows_; }
+
   // Adds a column to the table
   void add_column(const std::string &column) {
     auto trimmed_column = column;
@@ -129,26 +240,41 @@ class NotionDatabaseTableView : public Component {
   TemplatableValue<std::string> datetime_format_;
   TemplatableValue<std::string> list_style_type_;
   TemplatableValue<bool> enable_list_style_;
+  TemplatableValue<int> prefetch_rows_{0};
 
   std::vector<std::string> columns_;
   std::vector<int> column_widths_;
 
-  std::vector<int> calculate_column_widths_(display::Display &it, int width, font::Font *font,
-                                            const std::vector<Page, Allocator<Page>> &pages);
+  size_t scroll_offset_{0};
+  // Rows the database had dropped from the top when the scroll offset was last adjusted
+  size_t evicted_rows_{0};
+  size_t visible_rows_{0};
+
+  TableFrame frame_;
+  TableFrame next_frame_;
+  std::vector<display::Rect> dirty_regions_;
+  TableDrawStats draw_stats_;
+  CallbackManager<void(const TableDrawStats &)> draw_callback_;
+
+  bool build_frame_(display::Display &it, int x, int y, int width, int height, font::Font *font, Color color_on,
+                    Color color_off, TableFrame &frame);
+  void render_frame_(display::Display &it, const TableFrame &frame);
+  void render_row_(display::Display &it, const TableFrame &frame, size_t row);
+  void record_draw_stats_(uint32_t start, uint32_t built);
 
-  void print_row_(display::Display &it, int x, int &current_y, int table_width, bool is_header_row,
-                  const std::vector<std::string> &texts, const std::vector<int> &col_widths, font::Font *font,
-                  Color color_on, Color color_off);
+  // Property keys of columns_, and the text of the cell being laid out
+  std::vector<uint32_t> column_keys_;
+  std::string scratch_;
 
-  std::string format_text_for_column_(const std::string &text, int column_width, display::Display &it, font::Font *font,
-                                      bool is_first_column, bool is_header_row);
+  ColumnWidths calculate_column_widths_(display::Display &it, int width, font::Font *font, const PageTable &pages,
+                                        size_t first_row, size_t last_row, const TableLayoutKey &key);
 
-  int text_width_(display::Display *it, font::Font *font, const std::string &buffer);
+  void print_row_(display::Display &it, int &current_y, const TableFrame &frame, int row, Color color);
 
-  std::string get_cell_text_(const Page &page, const std::string &col, bool is_first_column, bool is_header_row);
+  void fit_text_(std::string &out, const char *text, size_t length, int column_width, font::Font *font,
+                 TextOverflow overflow);
 
-  std::string truncate_text_(const std::string &text, int column_width, display::Display &it, font::Font *font,
-                             const std::string &suffix);
+  void compose_cell_(const Page &page, size_t column, const TableLayoutKey &key);
 };
 
 inline std::string tm_to_datetime(const std::tm &tm_time, const std::string &format) {
@@ -0,0 +1,70 @@
+#include "table_view_sensor.h"
+
+#ifdef USE_SENSOR
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace notion_database {
+
+static const char *const TAG = "table_view.sensor";
+
+void TableViewSensor::setup() {
+  table_view_->add_on_draw_callback([this](const TableDrawStats &stats) {
+    layout_time_.add(stats.layout_us / 1000.0f);
+    render_time_.add(stats.render_us / 1000.0f);
+    draw_time_.add((stats.layout_us + stats.render_us) / 1000.0f);
+  });
+}
+
+void TableViewSensor::set_window_size(size_t window_size) {
+  window_size_ = window_size;
+  layout_time_.set_window_size(window_size);
+  render_time_.set_window_size(window_size);
+  draw_time_.set_window_size(window_size);
+}
+
+void TableViewSensor::set_layout_time_sensor(sensor::Sensor *sensor, Statistic statistic) {
+  layout_time_sensor_ = sensor;
+  layout_time_statistic_ = statistic;
+}
+
+void TableViewSensor::set_render_time_sensor(sensor::Sensor *sensor, Statistic statistic) {
+  render_time_sensor_ = sensor;
+  render_time_statistic_ = statistic;
+}
+
+void TableViewSensor::set_draw_time_sensor(sensor::Sensor *sensor, Statistic statistic) {
+  draw_time_sensor_ = sensor;
+  draw_time_statistic_ = statistic;
+}
+
+void TableViewSensor::update() {
+  // Nothing drawn since boot; a display that is not updated has no frame cost to report
+  if (draw_time_.empty()) {
+    return;
+  }
+  if (layout_time_sensor_ != nullptr) {
+    layout_time_sensor_->publish_state(layout_time_.get(layout_time_statistic_));
+  }
+  if (render_time_sensor_ != nullptr) {
+    render_time_sensor_->publish_state(render_time_.get(render_time_statistic_));
+  }
+  if (draw_time_sensor_ != nullptr) {
+    draw_time_sensor_->publish_state(draw_time_.get(draw_time_statistic_));
+  }
+}
+
+void TableViewSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "Table View Sensor:");
+  ESP_LOGCONFIG(TAG, "  Window Size: %u", static_cast<unsigned>(window_size_));
+  LOG_SENSOR("  ", "Layout Time", layout_time_sensor_);
+  LOG_SENSOR("  ", "Render Time", render_time_sensor_);
+  LOG_SENSOR("  ", "Draw Time", draw_time_sensor_);
+  LOG_UPDATE_INTERVAL(this);
+}
+
+}  // namespace notion_database
+}  // namespace esphome
+
+#endif  // USE_SENSOR
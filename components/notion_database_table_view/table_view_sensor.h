@@ -0,0 +1,50 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#ifdef USE_SENSOR
+
+#include "esphome/components/notion_database/rolling_stats.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "table_view.h"
+
+namespace esphome {
+namespace notion_database {
+
+/**
+ * @brief Publishes the frame cost of a NotionDatabaseTableView as sensors.
+ *
+ * Every frame drawn adds a sample; the configured statistic of the window is published on the
+ * update interval.
+ */
+class TableViewSensor : public PollingComponent {
+ public:
+  void setup() override;
+  void update() override;
+  void dump_config() override;
+
+  void set_table_view(NotionDatabaseTableView *table_view) { table_view_ = table_view; }
+  void set_window_size(size_t window_size);
+  void set_layout_time_sensor(sensor::Sensor *sensor, Statistic statistic);
+  void set_render_time_sensor(sensor::Sensor *sensor, Statistic statistic);
+  void set_draw_time_sensor(sensor::Sensor *sensor, Statistic statistic);
+
+ protected:
+  NotionDatabaseTableView *table_view_{nullptr};
+  size_t window_size_{20};
+
+  sensor::Sensor *layout_time_sensor_{nullptr};
+  sensor::Sensor *render_time_sensor_{nullptr};
+  sensor::Sensor *draw_time_sensor_{nullptr};
+  Statistic layout_time_statistic_{Statistic::AVG};
+  Statistic render_time_statistic_{Statistic::AVG};
+  Statistic draw_time_statistic_{Statistic::AVG};
+  RollingStats layout_time_;
+  RollingStats render_time_;
+  RollingStats draw_time_;
+};
+
+}  // namespace notion_database
+}  // namespace esphome
+
+#endif  // USE_SENSOR
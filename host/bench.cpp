@@ -0,0 +1,513 @@
+// Benchmarks of the page store hot paths on synthetic query results. Built with ArduinoJson, it
+// also parses query responses, the recorded one and synthetic ones, and draws a table view.
+//
+// Prints one JSON object per case, so that runs can be compared by a script:
+//   {"bench":"diff_insert_top","pages":100,"properties":20,"iterations":...,"ns_per_op":...,
+//    "allocs_per_op":...,"peak_bytes":...,"table_bytes":...}
+// Parse cases add the response size as "input_bytes". The recorded response is also encoded as a
+// page set ("encode_recorded", with "encoded_bytes" and the "ratio" to the JSON), decoded into a
+// table ("decode_recorded") and read in place ("read_recorded"), each with the "speedup" over
+// parsing the JSON.
+//
+//   notion_database_bench [--quick] [--data <response.json>]
+// With --quick every case runs once, as a smoke test.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "change_set.h"
+#include "host_heap.h"
+#include "page_codec.h"
+#include "page_table.h"
+#ifdef HOST_HAVE_ARDUINOJSON
+#include "notion_database.h"
+#include "table_view.h"
+#endif
+
+using namespace esphome::notion_database;
+
+namespace {
+
+const size_t PAGE_COUNTS[] = {10, 100, 1000};
+const size_t PROPERTY_COUNTS[] = {5, 20, 50};
+
+// The mix of property types of a typical task or reading list database
+const NotionPropertyType TYPES[] = {
+    NotionPropertyType::TITLE,     NotionPropertyType::STATUS,       NotionPropertyType::DATE,
+    NotionPropertyType::NUMBER,    NotionPropertyType::MULTI_SELECT, NotionPropertyType::RICH_TEXT,
+    NotionPropertyType::SELECT,    NotionPropertyType::CHECKBOX,     NotionPropertyType::URL,
+    NotionPropertyType::LAST_EDITED_TIME,
+};
+
+const char *const WORDS[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+                             "india", "juliet", "kilo", "lima"};
+
+uint32_t next_random(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Appends one page with the given ID, as NotionDatabase::parse_page_ would store it
+void add_page(PageTable &pages, SymbolTable &symbols, size_t properties, uint32_t id, uint32_t edit) {
+  uint32_t random = id * 2654435761u + edit + 1;
+  char text[64];
+  pages.add_row();
+  pages.set_row_key(id);
+  pages.set_row_hash(id * 31 + edit);
+  for (size_t i = 0; i < properties; i++) {
+    NotionPropertyType type = TYPES[i % (sizeof(TYPES) / sizeof(TYPES[0]))];
+    int col = pages.get_or_add_column(Page::hash_key("property " + std::to_string(i)), type);
+    switch (type) {
+      case NotionPropertyType::NUMBER:
+        pages.set_number(col, next_random(random) % 1000);
+        break;
+      case NotionPropertyType::CHECKBOX:
+        pages.set_bool(col, next_random(random) & 1);
+        break;
+      case NotionPropertyType::DATE:
+      case NotionPropertyType::LAST_EDITED_TIME:
+        pages.set_epoch(col, 1700000000 + id * 3600 + edit);
+        break;
+      case NotionPropertyType::SELECT:
+      case NotionPropertyType::STATUS:
+        pages.set_symbol(col, symbols.intern(WORDS[next_random(random) % 4]));
+        break;
+      case NotionPropertyType::MULTI_SELECT:
+        pages.begin_items(col);
+        for (uint32_t n = next_random(random) % 4; n > 0; n--) {
+          pages.add_item(symbols.intern(WORDS[next_random(random) % 12]));
+        }
+        break;
+      default:
+        std::snprintf(text, sizeof(text), "%s %s page %u", WORDS[next_random(random) % 12],
+                      WORDS[next_random(random) % 12], id);
+        pages.set_text(col, text);
+        break;
+    }
+  }
+}
+
+void build_pages(PageTable &pages, const std::shared_ptr<SymbolTable> &symbols, size_t count, size_t properties,
+                 uint32_t first_id = 0) {
+  pages.set_symbols(symbols);
+  for (size_t row = 0; row < count; row++) {
+    add_page(pages, *symbols, properties, first_id + row, 0);
+  }
+}
+
+struct Result {
+  size_t iterations;
+  double ns_per_op;
+  double allocs_per_op;
+  size_t peak_bytes;
+};
+
+// Runs op until about 50 ms have passed, or once in quick mode
+Result measure(bool quick, const std::function<void()> &op) {
+  using Clock = std::chrono::steady_clock;
+  HostHeapStats before = get_host_heap_stats();
+  reset_host_heap_peak();
+  size_t iterations = 0;
+  Clock::time_point start = Clock::now();
+  Clock::duration elapsed;
+  do {
+    op();
+    iterations++;
+    elapsed = Clock::now() - start;
+  } while (!quick && elapsed < std::chrono::milliseconds(50));
+  HostHeapStats after = get_host_heap_stats();
+  return {iterations, std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+          static_cast<double>(after.allocations - before.allocations) / iterations, after.peak - before.bytes};
+}
+
+// extra holds more fields, each starting with a comma
+void report(const char *bench, size_t pages, size_t properties, const Result &result, size_t table_bytes,
+            const std::string &extra = "") {
+  std::printf(
+      "{\"bench\":\"%s\",\"pages\":%zu,\"properties\":%zu,\"iterations\":%zu,\"ns_per_op\":%.0f,"
+      "\"allocs_per_op\":%.1f,\"peak_bytes\":%zu,\"table_bytes\":%zu%s}\n",
+      bench, pages, properties, result.iterations, result.ns_per_op, result.allocs_per_op, result.peak_bytes,
+      table_bytes, extra.c_str());
+}
+
+void run_case(bool quick, size_t count, size_t properties) {
+  auto symbols = std::make_shared<SymbolTable>();
+  PageTable pages(MemoryPlacement::PSRAM);
+  build_pages(pages, symbols, count, properties, 1);
+  size_t table_bytes = pages.memory_usage();
+
+  // Storing a parsed response
+  report("build", count, properties, measure(quick, [&]() {
+           PageTable built;
+           build_pages(built, symbols, count, properties, 1);
+         }),
+         table_bytes);
+
+  // Rebuilding the stored pages around merged or appended ones
+  report("copy_rows", count, properties, measure(quick, [&]() {
+           PageTable copy;
+           copy.set_symbols(symbols);
+           for (Page page : pages) {
+             copy.copy_row(pages, page.index());
+           }
+         }),
+         table_bytes);
+
+  ChangeSet changes;
+  PageTable same;
+  build_pages(same, symbols, count, properties, 1);
+  report("diff_unchanged", count, properties, measure(quick, [&]() { diff_pages(pages, same, changes); }),
+         table_bytes);
+
+  // One page edited in the middle
+  PageTable edited;
+  edited.set_symbols(symbols);
+  for (size_t row = 0; row < count; row++) {
+    add_page(edited, *symbols, properties, 1 + row, row == count / 2 ? 1 : 0);
+  }
+  report("diff_modified", count, properties, measure(quick, [&]() { diff_pages(pages, edited, changes); }),
+         table_bytes);
+
+  // A new page at the top shifts every other row
+  PageTable inserted;
+  build_pages(inserted, symbols, 1, properties, 0);
+  for (Page page : pages) {
+    inserted.copy_row(pages, page.index());
+  }
+  report("diff_insert_top", count, properties, measure(quick, [&]() { diff_pages(pages, inserted, changes); }),
+         table_bytes);
+}
+
+#ifdef HOST_HAVE_ARDUINOJSON
+
+// Serves a response from memory, like a connection on which the whole body has arrived
+class MemoryStream : public Stream {
+ public:
+  explicit MemoryStream(const std::string &data) : data_(data) {}
+
+  int available() override { return static_cast<int>(data_.size() - pos_); }
+  int read() override { return pos_ < data_.size() ? static_cast<uint8_t>(data_[pos_++]) : -1; }
+  int peek() override { return pos_ < data_.size() ? static_cast<uint8_t>(data_[pos_]) : -1; }
+  size_t readBytes(char *buffer, size_t length) override {
+    length = std::min(length, data_.size() - pos_);
+    std::memcpy(buffer, data_.data() + pos_, length);
+    pos_ += length;
+    return length;
+  }
+  size_t write(uint8_t byte) override { return 0; }
+
+ protected:
+  const std::string &data_;
+  size_t pos_{0};
+};
+
+// Exposes the parse of a fetch, and shows pages without fetching them
+class BenchDatabase : public NotionDatabase {
+ public:
+  BenchDatabase() { set_json_parse_buffer_size(20480u); }
+
+  // Parses a response as a fetch does once the headers have arrived; returns 0 if it failed
+  uint32_t parse(const std::string &response, QueryResult &result) {
+    if (request_.page_filter.isNull() && !prepare_request_(FetchMode::PAGE, request_, result)) {
+      return 0;
+    }
+    result.symbols = symbols_;
+    result.pages.set_symbols(symbols_);
+    MemoryStream stream(response);
+    uint32_t pages_hash = process_response_(stream, response.size(), request_, result);
+    arena_.reset();
+    return pages_hash;
+  }
+
+  void show(PageTable &&pages) { publish_pages_(std::move(pages)); }
+};
+
+// Appends a rich text array of one text run, as Notion sends titles and text properties
+void append_rich_text(std::string &json, const char *text) {
+  json += "[{\"type\":\"text\",\"text\":{\"content\":\"";
+  json += text;
+  json += "\",\"link\":null},\"annotations\":{\"bold\":false,\"italic\":false,\"strikethrough\":false,"
+          "\"underline\":false,\"code\":false,\"color\":\"default\"},\"plain_text\":\"";
+  json += text;
+  json += "\",\"href\":null}]";
+}
+
+// Returns a query response with the pages build_pages() stores, in the format Notion sends them
+std::string build_response(size_t count, size_t properties) {
+  std::string json = "{\"object\":\"list\",\"results\":[";
+  char buffer[256];
+  char timestamp[32];
+  char text[64];
+  for (uint32_t id = 1; id <= count; id++) {
+    uint32_t random = id * 2654435761u + 1;
+    time_t epoch = 1700000000 + id * 3600;
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:00.000Z", std::gmtime(&epoch));
+    std::snprintf(buffer, sizeof(buffer),
+                  "%s{\"object\":\"page\",\"id\":\"%08x-0000-4000-8000-000000000000\",\"created_time\":\"%s\","
+                  "\"last_edited_time\":\"%s\",",
+                  id > 1 ? "," : "", id, timestamp, timestamp);
+    json += buffer;
+    json += "\"created_by\":{\"object\":\"user\",\"id\":\"u-1\"},\"last_edited_by\":{\"object\":\"user\",\"id\":\"u-1\"},"
+            "\"cover\":null,\"icon\":null,\"parent\":{\"type\":\"database_id\","
+            "\"database_id\":\"d3adbeef-0000-4000-8000-000000000001\"},\"archived\":false,\"in_trash\":false,"
+            "\"properties\":{";
+    for (size_t i = 0; i < properties; i++) {
+      NotionPropertyType type = TYPES[i % (sizeof(TYPES) / sizeof(TYPES[0]))];
+      std::string name = notion_property_type_to_string(type);
+      std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+      std::snprintf(buffer, sizeof(buffer), "%s\"property %zu\":{\"id\":\"p%zu\",\"type\":\"%s\",\"%s\":",
+                    i > 0 ? "," : "", i, i, name.c_str(), name.c_str());
+      json += buffer;
+      switch (type) {
+        case NotionPropertyType::NUMBER:
+          json += std::to_string(next_random(random) % 1000);
+          break;
+        case NotionPropertyType::CHECKBOX:
+          json += next_random(random) & 1 ? "true" : "false";
+          break;
+        case NotionPropertyType::DATE:
+          std::strftime(buffer, sizeof(buffer), "{\"start\":\"%Y-%m-%d\",\"end\":null,\"time_zone\":null}",
+                        std::gmtime(&epoch));
+          json += buffer;
+          break;
+        case NotionPropertyType::LAST_EDITED_TIME:
+          json += std::string("\"") + timestamp + "\"";
+          break;
+        case NotionPropertyType::SELECT:
+        case NotionPropertyType::STATUS:
+          std::snprintf(buffer, sizeof(buffer), "{\"id\":\"o-1\",\"name\":\"%s\",\"color\":\"blue\"}",
+                        WORDS[next_random(random) % 4]);
+          json += buffer;
+          break;
+        case NotionPropertyType::MULTI_SELECT:
+          json += '[';
+          for (uint32_t n = next_random(random) % 4, first = 1; n > 0; n--, first = 0) {
+            std::snprintf(buffer, sizeof(buffer), "%s{\"id\":\"o-2\",\"name\":\"%s\",\"color\":\"green\"}",
+                          first ? "" : ",", WORDS[next_random(random) % 12]);
+            json += buffer;
+          }
+          json += ']';
+          break;
+        default:
+          std::snprintf(text, sizeof(text), "%s %s page %u", WORDS[next_random(random) % 12],
+                        WORDS[next_random(random) % 12], id);
+          if (type == NotionPropertyType::URL) {
+            json += std::string("\"") + text + "\"";
+          } else {
+            append_rich_text(json, text);
+          }
+          break;
+      }
+      json += '}';
+    }
+    std::snprintf(buffer, sizeof(buffer), "},\"url\":\"https://www.notion.so/%08x\",\"public_url\":null}", id);
+    json += buffer;
+  }
+  json += "],\"next_cursor\":null,\"has_more\":false,\"type\":\"page_or_database\",\"page_or_database\":{},"
+          "\"request_id\":\"00000000-0000-4000-8000-000000000000\"}";
+  return json;
+}
+
+// Encodes the pages of a parsed response as a page set, as snapshots and shared pages are, then
+// decodes it back into a table and walks it in place; reports the sizes against the JSON, the times
+// against parsing it, and false if the encoding is not 5 times smaller than the JSON or does not
+// decode
+bool run_codec(bool quick, const std::string &name, const std::string &response, const PageTable &pages,
+               double parse_ns) {
+  std::vector<uint8_t> encoded;
+  Result result = measure(quick, [&]() {
+    encoded.clear();
+    ByteWriter writer(encoded);
+    encode_page_set(pages, writer);
+  });
+  double ratio = static_cast<double>(response.size()) / encoded.size();
+  char extra[160];
+  std::snprintf(extra, sizeof(extra), ",\"input_bytes\":%zu,\"encoded_bytes\":%zu,\"ratio\":%.1f", response.size(),
+                encoded.size(), ratio);
+  report(("encode_" + name).c_str(), pages.size(), pages.columns().size(), result, pages.memory_usage(), extra);
+
+  bool decoded = true;
+  size_t table_bytes = 0;
+  result = measure(quick, [&]() {
+    PageTable table(MemoryPlacement::PSRAM);
+    ByteReader reader(encoded.data(), encoded.size());
+    decoded = decode_page_set(reader, table, std::make_shared<SymbolTable>()) && decoded;
+    table_bytes = table.memory_usage();
+  });
+  std::snprintf(extra, sizeof(extra), ",\"encoded_bytes\":%zu,\"parse_ns_per_op\":%.0f,\"speedup\":%.1f",
+                encoded.size(), parse_ns, parse_ns / result.ns_per_op);
+  report(("decode_" + name).c_str(), pages.size(), pages.columns().size(), result, table_bytes, extra);
+
+  // Every cell is read where it lies; only the symbol and column lists are allocated
+  size_t cells = 0;
+  result = measure(quick, [&]() {
+    ByteReader reader(encoded.data(), encoded.size());
+    PageSetReader set;
+    PageSetCell cell;
+    cells = 0;
+    if (!set.open(reader)) {
+      decoded = false;
+      return;
+    }
+    while (set.next_row()) {
+      while (set.next_cell(cell)) {
+        if (cell.type == NotionPropertyType::MULTI_SELECT) {
+          for (uint16_t item = 0; item < cell.item_count; item++) {
+            set.next_item();
+          }
+        }
+        cells++;
+      }
+    }
+    decoded = reader.ok() && reader.at_end() && decoded;
+  });
+  std::snprintf(extra, sizeof(extra), ",\"encoded_bytes\":%zu,\"cells\":%zu,\"parse_ns_per_op\":%.0f,\"speedup\":%.1f",
+                encoded.size(), cells, parse_ns, parse_ns / result.ns_per_op);
+  report(("read_" + name).c_str(), pages.size(), pages.columns().size(), result, 0, extra);
+
+  if (!decoded) {
+    std::fprintf(stderr, "%s: page set does not decode\n", name.c_str());
+  }
+  if (ratio < 5.0) {
+    std::fprintf(stderr, "%s: page set is only %.1f times smaller than the JSON\n", name.c_str(), ratio);
+  }
+  return decoded && ratio >= 5.0;
+}
+
+// Parses a response repeatedly, as polling an unchanged database does; false if it did not parse.
+// Without a property count, the columns the pages were parsed into are reported. With a codec name,
+// the parsed pages are also encoded and decoded as a page set.
+bool run_parse(bool quick, const char *bench, const std::string &response, size_t properties,
+               const char *codec = nullptr) {
+  BenchDatabase database;
+  size_t pages = 0;
+  size_t columns = 0;
+  size_t table_bytes = 0;
+  bool parsed = true;
+  Result result = measure(quick, [&]() {
+    QueryResult query_result(MemoryPlacement::PSRAM);
+    parsed = database.parse(response, query_result) != 0 && parsed;
+    pages = query_result.pages.size();
+    columns = query_result.pages.columns().size();
+    table_bytes = query_result.pages.memory_usage();
+  });
+  report(bench, pages, properties != 0 ? properties : columns, result, table_bytes, ",\"input_bytes\":" + std::to_string(response.size()));
+  if (!parsed) {
+    std::fprintf(stderr, "%s: parse failed\n", bench);
+    return false;
+  }
+  if (codec == nullptr) {
+    return true;
+  }
+  QueryResult query_result(MemoryPlacement::PSRAM);
+  database.parse(response, query_result);
+  return run_codec(quick, codec, response, query_result.pages, result.ns_per_op);
+}
+
+// Parses the recorded response of a task database, and compares it with its page set encoding
+bool run_recorded_parse_case(bool quick, const char *path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::fprintf(stderr, "Cannot read %s\n", path);
+    return false;
+  }
+  std::stringstream data;
+  data << file.rdbuf();
+  return run_parse(quick, "parse_recorded", data.str(), 0, "recorded");
+}
+
+bool run_parse_case(bool quick, size_t count, size_t properties) {
+  return run_parse(quick, "parse", build_response(count, properties), properties);
+}
+
+// Draws up to 6 of the properties on an 800x480 display, as an e-paper dashboard would
+void run_draw_case(bool quick, size_t count, size_t properties) {
+  BenchDatabase database;
+  PageTable pages;
+  build_pages(pages, std::make_shared<SymbolTable>(), count, properties, 1);
+  size_t table_bytes = pages.memory_usage();
+  database.show(std::move(pages));
+
+  esphome::display::Display display(800, 480);
+  esphome::font::Font font(16);
+  esphome::Color on(255, 255, 255);
+  esphome::Color off(0, 0, 0);
+  NotionDatabaseTableView view;
+  view.set_database_parent(&database);
+  view.set_line_height(20);
+  view.set_enable_header(true);
+  view.set_enable_grid_line(true);
+  for (size_t i = 0; i < std::min<size_t>(properties, 6); i++) {
+    view.add_column("property " + std::to_string(i));
+  }
+  auto frame_stats = [&]() {
+    const TableDrawStats &stats = view.get_draw_stats();
+    return ",\"rows\":" + std::to_string(stats.rows) + ",\"layout_us\":" + std::to_string(stats.layout_us) +
+           ",\"render_us\":" + std::to_string(stats.render_us);
+  };
+
+  // Every frame is painted again; the layout is cached after the first
+  view.draw(display, 0, 0, 800, 480, &font, on, off);
+  Result result = measure(quick, [&]() { view.draw(display, 0, 0, 800, 480, &font, on, off); });
+  report("draw", count, properties, result, table_bytes, frame_stats());
+
+  // The width alternates, so every frame lays the table out again
+  int width = 800;
+  result = measure(quick, [&]() {
+    width = width == 800 ? 799 : 800;
+    view.draw(display, 0, 0, width, 480, &font, on, off);
+  });
+  report("draw_layout", count, properties, result, table_bytes, frame_stats());
+
+  // Nothing changed, so nothing is painted
+  view.draw_dirty(display, 0, 0, 800, 480, &font, on, off);
+  result = measure(quick, [&]() { view.draw_dirty(display, 0, 0, 800, 480, &font, on, off); });
+  report("draw_dirty_unchanged", count, properties, result, table_bytes, frame_stats());
+}
+
+#endif
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool quick = false;
+  const char *data = BENCH_DATA;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else if (std::strcmp(argv[i], "--data") == 0 && i + 1 < argc) {
+      data = argv[++i];
+    } else {
+      std::fprintf(stderr, "Usage: %s [--quick] [--data <response.json>]\n", argv[0]);
+      return 2;
+    }
+  }
+  bool success = true;
+  for (size_t count : PAGE_COUNTS) {
+    for (size_t properties : PROPERTY_COUNTS) {
+      run_case(quick, count, properties);
+    }
+  }
+#ifdef HOST_HAVE_ARDUINOJSON
+  success = run_recorded_parse_case(quick, data) && success;
+  for (size_t count : PAGE_COUNTS) {
+    for (size_t properties : PROPERTY_COUNTS) {
+      success = run_parse_case(quick, count, properties) && success;
+      run_draw_case(quick, count, properties);
+    }
+  }
+#else
+  (void) data;
+#endif
+  return success ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+# Downloads ArduinoJson into SOURCE_DIR. CMakeLists.txt runs this in script mode, so that without
+# network access the download fails, once and quickly, without failing the configure step.
+#
+#   cmake -DVERSION=7.4.2 -DSOURCE_DIR=... -DWORK_DIR=... -P fetch_arduinojson.cmake
+include(FetchContent)
+
+set(archive ${WORK_DIR}/ArduinoJson-${VERSION}.tar.gz)
+if(NOT EXISTS ${archive})
+  file(DOWNLOAD https://github.com/bblanchon/ArduinoJson/archive/refs/tags/v${VERSION}.tar.gz ${archive}.part
+       STATUS status TIMEOUT 60)
+  list(GET status 0 code)
+  if(NOT code EQUAL 0)
+    file(REMOVE ${archive}.part)
+    list(GET status 1 reason)
+    message(FATAL_ERROR "Downloading ArduinoJson ${VERSION} failed: ${reason}")
+  endif()
+  file(RENAME ${archive}.part ${archive})
+endif()
+
+FetchContent_Populate(arduinojson
+  QUIET
+  URL ${archive}
+  SOURCE_DIR ${SOURCE_DIR}
+  SUBBUILD_DIR ${WORK_DIR}/subbuild
+  BINARY_DIR ${WORK_DIR}/build
+)
@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+"""Local stand-in for the Notion database query API, for load tests of notion_database.
+
+Serves POST /v1/databases/<id>/query from a recorded response. The pages of the recorded
+response are split into pages of `page_size` results, with `start_cursor`, `next_cursor` and
+`has_more` as Notion sends them, and a `last_edited_time` `on_or_after` condition, as sent by
+incremental sync, is applied. The server can also misbehave on purpose:
+
+  --rate-limit-every N   answer every Nth request with 429 and a Retry-After header
+  --truncate-every N     cut every Nth body in half and close the connection
+  --drip BYTES           send bodies BYTES at a time, waiting --drip-delay ms in between
+  --chunked              send bodies to HTTP/1.1 clients with chunked transfer encoding, --chunk-size
+                         bytes each
+  --latency MS           wait before answering
+  --idle-timeout S       close keep-alive connections that carry no request for S seconds
+  --drop-reused-every N  close the connection instead of answering every Nth request that
+                         arrives on a reused connection, like a server whose idle timeout expires
+                         just as the request is sent
+  --certfile PEM         serve HTTPS with the certificate and key in PEM
+
+Point a device at it with `base_url: http://<host>:<port>`. HTTP/1.1 keep-alive is supported,
+so `keep_alive: true` reuses connections as it would with api.notion.com. `GET /stats` returns
+the number of connections that carried a query, of queries, and of dropped requests.
+
+`--self-test` starts the server on a free port and checks every behavior with a client.
+"""
+
+import argparse
+import http.client
+import http.server
+import json
+import os
+import re
+import ssl
+import sys
+import threading
+import time
+
+QUERY_PATH = re.compile(r"^/v1/databases/[^/]+/query$")
+CURSOR_PREFIX = "cursor-"
+DEFAULT_DATA = os.path.join(os.path.dirname(os.path.abspath(__file__)), "data", "tasks.json")
+
+
+def find_watermark(node):
+    """Returns the on_or_after value of a last_edited_time condition anywhere in a filter."""
+    if isinstance(node, dict):
+        if node.get("timestamp") == "last_edited_time":
+            return node.get("last_edited_time", {}).get("on_or_after")
+        for value in node.values():
+            found = find_watermark(value)
+            if found is not None:
+                return found
+    elif isinstance(node, list):
+        for value in node:
+            found = find_watermark(value)
+            if found is not None:
+                return found
+    return None
+
+
+def query_results(recorded, query):
+    """Returns the response body for a query against the recorded results."""
+    results = recorded["results"]
+    watermark = find_watermark(query.get("filter"))
+    if watermark is not None:
+        # Notion compares to the minute, as last_edited_time is rounded to minutes
+        results = [page for page in results if page["last_edited_time"][:16] >= watermark[:16]]
+
+    page_size = max(1, min(int(query.get("page_size", 100)), 100))
+    start = 0
+    cursor = query.get("start_cursor")
+    if cursor:
+        if not cursor.startswith(CURSOR_PREFIX) or not cursor[len(CURSOR_PREFIX):].isdigit():
+            return 400, {"object": "error", "status": 400, "code": "validation_error",
+                         "message": "start_cursor is not valid"}
+        start = int(cursor[len(CURSOR_PREFIX):])
+
+    end = start + page_size
+    has_more = end < len(results)
+    body = dict(recorded)
+    body["results"] = results[start:end]
+    body["has_more"] = has_more
+    body["next_cursor"] = CURSOR_PREFIX + str(end) if has_more else None
+    return 200, body
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    # Headers and body are written apart; with Nagle the body would wait for the client's delayed ACK
+    disable_nagle_algorithm = True
+
+    def setup(self):
+        # Applies to waiting for the next request as well; a connection that times out is closed
+        self.timeout = self.server.options.idle_timeout or None
+        self.queries = 0
+        super().setup()
+
+    def log_message(self, format, *args):
+        if self.server.options.verbose:
+            super().log_message(format, *args)
+
+    def do_GET(self):
+        if self.path != "/stats":
+            self.send_json(404, {"object": "error", "status": 404, "code": "object_not_found", "message": "Not found"})
+            return
+        with self.server.lock:
+            stats = {"connections": self.server.connections, "requests": self.server.requests,
+                     "dropped": self.server.dropped}
+        self.send_json(200, stats)
+
+    def do_POST(self):
+        options = self.server.options
+        length = int(self.headers.get("Content-Length", 0))
+        payload = self.rfile.read(length) if length > 0 else b""
+        self.queries += 1
+        with self.server.lock:
+            if self.queries == 1:
+                self.server.connections += 1
+            elif options.drop_reused_every > 0:
+                self.server.reused += 1
+                if self.server.reused % options.drop_reused_every == 0:
+                    self.server.dropped += 1
+                    self.close_connection = True
+                    return
+            self.server.requests += 1
+            count = self.server.requests
+
+        if options.latency > 0:
+            time.sleep(options.latency / 1000)
+
+        if not QUERY_PATH.match(self.path):
+            self.send_json(404, {"object": "error", "status": 404, "code": "object_not_found", "message": "Not found"})
+            return
+        if options.rate_limit_every > 0 and count % options.rate_limit_every == 0:
+            self.send_json(429, {"object": "error", "status": 429, "code": "rate_limited",
+                                 "message": "You have been rate limited. Please try again in a few minutes."},
+                           {"Retry-After": str(options.retry_after)})
+            return
+
+        try:
+            query = json.loads(payload) if payload.strip() else {}
+        except ValueError:
+            self.send_json(400, {"object": "error", "status": 400, "code": "invalid_json", "message": "Invalid JSON"})
+            return
+        status, body = query_results(self.server.recorded, query)
+        truncate = options.truncate_every > 0 and count % options.truncate_every == 0
+        self.send_json(status, body, truncate=truncate)
+
+    def send_json(self, status, body, headers=None, truncate=False):
+        options = self.server.options
+        # HTTP/1.0 clients, as the component is without keep_alive, cannot decode chunks
+        chunked = options.chunked and self.request_version == "HTTP/1.1"
+        data = json.dumps(body).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        if chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+        else:
+            self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+
+        if truncate:
+            # The connection is closed before the body is complete
+            data = data[:len(data) // 2]
+            self.close_connection = True
+        if chunked:
+            for start in range(0, len(data), options.chunk_size):
+                chunk = data[start:start + options.chunk_size]
+                self.write_body(b"%x\r\n" % len(chunk) + chunk + b"\r\n")
+            if not truncate:
+                self.write_body(b"0\r\n\r\n")
+        else:
+            self.write_body(data)
+
+    def write_body(self, data):
+        options = self.server.options
+        if options.drip <= 0:
+            self.wfile.write(data)
+            return
+        for start in range(0, len(data), options.drip):
+            self.wfile.write(data[start:start + options.drip])
+            self.wfile.flush()
+            time.sleep(options.drip_delay / 1000)
+
+
+class MockServer(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, options, recorded):
+        super().__init__(address, Handler)
+        self.options = options
+        self.recorded = recorded
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.connections = 0
+        self.reused = 0
+        self.dropped = 0
+        if options.certfile:
+            context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+            context.load_cert_chain(options.certfile)
+            self.socket = context.wrap_socket(self.socket, server_side=True)
+
+
+def parse_args(argv):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--data", default=DEFAULT_DATA, help="recorded query response to serve")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--rate-limit-every", type=int, default=0)
+    parser.add_argument("--retry-after", type=int, default=1)
+    parser.add_argument("--truncate-every", type=int, default=0)
+    parser.add_argument("--drip", type=int, default=0)
+    parser.add_argument("--drip-delay", type=int, default=10)
+    parser.add_argument("--chunked", action="store_true")
+    parser.add_argument("--chunk-size", type=int, default=512)
+    parser.add_argument("--latency", type=int, default=0)
+    parser.add_argument("--idle-timeout", type=float, default=0)
+    parser.add_argument("--drop-reused-every", type=int, default=0)
+    parser.add_argument("--certfile")
+    parser.add_argument("--verbose", action="store_true")
+    parser.add_argument("--self-test", action="store_true")
+    return parser.parse_args(argv)
+
+
+def load_recorded(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def post(port, query, path="/v1/databases/db/query"):
+    connection = http.client.HTTPConnection("127.0.0.1", port, timeout=5)
+    try:
+        connection.request("POST", path, json.dumps(query), {"Content-Type": "application/json"})
+        response = connection.getresponse()
+        try:
+            body = response.read()
+        except http.client.IncompleteRead as error:
+            return response.status, response.headers, None, len(error.partial)
+        return response.status, response.headers, json.loads(body), len(body)
+    finally:
+        connection.close()
+
+
+def self_test(args):
+    recorded = load_recorded(args.data)
+    total = len(recorded["results"])
+    failures = []
+
+    def check(name, condition):
+        print(("ok   " if condition else "FAIL ") + name)
+        if not condition:
+            failures.append(name)
+
+    def serve(**overrides):
+        options = parse_args(["--data", args.data])
+        for name, value in overrides.items():
+            setattr(options, name, value)
+        server = MockServer(("127.0.0.1", 0), options, recorded)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        return server
+
+    server = serve()
+    port = server.server_address[1]
+    seen = []
+    cursor = None
+    while True:
+        query = {"page_size": 10}
+        if cursor:
+            query["start_cursor"] = cursor
+        status, _, body, _ = post(port, query)
+        if status != 200:
+            break
+        seen.extend(page["id"] for page in body["results"])
+        if not body["has_more"]:
+            break
+        cursor = body["next_cursor"]
+    check("pagination returns every page once", seen == [page["id"] for page in recorded["results"]])
+    status, _, body, _ = post(port, {"page_size": 10, "start_cursor": "nope"})
+    check("invalid cursor is rejected", status == 400)
+    watermark = recorded["results"][-3]["last_edited_time"]
+    status, _, body, _ = post(port, {"filter": {"and": [{"property": "Urgent", "checkbox": {"equals": True}}, {
+        "timestamp": "last_edited_time", "last_edited_time": {"on_or_after": watermark}}]}})
+    check("watermark filter keeps recent edits", status == 200 and len(body["results"]) == 3)
+    server.shutdown()
+
+    server = serve(rate_limit_every=2, retry_after=7)
+    port = server.server_address[1]
+    first = post(port, {})
+    second = post(port, {})
+    check("every second request is rate limited",
+          first[0] == 200 and second[0] == 429 and second[1].get("Retry-After") == "7")
+    server.shutdown()
+
+    server = serve(chunked=True, chunk_size=100, drip=700, drip_delay=1)
+    port = server.server_address[1]
+    status, headers, body, _ = post(port, {})
+    check("chunked and dripped body decodes",
+          status == 200 and headers.get("Transfer-Encoding") == "chunked" and len(body["results"]) == total)
+    server.shutdown()
+
+    server = serve(truncate_every=1)
+    port = server.server_address[1]
+    status, _, body, size = post(port, {})
+    check("truncated body is cut short", status == 200 and body is None and size > 0)
+    server.shutdown()
+
+    server = serve(drop_reused_every=2)
+    port = server.server_address[1]
+    connection = http.client.HTTPConnection("127.0.0.1", port, timeout=5)
+    statuses = []
+    for _ in range(3):
+        try:
+            connection.request("POST", "/v1/databases/db/query", "{}", {"Content-Type": "application/json"})
+            response = connection.getresponse()
+            response.read()
+            statuses.append(response.status)
+        except (http.client.HTTPException, OSError):
+            statuses.append(None)
+            connection.close()
+    connection.close()
+    connection = http.client.HTTPConnection("127.0.0.1", port, timeout=5)
+    connection.request("GET", "/stats")
+    stats = json.loads(connection.getresponse().read())
+    connection.close()
+    check("second reused request is dropped", statuses == [200, 200, None])
+    check("stats count connections and drops",
+          stats == {"connections": 1, "requests": 2, "dropped": 1})
+    server.shutdown()
+
+    server = serve(idle_timeout=0.2)
+    port = server.server_address[1]
+    connection = http.client.HTTPConnection("127.0.0.1", port, timeout=5)
+    connection.request("POST", "/v1/databases/db/query", "{}", {"Content-Type": "application/json"})
+    connection.getresponse().read()
+    time.sleep(0.5)
+    check("idle connection is closed", connection.sock.recv(1) == b"")
+    connection.close()
+    server.shutdown()
+
+    return 1 if failures else 0
+
+
+def main(argv):
+    args = parse_args(argv)
+    if args.self_test:
+        return self_test(args)
+    server = MockServer((args.host, args.port), args, load_recorded(args.data))
+    # With --port 0 the port is picked by the system; a test reads it from this line
+    print("Serving %s on %s://%s:%d" % (args.data, "https" if args.certfile else "http", args.host,
+                                        server.server_address[1]), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print("%d requests served" % server.requests)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,121 @@
+#pragma once
+// Runs mock_notion_server.py in a child process for the tests that talk to it over HTTP.
+
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <HTTPClient.h>
+
+class MockServer {
+ public:
+  MockServer(const std::string &python, const std::string &script, const std::string &data)
+      : python_(python), script_(script), data_(data) {}
+  MockServer(const MockServer &) = delete;
+  MockServer &operator=(const MockServer &) = delete;
+  ~MockServer() { stop(); }
+
+  // Starts the server on a free port with the given extra options; returns false if it did not come up
+  bool start(const std::vector<std::string> &options = {}) {
+    stop();
+    int out[2];
+    if (pipe(out) != 0) {
+      return false;
+    }
+    std::vector<std::string> args = {python_, script_, "--data", data_, "--port", "0"};
+    args.insert(args.end(), options.begin(), options.end());
+    pid_ = fork();
+    if (pid_ == 0) {
+      dup2(out[1], STDOUT_FILENO);
+      close(out[0]);
+      close(out[1]);
+      std::vector<char *> argv;
+      for (auto &arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+      }
+      argv.push_back(nullptr);
+      execvp(argv[0], argv.data());
+      _exit(127);
+    }
+    close(out[1]);
+    if (pid_ < 0) {
+      close(out[0]);
+      return false;
+    }
+    // The server prints "Serving <data> on <scheme>://<host>:<port>" once it listens
+    FILE *output = fdopen(out[0], "r");
+    char line[512];
+    bool listening = false;
+    if (fgets(line, sizeof(line), output) != nullptr) {
+      std::string text(line);
+      size_t scheme = text.find("://");
+      size_t colon = text.rfind(':');
+      if (scheme != std::string::npos && colon > scheme) {
+        secure_ = text.compare(scheme - 5, 5, "https") == 0;
+        port_ = static_cast<uint16_t>(std::stoi(text.substr(colon + 1)));
+        listening = port_ != 0;
+      }
+    }
+    output_ = output;
+    if (!listening) {
+      stop();
+    }
+    return listening;
+  }
+
+  // Stops the server; connections it held are closed
+  void stop() {
+    if (pid_ > 0) {
+      kill(pid_, SIGTERM);
+      waitpid(pid_, nullptr, 0);
+    }
+    pid_ = -1;
+    if (output_ != nullptr) {
+      fclose(output_);
+      output_ = nullptr;
+    }
+  }
+
+  uint16_t port() const { return port_; }
+  // Returns the scheme and host, as base_url takes them; localhost, so that TLS sends a server name
+  std::string base_url() const {
+    return std::string(secure_ ? "https" : "http") + "://localhost:" + std::to_string(port_);
+  }
+  // Returns the URL of the query endpoint
+  std::string query_url() const { return base_url() + "/v1/databases/db/query"; }
+
+  struct Stats {
+    int connections{-1};
+    int requests{-1};
+    int dropped{-1};
+  };
+
+  // Returns the counters of GET /stats, or -1 for each if the server did not answer
+  Stats stats() const {
+    Stats stats;
+    HTTPClient http;
+    http.setReuse(false);
+    http.begin(String(base_url() + "/stats"));
+    if (http.GET() == HTTP_CODE_OK) {
+      String body = http.getString();
+      if (std::sscanf(body.c_str(), "{\"connections\": %d, \"requests\": %d, \"dropped\": %d}", &stats.connections,
+                      &stats.requests, &stats.dropped) != 3) {
+        stats = Stats{};
+      }
+    }
+    http.end();
+    return stats;
+  }
+
+ protected:
+  std::string python_;
+  std::string script_;
+  std::string data_;
+  pid_t pid_{-1};
+  FILE *output_{nullptr};
+  uint16_t port_{0};
+  bool secure_{false};
+};
@@ -0,0 +1,59 @@
+#pragma once
+// Host stand-in for the parts of the Arduino core that the component's stream and HTTP classes use
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// The few members of the Arduino String that the component uses
+class String {
+ public:
+  String(const char *text = "") : text_(text != nullptr ? text : "") {}
+  String(const std::string &text) : text_(text) {}
+
+  const char *c_str() const { return text_.c_str(); }
+  unsigned int length() const { return text_.size(); }
+  bool isEmpty() const { return text_.empty(); }
+  bool equalsIgnoreCase(const String &other) const;
+  bool operator==(const String &other) const { return text_ == other.text_; }
+  bool operator!=(const String &other) const { return text_ != other.text_; }
+  String &operator+=(const String &other) {
+    text_ += other.text_;
+    return *this;
+  }
+  int toInt() const { return std::atoi(text_.c_str()); }
+
+ protected:
+  std::string text_;
+};
+
+class Print {
+ public:
+  virtual ~Print() = default;
+  virtual size_t write(uint8_t byte) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+};
+
+// Like the Arduino Stream: read() returns -1 while no byte has arrived, and readBytes() waits
+// up to the timeout for each byte
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { timeout_ = timeout; }
+  unsigned long getTimeout() const { return timeout_; }
+  virtual size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes(reinterpret_cast<char *>(buffer), length); }
+
+ protected:
+  int timedRead();
+
+  unsigned long timeout_{1000};
+};
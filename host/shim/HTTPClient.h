@@ -0,0 +1,102 @@
+#pragma once
+// Host stand-in for the ESP32 Arduino HTTPClient over POSIX sockets, with TLS through OpenSSL when
+// HOST_HAVE_OPENSSL is defined. It keeps the behavior HttpSession depends on: the connection opened
+// by connect() is reused by the next request when reuse is set and the server kept it open, end()
+// discards what is left of the body, and connected() notices a connection the server has closed.
+// Certificates are not verified, as with a client that has no CA certificate set.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_TOO_MANY_REQUESTS 429
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// A TCP connection, optionally over TLS; read() returns -1 while no byte has arrived
+class NetworkClient : public Stream {
+ public:
+  NetworkClient() = default;
+  NetworkClient(const NetworkClient &) = delete;
+  NetworkClient &operator=(const NetworkClient &) = delete;
+  ~NetworkClient() override { stop(); }
+
+  // Connects within timeout milliseconds, including the TLS handshake
+  bool connect(const std::string &host, uint16_t port, bool secure, uint32_t timeout);
+  bool connected();
+  void stop();
+  // Discards the bytes received so far
+  void flush();
+  // Writes all of data within the stream timeout
+  bool write_all(const char *data, size_t length);
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t byte) override { return write_all(reinterpret_cast<const char *>(&byte), 1) ? 1 : 0; }
+
+ protected:
+  // Receives into the buffer, waiting up to wait_ms for data; false once the connection is closed
+  bool fill_(int wait_ms);
+
+  int fd_{-1};
+  void *ssl_{nullptr};
+  std::vector<char> buffer_;
+  size_t pos_{0};
+  bool closed_{false};
+};
+
+class HTTPClient {
+ public:
+  HTTPClient();
+
+  bool begin(String url);
+  void end();
+  void useHTTP10(bool http10) { http10_ = http10; }
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setConnectTimeout(int32_t timeout) { connect_timeout_ = timeout; }
+  void setTimeout(uint16_t timeout) { timeout_ = timeout; }
+  void addHeader(const String &name, const String &value);
+  void collectHeaders(const char *keys[], size_t count);
+
+  int POST(const String &payload) { return send_request_("POST", payload.c_str()); }
+  int GET() { return send_request_("GET", ""); }
+  // Reads the rest of the body, decoding a chunked one
+  String getString();
+  // Returns the connection, positioned at the start of the body
+  Stream &getStream() { return client_; }
+  // Returns the Content-Length of the response, or -1
+  int getSize() { return size_; }
+  bool connected() { return client_.connected(); }
+  String header(const char *name);
+  bool hasHeader(const char *name);
+
+ protected:
+  bool connect();
+  int send_request_(const char *method, const char *payload);
+  int read_response_header_();
+  bool read_line_(std::string &line);
+
+  NetworkClient client_;
+  std::string scheme_;
+  std::string host_;
+  uint16_t port_{0};
+  std::string path_;
+  bool http10_{false};
+  bool reuse_{true};
+  bool can_reuse_{false};
+  int32_t connect_timeout_{5000};
+  uint16_t timeout_{5000};
+  std::string request_headers_;
+  std::vector<std::pair<std::string, std::string>> collected_;
+  int size_{-1};
+  bool chunked_{false};
+};
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+Application App;
+
+void Application::setup() {
+  std::stable_sort(components_.begin(), components_.end(), [](Component *a, Component *b) {
+    return a->get_setup_priority() > b->get_setup_priority();
+  });
+  for (auto *component : components_) {
+    component->call_setup();
+  }
+}
+
+void Application::loop() {
+  uint32_t now = millis();
+  // Calls scheduled by the calls run here wait for the next loop
+  size_t count = items_.size();
+  for (size_t i = 0; i < count; i++) {
+    Item *item = items_[i].get();
+    if (item->removed || static_cast<int32_t>(now - item->next) < 0) {
+      continue;
+    }
+    if (item->interval == 0) {
+      item->removed = true;
+    } else {
+      item->next = now + item->interval;
+    }
+    // The call may replace or cancel its own item, so it runs from a copy
+    std::function<void()> f = item->f;
+    f();
+  }
+  items_.erase(std::remove_if(items_.begin(), items_.end(), [](const std::unique_ptr<Item> &item) {
+    return item->removed;
+  }), items_.end());
+
+  for (auto *component : components_) {
+    if (!component->is_failed()) {
+      component->loop();
+    }
+  }
+}
+
+bool Application::loop_until(const std::function<bool()> &condition, uint32_t timeout) {
+  uint32_t start = millis();
+  while (!condition()) {
+    if (millis() - start >= timeout) {
+      return false;
+    }
+    loop();
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  return true;
+}
+
+void Application::schedule(Component *component, const std::string &name, uint32_t delay, uint32_t interval,
+                           std::function<void()> &&f) {
+  if (!name.empty()) {
+    cancel(component, name, interval != 0);
+  }
+  if (delay == SCHEDULER_DONT_RUN) {
+    return;
+  }
+  items_.emplace_back(new Item{component, name, static_cast<uint32_t>(millis() + delay), interval, std::move(f)});
+}
+
+bool Application::cancel(Component *component, const std::string &name, bool interval) {
+  bool found = false;
+  for (auto &item : items_) {
+    if (!item->removed && item->component == component && item->name == name && (item->interval != 0) == interval) {
+      item->removed = true;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  App.schedule(this, name, timeout, 0, std::move(f));
+}
+
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) { App.schedule(this, "", timeout, 0, std::move(f)); }
+
+bool Component::cancel_timeout(const std::string &name) { return App.cancel(this, name, false); }
+
+void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f) {
+  // The first call comes on the next loop, then one every interval
+  App.schedule(this, name, interval == SCHEDULER_DONT_RUN ? SCHEDULER_DONT_RUN : 0, interval, std::move(f));
+}
+
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) { set_interval("", interval, std::move(f)); }
+
+bool Component::cancel_interval(const std::string &name) { return App.cancel(this, name, true); }
+
+void PollingComponent::call_setup() {
+  setup();
+  start_poller();
+}
+
+void PollingComponent::start_poller() { set_interval("update", update_interval_, [this]() { this->update(); }); }
+
+void PollingComponent::stop_poller() { cancel_interval("update"); }
+
+}  // namespace esphome
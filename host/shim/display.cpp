@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "esphome/components/display/display.h"
+#include "esphome/components/font/font.h"
+
+namespace esphome {
+
+namespace font {
+
+// Widths of the printable ASCII glyphs; narrow punctuation, wide capitals
+static int ascii_width(char c, int height) {
+  static const char *const NARROW = " !'(),.:;I[]`fijlrt|";
+  static const char *const WIDE = "@MWmw";
+  int unit = std::max(1, height / 4);
+  for (const char *p = NARROW; *p != '\0'; p++) {
+    if (*p == c) return unit + 1;
+  }
+  for (const char *p = WIDE; *p != '\0'; p++) {
+    if (*p == c) return unit * 2 + 1;
+  }
+  return c >= 'A' && c <= 'Z' ? unit * 2 - 1 : unit + unit / 2 + 1;
+}
+
+int Font::glyph_width(const char *str, int *length) const {
+  uint8_t lead = static_cast<uint8_t>(*str);
+  int bytes = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+  for (int i = 1; i < bytes; i++) {
+    if ((static_cast<uint8_t>(str[i]) & 0xC0) != 0x80) {
+      bytes = i;
+      break;
+    }
+  }
+  *length = bytes;
+  return lead < 0x80 ? ascii_width(static_cast<char>(lead), height_) : height_;
+}
+
+void Font::measure(const char *str, int *width, int *x_offset, int *baseline, int *height) {
+  measure_count_++;
+  int total = 0;
+  while (*str != '\0') {
+    int length;
+    total += glyph_width(str, &length);
+    str += length;
+  }
+  *width = total;
+  *x_offset = 0;
+  *baseline = get_baseline();
+  *height = height_;
+}
+
+}  // namespace font
+
+namespace display {
+
+void Display::fill(Color color) { std::fill(buffer_.begin(), buffer_.end(), color.is_on() ? 1 : 0); }
+
+void Display::draw_pixel_at(int x, int y, Color color) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return;
+  }
+  buffer_[y * width_ + x] = color.is_on() ? 1 : 0;
+}
+
+void Display::line(int x1, int y1, int x2, int y2, Color color) {
+  int dx = std::abs(x2 - x1);
+  int dy = -std::abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1;
+  int sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    draw_pixel_at(x1, y1, color);
+    if (x1 == x2 && y1 == y2) {
+      break;
+    }
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x1 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+void Display::filled_rectangle(int x1, int y1, int width, int height, Color color) {
+  for (int y = y1; y < y1 + height; y++) {
+    for (int x = x1; x < x1 + width; x++) {
+      draw_pixel_at(x, y, color);
+    }
+  }
+}
+
+// Glyphs are drawn as boxes with a one pixel margin, which is enough to make text cost what it would
+void Display::print(int x, int y, font::Font *font, Color color, TextAlign align, const char *text) {
+  int width, x_offset, baseline, height;
+  font->measure(text, &width, &x_offset, &baseline, &height);
+  int align_bits = static_cast<int>(align);
+  if (align_bits & static_cast<int>(TextAlign::CENTER_HORIZONTAL)) {
+    x -= width / 2;
+  } else if (align_bits & static_cast<int>(TextAlign::RIGHT)) {
+    x -= width;
+  }
+  if (align_bits & static_cast<int>(TextAlign::CENTER_VERTICAL)) {
+    y -= height / 2;
+  } else if (align_bits & static_cast<int>(TextAlign::BASELINE)) {
+    y -= baseline;
+  } else if (align_bits & static_cast<int>(TextAlign::BOTTOM)) {
+    y -= height;
+  }
+  while (*text != '\0') {
+    int length;
+    int advance = font->glyph_width(text, &length);
+    if (*text != ' ') {
+      filled_rectangle(x + 1, y + 1, advance - 2, height - 2, color);
+    }
+    x += advance;
+    text += length;
+  }
+}
+
+void Display::printf(int x, int y, font::Font *font, Color color, TextAlign align, const char *format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  std::vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  print(x, y, font, color, align, buffer);
+}
+
+size_t Display::count_on() const { return std::count(buffer_.begin(), buffer_.end(), 1); }
+
+}  // namespace display
+}  // namespace esphome
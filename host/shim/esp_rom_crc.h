@@ -0,0 +1,7 @@
+#pragma once
+// Host stand-in for the ROM CRC routines
+
+#include <cstdint>
+
+// CRC-32 as used by Ethernet and zlib, continuing from a previous result
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
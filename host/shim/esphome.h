@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in for the ESPHome umbrella header; ArduinoJson is included when the target has it
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "Arduino.h"
+#include "esp_heap_caps.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#endif
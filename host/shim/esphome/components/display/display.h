@@ -0,0 +1,75 @@
+#pragma once
+// Host stand-in for an ESPHome display: a monochrome frame buffer in memory that text, lines and
+// rectangles are drawn into pixel by pixel, so that the cost of a frame scales as on a device.
+
+#include <cstdarg>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/font/font.h"
+
+namespace esphome {
+
+struct Color {
+  Color() = default;
+  Color(uint8_t red, uint8_t green, uint8_t blue, uint8_t white = 0) : r(red), g(green), b(blue), w(white) {}
+
+  bool is_on() const { return r != 0 || g != 0 || b != 0 || w != 0; }
+  bool operator==(const Color &other) const { return r == other.r && g == other.g && b == other.b && w == other.w; }
+  bool operator!=(const Color &other) const { return !(*this == other); }
+
+  uint8_t r{0};
+  uint8_t g{0};
+  uint8_t b{0};
+  uint8_t w{0};
+};
+
+namespace display {
+
+enum class TextAlign {
+  TOP = 0x00,
+  CENTER_VERTICAL = 0x01,
+  BASELINE = 0x02,
+  BOTTOM = 0x04,
+  LEFT = 0x00,
+  CENTER_HORIZONTAL = 0x08,
+  RIGHT = 0x10,
+  TOP_LEFT = TOP | LEFT,
+  CENTER_LEFT = CENTER_VERTICAL | LEFT,
+  CENTER = CENTER_VERTICAL | CENTER_HORIZONTAL,
+};
+
+struct Rect {
+  Rect() = default;
+  Rect(int16_t x, int16_t y, int16_t w, int16_t h) : x(x), y(y), w(w), h(h) {}
+
+  int16_t x{0};
+  int16_t y{0};
+  int16_t w{0};
+  int16_t h{0};
+};
+
+class Display {
+ public:
+  Display(int width, int height) : width_(width), height_(height), buffer_(width * height, 0) {}
+
+  int get_width() const { return width_; }
+  int get_height() const { return height_; }
+  void fill(Color color);
+  void draw_pixel_at(int x, int y, Color color);
+  void line(int x1, int y1, int x2, int y2, Color color);
+  void filled_rectangle(int x1, int y1, int width, int height, Color color);
+  void print(int x, int y, font::Font *font, Color color, TextAlign align, const char *text);
+  void printf(int x, int y, font::Font *font, Color color, TextAlign align, const char *format, ...)
+      __attribute__((format(printf, 7, 8)));
+  // Returns how many pixels are on
+  size_t count_on() const;
+
+ protected:
+  int width_;
+  int height_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace display
+}  // namespace esphome
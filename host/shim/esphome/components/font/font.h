@@ -0,0 +1,30 @@
+#pragma once
+// Host stand-in for an ESPHome font: a proportional bitmap font whose glyphs are solid boxes.
+// ASCII glyphs are 3 to 9 pixels wide by character, and the rest are as wide as the font is high,
+// like the CJK glyphs of a typical font.
+
+#include <cstdint>
+
+namespace esphome {
+namespace font {
+
+class Font {
+ public:
+  explicit Font(int height = 16) : height_(height) {}
+
+  // Measures UTF-8 text like the ESPHome font: the sum of the glyph advances
+  void measure(const char *str, int *width, int *x_offset, int *baseline, int *height);
+  // Returns the advance of the glyph that starts at str, and how many bytes it takes
+  int glyph_width(const char *str, int *length) const;
+  int get_height() const { return height_; }
+  int get_baseline() const { return height_ * 3 / 4; }
+  // Returns how many times measure() was called
+  uint32_t get_measure_count() const { return measure_count_; }
+
+ protected:
+  int height_;
+  uint32_t measure_count_{0};
+};
+
+}  // namespace font
+}  // namespace esphome
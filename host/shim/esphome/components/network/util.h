@@ -0,0 +1,10 @@
+#pragma once
+// Host stand-in; the host is always on the network
+
+namespace esphome {
+namespace network {
+
+inline bool is_connected() { return true; }
+
+}  // namespace network
+}  // namespace esphome
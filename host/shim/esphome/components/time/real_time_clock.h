@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in for the ESPHome time component; USE_TIME is not defined, so it is never read
+
+#include "esphome/core/time.h"
+
+namespace esphome {
+namespace time {
+
+class RealTimeClock {
+ public:
+  ESPTime now() const { return ESPTime{}; }
+};
+
+}  // namespace time
+}  // namespace esphome
@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in; there is no task watchdog to lengthen
+
+#include <cstdint>
+
+namespace esphome {
+namespace watchdog {
+
+class WatchdogManager {
+ public:
+  explicit WatchdogManager(uint32_t timeout_ms) {}
+};
+
+}  // namespace watchdog
+}  // namespace esphome
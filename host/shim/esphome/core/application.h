@@ -0,0 +1,47 @@
+#pragma once
+// Host stand-in for the ESPHome application: it sets up the registered components and runs their
+// loops and scheduled calls. There is no task watchdog to feed.
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome {
+
+class Component;
+
+class Application {
+ public:
+  void register_component(Component *component) { components_.push_back(component); }
+  // Sets up the registered components in the order of their setup priority
+  void setup();
+  // Runs the scheduled calls that are due, then the loop() of every component
+  void loop();
+  // Runs loop() until the condition holds or timeout milliseconds have passed; false on timeout
+  bool loop_until(const std::function<bool()> &condition, uint32_t timeout);
+  void feed_wdt() {}
+
+  // Used by Component; interval is 0 for a timeout
+  void schedule(Component *component, const std::string &name, uint32_t delay, uint32_t interval,
+                std::function<void()> &&f);
+  bool cancel(Component *component, const std::string &name, bool interval);
+
+ protected:
+  struct Item {
+    Component *component;
+    std::string name;
+    uint32_t next;
+    uint32_t interval;
+    std::function<void()> f;
+    bool removed{false};
+  };
+
+  std::vector<Component *> components_;
+  std::vector<std::unique_ptr<Item>> items_;
+};
+
+extern Application App;
+
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#pragma once
+// Host stand-in for ESPHome automations: triggers have no automations attached, and templatable
+// values hold either a constant or a lambda
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) {}
+};
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(const Ts &...x) = 0;
+};
+
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() = default;
+
+  template<typename V, typename std::enable_if<!std::is_invocable<V, X...>::value, int>::type = 0>
+  TemplatableValue(V value) : has_value_(true), value_(value) {}
+
+  template<typename F, typename std::enable_if<std::is_invocable<F, X...>::value, int>::type = 0>
+  TemplatableValue(F function) : has_value_(true), function_(function) {}
+
+  bool has_value() const { return has_value_; }
+  T value(X... x) const { return function_ ? function_(x...) : value_; }
+
+ protected:
+  bool has_value_{false};
+  T value_{};
+  std::function<T(X...)> function_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,69 @@
+#pragma once
+// Host stand-in for ESPHome components. Timeouts, intervals and deferred calls are kept by the
+// application and run from App.loop(), on the thread that calls it, as on the device.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+const float DATA = 600.0f;
+const float AFTER_WIFI = 200.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+const uint32_t SCHEDULER_DONT_RUN = 4294967295UL;
+
+class Component {
+ public:
+  virtual ~Component() = default;
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual void on_shutdown() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+  // Called once by App.setup()
+  virtual void call_setup() { setup(); }
+
+  void mark_failed() { failed_ = true; }
+  bool is_failed() const { return failed_; }
+  void status_set_warning() { warning_ = true; }
+  void status_clear_warning() { warning_ = false; }
+  bool status_has_warning() const { return warning_; }
+
+ protected:
+  // A named timeout or interval replaces the one of the same name, of this component
+  void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+  void set_timeout(uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const std::string &name);
+  void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+  void set_interval(uint32_t interval, std::function<void()> &&f);
+  bool cancel_interval(const std::string &name);
+  void defer(const std::string &name, std::function<void()> &&f) { set_timeout(name, 0, std::move(f)); }
+  void defer(std::function<void()> &&f) { set_timeout(0, std::move(f)); }
+
+  bool failed_{false};
+  bool warning_{false};
+};
+
+// Calls update() every update interval, starting with the first App.loop() after setup
+class PollingComponent : public Component {
+ public:
+  PollingComponent() = default;
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+  virtual void update() = 0;
+  void call_setup() override;
+  virtual void set_update_interval(uint32_t update_interval) { update_interval_ = update_interval; }
+  uint32_t get_update_interval() const { return update_interval_; }
+  void start_poller();
+  void stop_poller();
+
+ protected:
+  uint32_t update_interval_{60000};
+};
+
+}  // namespace esphome
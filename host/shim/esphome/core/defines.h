@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in for the defines ESPHome generates; no optional component is enabled
+
+#define VERSION_CODE(major, minor, patch) ((major) << 16 | (minor) << 8 | (patch))
+#define ESPHOME_VERSION_CODE VERSION_CODE(2025, 11, 0)
@@ -0,0 +1,12 @@
+#pragma once
+// Host stand-in for the ESPHome HAL; the time functions are those of the Arduino shim
+
+#include "Arduino.h"
+
+namespace esphome {
+
+inline uint32_t millis() { return static_cast<uint32_t>(::millis()); }
+inline uint32_t micros() { return static_cast<uint32_t>(::micros()); }
+inline void delay(uint32_t ms) { ::delay(ms); }
+
+}  // namespace esphome
@@ -0,0 +1,28 @@
+#pragma once
+// Host stand-in for the ESPHome helpers the component uses
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+template<typename... X> class CallbackManager;
+
+// Calls every registered callback in the order they were added
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &callback : callbacks_) {
+      callback(args...);
+    }
+  }
+  size_t size() const { return callbacks_.size(); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
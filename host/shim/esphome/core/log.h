@@ -0,0 +1,26 @@
+#pragma once
+// Host stand-in; logging is compiled out so that it does not skew the benchmarks
+
+#define ESP_LOG_NONE 0
+#define ESP_LOG_VERBOSE 5
+#define ESP_LOG_LEVEL ESP_LOG_NONE
+
+namespace esphome {
+// Never called; keeps the arguments of a compiled out message used
+template<typename... Ts> inline void log_discard(const char *tag, Ts &&...args) {}
+}  // namespace esphome
+
+#define ESP_LOG_DISCARD(tag, ...) \
+  do { \
+    if (false) \
+      esphome::log_discard(tag, __VA_ARGS__); \
+  } while (0)
+#define ESP_LOGE(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESP_LOG_DISCARD(tag, __VA_ARGS__)
+#define LOG_UPDATE_INTERVAL(component) ((void) 0)
+
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,27 @@
+#pragma once
+// Host stand-in for ESPHome's ESPTime, with the members the component reads
+
+#include <cstdint>
+#include <ctime>
+
+namespace esphome {
+
+struct ESPTime {
+  uint8_t second{0};
+  uint8_t minute{0};
+  uint8_t hour{0};
+  time_t timestamp{0};
+
+  bool is_valid() const { return timestamp >= 1546300800; }
+
+  // Returns the seconds the local time zone is ahead of UTC
+  static int32_t timezone_offset() {
+    time_t now = ::time(nullptr);
+    std::tm local = *std::localtime(&now);
+    std::tm utc = *std::gmtime(&now);
+    utc.tm_isdst = local.tm_isdst;
+    return static_cast<int32_t>(std::mktime(&local) - std::mktime(&utc));
+  }
+};
+
+}  // namespace esphome
@@ -0,0 +1,43 @@
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "freertos/task.h"
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t value{0};
+};
+
+static thread_local HostTask *current_task = nullptr;
+
+// Tasks run until the process exits, like the fetch task, so they are never joined or freed
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  HostTask *task = new HostTask();
+  *handle = task;
+  std::thread([task, function, arg]() {
+    current_task = task;
+    function(arg);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->value++;
+  }
+  task->notified.notify_one();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+  HostTask *task = current_task;
+  std::unique_lock<std::mutex> lock(task->mutex);
+  task->notified.wait(lock, [task]() { return task->value > 0; });
+  uint32_t value = task->value;
+  task->value = clear_on_exit ? 0 : value - 1;
+  return value;
+}
@@ -0,0 +1,17 @@
+#pragma once
+// Host stand-in for FreeRTOS tasks: each task is a thread, and its notification value a counter
+// guarded by a mutex
+
+#include <cstdint>
+
+#include "FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+// Only waiting forever is supported
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
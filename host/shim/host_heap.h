@@ -0,0 +1,17 @@
+#pragma once
+// Counters kept by the host shim for every heap allocation, including operator new
+
+#include <cstddef>
+
+struct HostHeapStats {
+  // Allocations made so far
+  size_t allocations;
+  // Bytes currently allocated
+  size_t bytes;
+  // Most bytes allocated at once since the last reset_host_heap_peak()
+  size_t peak;
+};
+
+HostHeapStats get_host_heap_stats();
+// Restarts the peak from the bytes currently allocated
+void reset_host_heap_peak();
@@ -0,0 +1,497 @@
+#include "HTTPClient.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef HOST_HAVE_OPENSSL
+#include <openssl/ssl.h>
+#endif
+
+// One TCP segment, as lwIP hands them over
+static const size_t RECEIVE_SIZE = 1460;
+
+// Returns the milliseconds left until deadline, or 0 once it has passed
+static int remaining_ms(unsigned long deadline) {
+  long left = static_cast<long>(deadline - millis());
+  return left > 0 ? static_cast<int>(left) : 0;
+}
+
+// Waits up to timeout_ms for the socket to become readable or writable
+static bool wait_socket(int fd, short events, int timeout_ms) {
+  pollfd request{fd, events, 0};
+  int ready;
+  do {
+    ready = ::poll(&request, 1, timeout_ms);
+  } while (ready < 0 && errno == EINTR);
+  return ready > 0;
+}
+
+static bool would_block() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+
+#ifdef HOST_HAVE_OPENSSL
+// Like a client without a CA certificate, the server's certificate is not verified
+static SSL_CTX *client_context() {
+  static SSL_CTX *context = [] {
+    SSL_CTX *created = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(created, SSL_VERIFY_NONE, nullptr);
+    return created;
+  }();
+  return context;
+}
+
+// Returns the socket event an SSL call that did not complete waits for, or 0 if it failed
+static short ssl_wait_events(SSL *ssl, int result) {
+  switch (SSL_get_error(ssl, result)) {
+    case SSL_ERROR_WANT_READ:
+      return POLLIN;
+    case SSL_ERROR_WANT_WRITE:
+      return POLLOUT;
+    default:
+      return 0;
+  }
+}
+#endif
+
+bool NetworkClient::connect(const std::string &host, uint16_t port, bool secure, uint32_t timeout) {
+  stop();
+  unsigned long deadline = millis() + timeout;
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = nullptr;
+  if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+    return false;
+  }
+  for (addrinfo *address = addresses; address != nullptr && fd_ < 0; address = address->ai_next) {
+    int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    int result = ::connect(fd, address->ai_addr, address->ai_addrlen);
+    if (result < 0 && errno == EINPROGRESS && wait_socket(fd, POLLOUT, remaining_ms(deadline))) {
+      int error = 0;
+      socklen_t length = sizeof(error);
+      ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+      result = error == 0 ? 0 : -1;
+    }
+    if (result == 0) {
+      fd_ = fd;
+    } else {
+      ::close(fd);
+    }
+  }
+  ::freeaddrinfo(addresses);
+  if (fd_ < 0) {
+    return false;
+  }
+  int one = 1;
+  ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (!secure) {
+    return true;
+  }
+
+#ifdef HOST_HAVE_OPENSSL
+  SSL *ssl = SSL_new(client_context());
+  ssl_ = ssl;
+  SSL_set_fd(ssl, fd_);
+  SSL_set_tlsext_host_name(ssl, host.c_str());
+  while (true) {
+    int result = SSL_connect(ssl);
+    if (result == 1) {
+      return true;
+    }
+    short events = ssl_wait_events(ssl, result);
+    if (events == 0 || !wait_socket(fd_, events, remaining_ms(deadline))) {
+      break;
+    }
+  }
+#endif
+  stop();
+  return false;
+}
+
+// Like the ESP32 client, a connection counts as closed once the server's FIN has arrived and every
+// byte before it has been read
+bool NetworkClient::connected() {
+  if (fd_ < 0) {
+    return false;
+  }
+  if (pos_ < buffer_.size()) {
+    return true;
+  }
+  if (closed_) {
+    return false;
+  }
+  char byte;
+  ssize_t result = ::recv(fd_, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (result == 0 || (result < 0 && !would_block())) {
+    closed_ = true;
+    return false;
+  }
+  return true;
+}
+
+void NetworkClient::stop() {
+#ifdef HOST_HAVE_OPENSSL
+  if (ssl_ != nullptr) {
+    SSL_free(static_cast<SSL *>(ssl_));
+    ssl_ = nullptr;
+  }
+#endif
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  buffer_.clear();
+  pos_ = 0;
+  closed_ = false;
+}
+
+void NetworkClient::flush() {
+  do {
+    buffer_.clear();
+    pos_ = 0;
+  } while (fill_(0) && !buffer_.empty());
+}
+
+bool NetworkClient::fill_(int wait_ms) {
+  if (fd_ < 0 || closed_) {
+    return false;
+  }
+  if (pos_ >= buffer_.size()) {
+    buffer_.clear();
+    pos_ = 0;
+  }
+  char data[RECEIVE_SIZE];
+  ssize_t received;
+#ifdef HOST_HAVE_OPENSSL
+  if (ssl_ != nullptr) {
+    SSL *ssl = static_cast<SSL *>(ssl_);
+    if (SSL_pending(ssl) == 0 && !wait_socket(fd_, POLLIN, wait_ms)) {
+      return true;
+    }
+    int result = SSL_read(ssl, data, sizeof(data));
+    if (result <= 0) {
+      if (ssl_wait_events(ssl, result) != 0) {
+        return true;
+      }
+      closed_ = true;
+      return false;
+    }
+    buffer_.insert(buffer_.end(), data, data + result);
+    return true;
+  }
+#endif
+  if (!wait_socket(fd_, POLLIN, wait_ms)) {
+    return true;
+  }
+  received = ::recv(fd_, data, sizeof(data), 0);
+  if (received < 0 && would_block()) {
+    return true;
+  }
+  if (received <= 0) {
+    closed_ = true;
+    return false;
+  }
+  buffer_.insert(buffer_.end(), data, data + received);
+  return true;
+}
+
+bool NetworkClient::write_all(const char *data, size_t length) {
+  unsigned long deadline = millis() + getTimeout();
+  while (length > 0) {
+    if (fd_ < 0) {
+      return false;
+    }
+    ssize_t written;
+    short events = POLLOUT;
+#ifdef HOST_HAVE_OPENSSL
+    if (ssl_ != nullptr) {
+      SSL *ssl = static_cast<SSL *>(ssl_);
+      int result = SSL_write(ssl, data, length);
+      written = result;
+      events = result > 0 ? 0 : ssl_wait_events(ssl, result);
+      if (result <= 0 && events == 0) {
+        return false;
+      }
+    } else
+#endif
+    {
+      written = ::send(fd_, data, length, MSG_NOSIGNAL);
+      if (written < 0 && !would_block()) {
+        return false;
+      }
+    }
+    if (written > 0) {
+      data += written;
+      length -= written;
+    } else if (!wait_socket(fd_, events, remaining_ms(deadline))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int NetworkClient::available() {
+  fill_(0);
+  return buffer_.size() - pos_;
+}
+
+int NetworkClient::read() {
+  if (pos_ >= buffer_.size()) {
+    fill_(1);
+  }
+  return pos_ < buffer_.size() ? static_cast<uint8_t>(buffer_[pos_++]) : -1;
+}
+
+int NetworkClient::peek() {
+  if (pos_ >= buffer_.size()) {
+    fill_(1);
+  }
+  return pos_ < buffer_.size() ? static_cast<uint8_t>(buffer_[pos_]) : -1;
+}
+
+HTTPClient::HTTPClient() {
+  // A write to a connection the server has closed fails instead of ending the process
+  std::signal(SIGPIPE, SIG_IGN);
+}
+
+bool HTTPClient::begin(String url) {
+  std::string text = url.c_str();
+  size_t scheme_end = text.find("://");
+  if (scheme_end == std::string::npos) {
+    return false;
+  }
+  std::string scheme = text.substr(0, scheme_end);
+  if (scheme != "http" && scheme != "https") {
+    return false;
+  }
+  size_t host_start = scheme_end + 3;
+  size_t path_start = text.find('/', host_start);
+  std::string host = text.substr(host_start, path_start - host_start);
+  uint16_t port = scheme == "https" ? 443 : 80;
+  size_t colon = host.rfind(':');
+  if (colon != std::string::npos) {
+    port = std::atoi(host.c_str() + colon + 1);
+    host.resize(colon);
+  }
+  // Another server needs another connection
+  if (scheme != scheme_ || host != host_ || port != port_) {
+    client_.stop();
+  }
+  scheme_ = scheme;
+  host_ = host;
+  port_ = port;
+  path_ = path_start == std::string::npos ? "/" : text.substr(path_start);
+  request_headers_.clear();
+  size_ = -1;
+  chunked_ = false;
+  return true;
+}
+
+void HTTPClient::end() {
+  if (client_.connected()) {
+    // Whatever is left of the response is discarded
+    client_.flush();
+    if (reuse_ && can_reuse_) {
+      return;
+    }
+  }
+  client_.stop();
+}
+
+void HTTPClient::addHeader(const String &name, const String &value) {
+  // Set by the client itself
+  if (name.equalsIgnoreCase("Connection") || name.equalsIgnoreCase("User-Agent") || name.equalsIgnoreCase("Host")) {
+    return;
+  }
+  request_headers_ += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+}
+
+void HTTPClient::collectHeaders(const char *keys[], size_t count) {
+  collected_.clear();
+  for (size_t i = 0; i < count; i++) {
+    collected_.emplace_back(keys[i], "");
+  }
+}
+
+String HTTPClient::header(const char *name) {
+  for (const auto &collected : collected_) {
+    if (strcasecmp(collected.first.c_str(), name) == 0) {
+      return String(collected.second);
+    }
+  }
+  return String();
+}
+
+bool HTTPClient::hasHeader(const char *name) { return header(name).length() > 0; }
+
+// Reuses the open connection, discarding anything left of the previous response
+bool HTTPClient::connect() {
+  client_.setTimeout(timeout_);
+  if (client_.connected()) {
+    client_.flush();
+    return true;
+  }
+  return client_.connect(host_, port_, scheme_ == "https", connect_timeout_);
+}
+
+int HTTPClient::send_request_(const char *method, const char *payload) {
+  size_ = -1;
+  chunked_ = false;
+  for (auto &collected : collected_) {
+    collected.second.clear();
+  }
+  if (!connect()) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  bool default_port = port_ == (scheme_ == "https" ? 443 : 80);
+  std::string header = std::string(method) + " " + path_ + (http10_ ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+  header += "Host: " + host_ + (default_port ? "" : ":" + std::to_string(port_)) + "\r\n";
+  header += "User-Agent: ESP32HTTPClient\r\n";
+  header += std::string("Connection: ") + (reuse_ ? "keep-alive" : "close") + "\r\n";
+  header += request_headers_;
+  size_t length = std::strlen(payload);
+  if (length > 0 || std::strcmp(method, "POST") == 0) {
+    header += "Content-Length: " + std::to_string(length) + "\r\n";
+  }
+  header += "\r\n";
+  if (!client_.write_all(header.data(), header.size())) {
+    client_.stop();
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (length > 0 && !client_.write_all(payload, length)) {
+    client_.stop();
+    return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+  }
+  int code = read_response_header_();
+  if (code < 0) {
+    client_.stop();
+  }
+  return code;
+}
+
+// Reads a header line without its line break; false if the connection closed or timed out first
+bool HTTPClient::read_line_(std::string &line) {
+  line.clear();
+  unsigned long start = millis();
+  while (true) {
+    int c = client_.read();
+    if (c == '\n') {
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      return true;
+    }
+    if (c >= 0) {
+      line += static_cast<char>(c);
+      continue;
+    }
+    if (!client_.connected() || millis() - start > timeout_) {
+      return false;
+    }
+  }
+}
+
+int HTTPClient::read_response_header_() {
+  can_reuse_ = reuse_ && !http10_;
+  std::string line;
+  int code = 0;
+  while (true) {
+    if (!read_line_(line)) {
+      return client_.connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+    }
+    if (code == 0) {
+      size_t space = line.find(' ');
+      if (line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+        return HTTPC_ERROR_CONNECTION_LOST;
+      }
+      code = std::atoi(line.c_str() + space + 1);
+      // An HTTP/1.0 server closes the connection after the response
+      if (line.compare(0, 8, "HTTP/1.0") == 0) {
+        can_reuse_ = false;
+      }
+      continue;
+    }
+    if (line.empty()) {
+      return code;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+    std::string name = line.substr(0, colon);
+    size_t value_start = line.find_first_not_of(' ', colon + 1);
+    std::string value = value_start == std::string::npos ? "" : line.substr(value_start);
+    if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+      size_ = std::atoi(value.c_str());
+    } else if (strcasecmp(name.c_str(), "Connection") == 0) {
+      if (value.find("close") != std::string::npos) {
+        can_reuse_ = false;
+      }
+    } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+      chunked_ = strcasecmp(value.c_str(), "chunked") == 0;
+    }
+    for (auto &collected : collected_) {
+      if (strcasecmp(collected.first.c_str(), name.c_str()) == 0) {
+        collected.second = value;
+      }
+    }
+  }
+}
+
+String HTTPClient::getString() {
+  std::string body;
+  char buffer[RECEIVE_SIZE];
+  auto read_exactly = [&](size_t length) {
+    while (length > 0) {
+      size_t count = client_.readBytes(buffer, std::min(length, sizeof(buffer)));
+      if (count == 0) {
+        return false;
+      }
+      body.append(buffer, count);
+      length -= count;
+    }
+    return true;
+  };
+
+  if (chunked_) {
+    std::string line;
+    while (read_line_(line)) {
+      size_t length = std::strtoul(line.c_str(), nullptr, 16);
+      if (length == 0) {
+        // Trailers up to the empty line
+        while (read_line_(line) && !line.empty()) {
+        }
+        break;
+      }
+      if (!read_exactly(length) || !read_line_(line)) {
+        break;
+      }
+    }
+  } else if (size_ >= 0) {
+    read_exactly(size_);
+  } else {
+    while (client_.connected()) {
+      int c = client_.read();
+      if (c >= 0) {
+        body += static_cast<char>(c);
+      }
+    }
+  }
+  return String(body);
+}
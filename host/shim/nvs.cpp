@@ -0,0 +1,112 @@
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nvs.h"
+
+// Entries by namespace and key; u32 values are stored as 4-byte blobs of their own type
+struct NvsEntry {
+  bool is_u32;
+  std::vector<uint8_t> value;
+};
+struct NvsHandle {
+  std::string name;
+  bool writable;
+};
+
+static std::mutex nvs_mutex;
+static std::map<std::string, NvsEntry> nvs_entries;
+static std::map<nvs_handle_t, NvsHandle> nvs_handles;
+static nvs_handle_t nvs_next_handle = 1;
+static size_t nvs_writes = 0;
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_ERR_NVS_NOT_FOUND:
+      return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_READ_ONLY:
+      return "ESP_ERR_NVS_READ_ONLY";
+    default:
+      return "ESP_FAIL";
+  }
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  *handle = nvs_next_handle++;
+  nvs_handles[*handle] = NvsHandle{name, mode == NVS_READWRITE};
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  nvs_handles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+static std::string nvs_key(nvs_handle_t handle, const char *key) { return nvs_handles[handle].name + "/" + key; }
+
+static esp_err_t nvs_set(nvs_handle_t handle, const char *key, bool is_u32, const void *value, size_t length) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  if (!nvs_handles[handle].writable) {
+    return ESP_ERR_NVS_READ_ONLY;
+  }
+  const auto *bytes = static_cast<const uint8_t *>(value);
+  nvs_entries[nvs_key(handle, key)] = NvsEntry{is_u32, std::vector<uint8_t>(bytes, bytes + length)};
+  nvs_writes++;
+  return ESP_OK;
+}
+
+static const NvsEntry *nvs_find(nvs_handle_t handle, const char *key, bool is_u32) {
+  auto it = nvs_entries.find(nvs_key(handle, key));
+  return it != nvs_entries.end() && it->second.is_u32 == is_u32 ? &it->second : nullptr;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  const NvsEntry *entry = nvs_find(handle, key, false);
+  if (entry == nullptr) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  if (out != nullptr) {
+    std::memcpy(out, entry->value.data(), entry->value.size() < *length ? entry->value.size() : *length);
+  }
+  *length = entry->value.size();
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+  return nvs_set(handle, key, false, value, length);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  const NvsEntry *entry = nvs_find(handle, key, true);
+  if (entry == nullptr) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+  std::memcpy(out, entry->value.data(), sizeof(*out));
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+  return nvs_set(handle, key, true, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  if (!nvs_handles[handle].writable) {
+    return ESP_ERR_NVS_READ_ONLY;
+  }
+  return nvs_entries.erase(nvs_key(handle, key)) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+size_t get_host_nvs_writes() {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  return nvs_writes;
+}
@@ -0,0 +1,27 @@
+#pragma once
+// Host stand-in for the ESP-IDF NVS API, keeping entries in memory for the life of the process
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int esp_err_t;
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+#define ESP_OK 0
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+#define ESP_ERR_NVS_READ_ONLY 0x1107
+
+const char *esp_err_to_name(esp_err_t code);
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_commit(nvs_handle_t handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+
+// Returns the number of entries written since the process started, to count flash writes
+size_t get_host_nvs_writes();
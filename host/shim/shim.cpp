@@ -0,0 +1,144 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <strings.h>
+#include <thread>
+
+#include "Arduino.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "host_heap.h"
+
+unsigned long millis() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+unsigned long micros() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+bool String::equalsIgnoreCase(const String &other) const {
+  return text_.size() == other.text_.size() && strncasecmp(text_.c_str(), other.text_.c_str(), text_.size()) == 0;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t count = 0;
+  while (count < size && write(buffer[count]) == 1) {
+    count++;
+  }
+  return count;
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) {
+      return c;
+    }
+  } while (millis() - start < timeout_);
+  return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = static_cast<char>(c);
+  }
+  return count;
+}
+
+// Every block carries its size in front, so that frees can be counted
+static const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+static std::atomic<size_t> allocations{0};
+static std::atomic<size_t> bytes{0};
+static std::atomic<size_t> peak{0};
+
+static void *counted_malloc(size_t size) {
+  auto *block = static_cast<unsigned char *>(std::malloc(size + HEADER_SIZE));
+  if (block == nullptr) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t *>(block) = size;
+  allocations++;
+  size_t now = bytes += size;
+  size_t high = peak.load();
+  while (now > high && !peak.compare_exchange_weak(high, now)) {
+  }
+  return block + HEADER_SIZE;
+}
+
+static void counted_free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto *block = static_cast<unsigned char *>(ptr) - HEADER_SIZE;
+  bytes -= *reinterpret_cast<size_t *>(block);
+  std::free(block);
+}
+
+static void *counted_realloc(void *ptr, size_t size) {
+  if (ptr == nullptr) {
+    return counted_malloc(size);
+  }
+  size_t old_size = *reinterpret_cast<size_t *>(static_cast<unsigned char *>(ptr) - HEADER_SIZE);
+  void *moved = counted_malloc(size);
+  if (moved != nullptr) {
+    std::memcpy(moved, ptr, old_size < size ? old_size : size);
+    counted_free(ptr);
+  }
+  return moved;
+}
+
+HostHeapStats get_host_heap_stats() { return {allocations.load(), bytes.load(), peak.load()}; }
+
+void reset_host_heap_peak() { peak = bytes.load(); }
+
+void *operator new(size_t size) {
+  void *ptr = counted_malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { counted_free(ptr); }
+
+// The host has no PSRAM, like most boards; allocations preferring it fall back to internal RAM
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? nullptr : counted_malloc(size);
+}
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps) {
+  return (caps & MALLOC_CAP_SPIRAM) ? nullptr : counted_realloc(ptr, size);
+}
+void heap_caps_free(void *ptr) { counted_free(ptr); }
+size_t heap_caps_get_free_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_total_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return 0; }
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
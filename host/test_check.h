@@ -0,0 +1,21 @@
+#pragma once
+// Minimal checks shared by the host tests: a failed check is printed and counted, and the test
+// keeps going so that one run reports every failure.
+
+#include <cstdio>
+
+inline int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+// Prints the outcome and returns the exit code of the test
+inline int check_result() {
+  std::printf("%s\n", failures == 0 ? "All checks passed" : "Some checks failed");
+  return failures == 0 ? 0 : 1;
+}
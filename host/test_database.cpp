@@ -0,0 +1,277 @@
+// Drives NotionDatabase against mock_notion_server.py as a device would: thousands of polls on the
+// main loop and on the fetch task, page flips, and responses that are cut short, rate limited or
+// slow to arrive. Checks what the database shows after each, and prints the latency and heap of
+// every run as one JSON object, so that runs can be compared by a script:
+//   {"run":"poll_async","operations":1000,"failures":0,"p50_us":...,"p95_us":...,"max_us":...,
+//    "parse_p50_us":...,"allocs_per_op":...,"heap_growth":...,"peak_bytes":...,"connections":...}
+// Latency runs from the call until the fetch was applied; heap_growth is what the run left
+// allocated, and peak_bytes the most it held above that at once.
+//
+//   test_database <python> <mock_notion_server.py> <data.json> [--polls <count>]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/application.h"
+#include "host_heap.h"
+#include "mock_server.h"
+#include "notion_database.h"
+#include "test_check.h"
+
+using esphome::App;
+using esphome::notion_database::FetchStats;
+using esphome::notion_database::NotionDatabase;
+
+namespace {
+
+// Pages in data/tasks.json
+const int RECORDED_PAGES = 25;
+const uint32_t FETCH_TIMEOUT = 10000;
+
+// A database polling the mock server, and what its fetches reported. Like every ESPHome component
+// it lives until the program exits, as its fetch task does.
+struct Device {
+  NotionDatabase database;
+  int fetches{0};
+  int failures{0};
+  std::vector<uint32_t> latencies;
+  std::vector<uint32_t> parse_us;
+};
+
+Device *new_device(const MockServer &server, bool async_fetch, const std::string &query = "",
+                   uint32_t http_timeout = 10000) {
+  Device *device = new Device();
+  NotionDatabase &database = device->database;
+  database.set_base_url(server.base_url());
+  database.set_api_token(std::string("secret_test"));
+  database.set_database_id(std::string("d3adbeef000040008000000000000001"));
+  database.set_query(query);
+  database.set_watchdog_timeout(30000u);
+  database.set_http_connect_timeout(5000u);
+  database.set_http_timeout(http_timeout);
+  database.set_json_parse_buffer_size(20480u);
+  database.set_keep_alive(true);
+  database.set_async_fetch(async_fetch);
+  // Polls are sent by the runs, not by the update interval
+  database.set_update_interval(esphome::SCHEDULER_DONT_RUN);
+  database.add_on_fetch_callback([device](const FetchStats &stats, bool success) {
+    device->fetches++;
+    if (success) {
+      device->parse_us.push_back(stats.parse_us);
+    } else {
+      device->failures++;
+    }
+  });
+  App.register_component(&database);
+  database.call_setup();
+  return device;
+}
+
+// Calls operation and runs the main loop until a fetch has been applied; false on timeout
+bool fetch(Device &device, const std::function<void()> &operation) {
+  int fetches = device.fetches;
+  uint32_t start = micros();
+  operation();
+  bool fetched = App.loop_until([&]() { return device.fetches > fetches; }, FETCH_TIMEOUT);
+  device.latencies.push_back(micros() - start);
+  return fetched;
+}
+
+bool poll(Device &device) {
+  return fetch(device, [&]() { device.database.update(); });
+}
+
+uint32_t percentile(std::vector<uint32_t> values, int percent) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[(values.size() - 1) * percent / 100];
+}
+
+// Measures the operations of a run; what the first fetch allocates for good is left out
+class Measurement {
+ public:
+  explicit Measurement(Device &device, size_t operations) : device_(device) {
+    device.latencies.clear();
+    device.latencies.reserve(operations);
+    device.parse_us.clear();
+    device.parse_us.reserve(operations);
+    failures_ = device.failures;
+    reset_host_heap_peak();
+    before_ = get_host_heap_stats();
+  }
+
+  // Prints the JSON object of the run; returns how many bytes it left allocated
+  long report(const char *run, const MockServer &server) {
+    HostHeapStats after = get_host_heap_stats();
+    size_t operations = device_.latencies.size();
+    long growth = static_cast<long>(after.bytes) - static_cast<long>(before_.bytes);
+    std::printf("{\"run\":\"%s\",\"operations\":%zu,\"failures\":%d,\"p50_us\":%u,\"p95_us\":%u,\"max_us\":%u,"
+                "\"parse_p50_us\":%u,\"allocs_per_op\":%.1f,\"heap_growth\":%ld,\"peak_bytes\":%zu,"
+                "\"connections\":%d}\n",
+                run, operations, device_.failures - failures_, percentile(device_.latencies, 50),
+                percentile(device_.latencies, 95), percentile(device_.latencies, 100),
+                percentile(device_.parse_us, 50),
+                operations > 0 ? static_cast<double>(after.allocations - before_.allocations) / operations : 0.0,
+                growth, after.peak - before_.bytes, server.stats().connections);
+    return growth;
+  }
+
+ protected:
+  Device &device_;
+  int failures_;
+  HostHeapStats before_;
+};
+
+// Polls an unchanged database; the pages parsed by each poll are dropped, so the heap stays flat
+void test_polls(MockServer &server, bool async_fetch, int polls) {
+  CHECK(server.start());
+  Device &device = *new_device(server, async_fetch);
+  NotionDatabase &database = device.database;
+  // The first polls grow the parse buffer, the page store and the symbols to what the pages need
+  for (int i = 0; i < 3; i++) {
+    CHECK(poll(device));
+  }
+  CHECK(database.get_page_count() == RECORDED_PAGES);
+  CHECK(database.is_fetching() == false);
+  uint32_t pages_hash = database.get_pages_hash();
+
+  Measurement measurement(device, polls);
+  for (int i = 0; i < polls; i++) {
+    if (!poll(device)) {
+      CHECK(!"poll timed out");
+      break;
+    }
+  }
+  CHECK(measurement.report(async_fetch ? "poll_async" : "poll", server) <= 0);
+  CHECK(device.failures == 0);
+  CHECK(database.get_pages_hash() == pages_hash);
+  CHECK(!database.has_page_change());
+  CHECK(server.stats().connections == 1);
+}
+
+// Flips through the three pages of ten results the recorded response makes, and back
+void test_page_flips(MockServer &server, int flips) {
+  CHECK(server.start());
+  Device &device = *new_device(server, false, "{\"page_size\":10}");
+  NotionDatabase &database = device.database;
+  CHECK(poll(device));
+  CHECK(database.get_page_count() == 10);
+  CHECK(database.has_more());
+  uint32_t first_hash = database.get_pages_hash();
+  auto next = [&]() { return fetch(device, [&]() { database.next_page(); }); };
+  auto previous = [&]() { return fetch(device, [&]() { database.previous_page(); }); };
+  CHECK(next());
+  uint32_t second_hash = database.get_pages_hash();
+  CHECK(second_hash != first_hash);
+  // The symbols of the last page are added on its first fetch
+  CHECK(next());
+  CHECK(previous());
+
+  Measurement measurement(device, flips);
+  for (int i = 0; i + 4 <= flips; i += 4) {
+    CHECK(next());
+    CHECK(database.get_page_count() == RECORDED_PAGES - 20);
+    CHECK(!database.has_more());
+    CHECK(previous());
+    CHECK(database.get_pages_hash() == second_hash);
+    CHECK(previous());
+    CHECK(database.get_pages_hash() == first_hash);
+    CHECK(database.has_more());
+    CHECK(next());
+    CHECK(database.get_pages_hash() == second_hash);
+  }
+  CHECK(measurement.report("page_flips", server) <= 0);
+  CHECK(device.failures == 0);
+}
+
+// A body cut short fails the poll and leaves the pages shown; the next poll reconnects. The rest
+// of the body is waited for until the HTTP timeout, as on the device, so it is kept short here.
+void test_truncated(MockServer &server, bool chunked) {
+  std::vector<std::string> options = {"--truncate-every", "4"};
+  if (chunked) {
+    options.push_back("--chunked");
+  }
+  CHECK(server.start(options));
+  Device &device = *new_device(server, false, "", 500);
+  NotionDatabase &database = device.database;
+  CHECK(poll(device));
+  uint32_t pages_hash = database.get_pages_hash();
+
+  Measurement measurement(device, 20);
+  for (int i = 0; i < 20; i++) {
+    CHECK(poll(device));
+    CHECK(database.get_page_count() == RECORDED_PAGES);
+    CHECK(database.get_pages_hash() == pages_hash);
+    CHECK(database.get_consecutive_failures() <= 1);
+  }
+  measurement.report(chunked ? "truncated_chunked" : "truncated", server);
+  // Every fourth of the 21 requests was cut short, and closed its connection
+  CHECK(device.failures == 5);
+  CHECK(server.stats().connections == 6);
+}
+
+// After a 429 no request is sent until Retry-After has passed, then the retry fetches
+void test_rate_limited(MockServer &server) {
+  CHECK(server.start({"--rate-limit-every", "5", "--retry-after", "1"}));
+  Device &device = *new_device(server, false);
+  NotionDatabase &database = device.database;
+  CHECK(poll(device));
+
+  Measurement measurement(device, 12);
+  for (int i = 0; i < 12; i++) {
+    CHECK(poll(device));
+  }
+  measurement.report("rate_limited", server);
+  MockServer::Stats stats = server.stats();
+  CHECK(device.failures == stats.requests / 5);
+  CHECK(device.failures >= 2);
+  // The poll that found the retry pending waited for the retry to fetch
+  CHECK(percentile(device.latencies, 100) >= 1000000);
+  CHECK(database.get_page_count() == RECORDED_PAGES);
+}
+
+// The body is parsed as it arrives, so a slow body shows up in parse_us and not in a failure
+void test_slow_body(MockServer &server) {
+  CHECK(server.start({"--drip", "4096", "--drip-delay", "2"}));
+  Device &device = *new_device(server, true);
+  CHECK(poll(device));
+
+  Measurement measurement(device, 20);
+  for (int i = 0; i < 20; i++) {
+    CHECK(poll(device));
+  }
+  measurement.report("slow_body", server);
+  CHECK(device.failures == 0);
+  // 51150 bytes arrive 4096 at a time, 2ms apart; parsing them at once takes a few milliseconds
+  CHECK(percentile(device.parse_us, 50) >= 15000);
+  CHECK(device.database.get_page_count() == RECORDED_PAGES);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int polls = 1000;
+  if (argc == 6 && std::strcmp(argv[4], "--polls") == 0) {
+    polls = std::atoi(argv[5]);
+  } else if (argc != 4) {
+    std::fprintf(stderr, "Usage: %s <python> <mock_notion_server.py> <data.json> [--polls <count>]\n", argv[0]);
+    return 2;
+  }
+  MockServer server(argv[1], argv[2], argv[3]);
+  test_polls(server, false, polls);
+  test_polls(server, true, polls);
+  test_page_flips(server, polls);
+  test_truncated(server, false);
+  test_truncated(server, true);
+  test_rate_limited(server);
+  test_slow_body(server);
+  server.stop();
+  return check_result();
+}
@@ -0,0 +1,186 @@
+// Drives HttpSession against mock_notion_server.py: keep-alive reuse, the retry on a reused
+// connection the server dropped, reconnecting after the idle timeout on either side, chunked
+// responses and HTTPS.
+//
+//   test_http_session <python> <mock_notion_server.py> <data.json> [<certfile.pem>]
+
+#include <cstdio>
+#include <string>
+
+#include "http_session.h"
+#include "mock_server.h"
+#include "test_check.h"
+
+using esphome::notion_database::HttpSession;
+
+namespace {
+
+const char *const TOKEN = "secret_test";
+const char *const QUERY = "{\"page_size\":10}";
+
+// Sends the query and reads the whole response; returns the HTTP status code
+int query(HttpSession &session, const MockServer &server) {
+  int http_code = session.post(server.query_url(), TOKEN, QUERY);
+  if (http_code > 0) {
+    session.get_string();
+  }
+  session.end(http_code > 0);
+  return http_code;
+}
+
+void test_keep_alive(MockServer &server) {
+  CHECK(server.start());
+  HttpSession session;
+  session.set_keep_alive(true);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_connect_us() > 0);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_connect_us() == 0);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 2);
+  MockServer::Stats stats = server.stats();
+  CHECK(stats.connections == 1);
+  CHECK(stats.requests == 3);
+  session.close();
+}
+
+void test_without_keep_alive(MockServer &server) {
+  CHECK(server.start());
+  HttpSession session;
+  for (int i = 0; i < 3; i++) {
+    CHECK(query(session, server) == HTTP_CODE_OK);
+    CHECK(session.get_connect_us() > 0);
+  }
+  CHECK(session.get_reuse_count() == 0);
+  CHECK(server.stats().connections == 3);
+}
+
+// A response that was not read to the end leaves the connection unusable, so it is closed
+void test_unconsumed_body(MockServer &server) {
+  CHECK(server.start());
+  HttpSession session;
+  session.set_keep_alive(true);
+  CHECK(session.post(server.query_url(), TOKEN, QUERY) == HTTP_CODE_OK);
+  session.end(false);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 0);
+  CHECK(server.stats().connections == 2);
+  session.close();
+}
+
+void test_client_idle_timeout(MockServer &server) {
+  CHECK(server.start());
+  HttpSession session;
+  session.set_keep_alive(true);
+  session.set_idle_timeout(100);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 1);
+  delay(200);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 1);
+  CHECK(session.get_connect_us() > 0);
+  CHECK(server.stats().connections == 2);
+  session.close();
+}
+
+// The server closing an idle connection is noticed before the next request is sent
+void test_server_idle_timeout(MockServer &server) {
+  CHECK(server.start({"--idle-timeout", "0.1"}));
+  HttpSession session;
+  session.set_keep_alive(true);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  delay(300);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 0);
+  MockServer::Stats stats = server.stats();
+  CHECK(stats.connections == 2);
+  CHECK(stats.dropped == 0);
+  session.close();
+}
+
+// A request the server drops on a reused connection is sent once more on a new one
+void test_retry_on_dropped(MockServer &server) {
+  CHECK(server.start({"--drop-reused-every", "1"}));
+  HttpSession session;
+  session.set_keep_alive(true);
+  for (int i = 0; i < 3; i++) {
+    CHECK(query(session, server) == HTTP_CODE_OK);
+  }
+  CHECK(session.get_reuse_count() == 0);
+  MockServer::Stats stats = server.stats();
+  CHECK(stats.connections == 3);
+  CHECK(stats.requests == 3);
+  CHECK(stats.dropped == 2);
+  session.close();
+}
+
+// A failure on a new connection is not retried
+void test_refused(MockServer &server) {
+  CHECK(server.start());
+  HttpSession session;
+  session.set_keep_alive(true);
+  session.set_connect_timeout(500);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  server.stop();
+  CHECK(query(session, server) < 0);
+  CHECK(query(session, server) < 0);
+  CHECK(session.get_reuse_count() == 0);
+}
+
+void test_chunked(MockServer &server) {
+  CHECK(server.start({"--chunked", "--chunk-size", "100"}));
+  HttpSession session;
+  session.set_keep_alive(true);
+  CHECK(session.post(server.query_url(), TOKEN, QUERY) == HTTP_CODE_OK);
+  Stream &stream = session.get_stream();
+  // The decoded body starts like the JSON; what is left is drained by end()
+  char start[12] = {};
+  CHECK(stream.readBytes(start, sizeof(start) - 1) == sizeof(start) - 1);
+  CHECK(start[0] == '{');
+  CHECK(std::string(start).find("\r\n") == std::string::npos);
+  session.end(true);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_reuse_count() == 1);
+  CHECK(server.stats().connections == 1);
+  session.close();
+}
+
+void test_https(MockServer &server, const std::string &certfile) {
+  CHECK(server.start({"--certfile", certfile}));
+  CHECK(server.query_url().rfind("https://", 0) == 0);
+  HttpSession session;
+  session.set_keep_alive(true);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_connect_us() > 0);
+  CHECK(query(session, server) == HTTP_CODE_OK);
+  CHECK(session.get_connect_us() == 0);
+  CHECK(session.get_reuse_count() == 1);
+  CHECK(server.stats().connections == 1);
+  session.close();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    std::fprintf(stderr, "Usage: %s <python> <mock_notion_server.py> <data.json> [<certfile.pem>]\n", argv[0]);
+    return 2;
+  }
+  MockServer server(argv[1], argv[2], argv[3]);
+  test_keep_alive(server);
+  test_without_keep_alive(server);
+  test_unconsumed_body(server);
+  test_client_idle_timeout(server);
+  test_server_idle_timeout(server);
+  test_retry_on_dropped(server);
+  test_refused(server);
+  test_chunked(server);
+  if (argc > 4) {
+    test_https(server, argv[4]);
+  } else {
+    std::printf("No certificate given, HTTPS not tested\n");
+  }
+  server.stop();
+  return check_result();
+}
@@ -0,0 +1,498 @@
+// Round trips pages through the binary page set encoding and the snapshots built on it: every
+// cell type, the edges of the number and time encodings, and data that is cut short or corrupt.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "nvs.h"
+#include "page_codec.h"
+#include "snapshot.h"
+#include "test_check.h"
+
+using namespace esphome::notion_database;
+
+namespace {
+
+const NotionPropertyType TEXT_TYPES[] = {NotionPropertyType::TITLE, NotionPropertyType::RICH_TEXT,
+                                         NotionPropertyType::EMAIL, NotionPropertyType::PHONE_NUMBER,
+                                         NotionPropertyType::URL};
+const NotionPropertyType TIME_TYPES[] = {NotionPropertyType::DATE, NotionPropertyType::CREATED_TIME,
+                                         NotionPropertyType::LAST_EDITED_TIME};
+
+const double NUMBERS[] = {0.0,
+                          1.0,
+                          -1.0,
+                          63.0,
+                          64.0,
+                          -64.0,
+                          -65.0,
+                          1e6,
+                          (1 << 30) - 1.0,
+                          -((1 << 30) - 1.0),
+                          1 << 30,
+                          -(1 << 30),
+                          4294967296.0,
+                          -4294967296.0,
+                          0.5,
+                          -0.25,
+                          3.14159,
+                          1e-300,
+                          1e300,
+                          -0.0,
+                          std::numeric_limits<double>::infinity(),
+                          -std::numeric_limits<double>::infinity(),
+                          std::numeric_limits<double>::quiet_NaN(),
+                          std::numeric_limits<double>::denorm_min()};
+
+const int32_t EPOCHS[] = {0,         1700000000, 1700000060, 1600000000, INT32_MAX, INT32_MIN,
+                          INT32_MAX, -1,         0,          -86400,     1700000000};
+
+const char *const TEXTS[] = {"", "Buy milk", "Ünïcödé ✓", "a", "", "a longer piece of text with, punctuation."};
+
+// Builds a table with a column of every type the codec stores, one row per number edge case
+PageTable build_pages(const std::shared_ptr<SymbolTable> &symbols) {
+  PageTable pages(MemoryPlacement::INTERNAL);
+  pages.set_symbols(symbols);
+  uint16_t todo = symbols->intern("To do");
+  uint16_t done = symbols->intern("Done");
+  uint16_t home = symbols->intern("Home");
+  uint16_t work = symbols->intern("Work");
+
+  uint32_t key = 1000;
+  for (auto type : TEXT_TYPES) {
+    pages.get_or_add_column(key++, type);
+  }
+  int number = pages.get_or_add_column(key++, NotionPropertyType::NUMBER);
+  int checkbox = pages.get_or_add_column(key++, NotionPropertyType::CHECKBOX);
+  int first_time = pages.get_or_add_column(key++, TIME_TYPES[0]);
+  for (size_t i = 1; i < sizeof(TIME_TYPES) / sizeof(TIME_TYPES[0]); i++) {
+    pages.get_or_add_column(key++, TIME_TYPES[i]);
+  }
+  int select = pages.get_or_add_column(key++, NotionPropertyType::SELECT);
+  int status = pages.get_or_add_column(key++, NotionPropertyType::STATUS);
+  int multi_select = pages.get_or_add_column(key++, NotionPropertyType::MULTI_SELECT);
+
+  const size_t epoch_count = sizeof(EPOCHS) / sizeof(EPOCHS[0]);
+  const size_t text_count = sizeof(TEXTS) / sizeof(TEXTS[0]);
+  const size_t row_count = sizeof(NUMBERS) / sizeof(NUMBERS[0]);
+  for (size_t row = 0; row < row_count; row++) {
+    pages.add_row();
+    pages.set_row_key(0x9E3779B9u * (row + 1));
+    pages.set_row_hash(0xFFFFFFFFu - row);
+    for (size_t i = 0; i < sizeof(TEXT_TYPES) / sizeof(TEXT_TYPES[0]); i++) {
+      pages.set_text(i, TEXTS[(row + i) % text_count]);
+    }
+    pages.set_number(number, NUMBERS[row]);
+    pages.set_bool(checkbox, row % 3 == 0);
+    for (size_t i = 0; i < sizeof(TIME_TYPES) / sizeof(TIME_TYPES[0]); i++) {
+      pages.set_epoch(first_time + i, EPOCHS[(row + i) % epoch_count]);
+    }
+    pages.set_symbol(select, row % 2 == 0 ? todo : SymbolTable::EMPTY);
+    pages.set_symbol(status, row % 2 == 0 ? done : todo);
+    pages.begin_items(multi_select);
+    for (size_t item = 0; item < row % 4; item++) {
+      pages.add_item(item % 2 == 0 ? home : work);
+    }
+  }
+  return pages;
+}
+
+bool same_number(double a, double b) {
+  // Bit for bit, so that the sign of zero and NaN compare as written
+  return std::memcmp(&a, &b, sizeof(double)) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+// Compares two tables cell by cell, by value rather than by symbol ID
+void check_same_pages(const PageTable &expected, const PageTable &actual) {
+  CHECK(actual.size() == expected.size());
+  CHECK(actual.columns().size() == expected.columns().size());
+  if (actual.size() != expected.size() || actual.columns().size() != expected.columns().size()) {
+    return;
+  }
+  for (size_t i = 0; i < expected.columns().size(); i++) {
+    CHECK(actual.column(i).key == expected.column(i).key);
+    CHECK(actual.column(i).type == expected.column(i).type);
+  }
+  for (uint32_t row = 0; row < expected.size(); row++) {
+    CHECK(actual.row_key(row) == expected.row_key(row));
+    CHECK(actual.row_hash(row) == expected.row_hash(row));
+    for (uint16_t i = 0; i < expected.columns().size(); i++) {
+      const auto &a = expected.column(i);
+      const auto &b = actual.column(i);
+      switch (a.type) {
+        case NotionPropertyType::NUMBER:
+          CHECK(same_number(b.numbers[row], a.numbers[row]));
+          break;
+        case NotionPropertyType::CHECKBOX:
+          CHECK(b.flags[row] == a.flags[row]);
+          break;
+        case NotionPropertyType::DATE:
+        case NotionPropertyType::CREATED_TIME:
+        case NotionPropertyType::LAST_EDITED_TIME:
+          CHECK(b.slots[row] == a.slots[row]);
+          break;
+        case NotionPropertyType::SELECT:
+        case NotionPropertyType::STATUS:
+          CHECK(std::strcmp(actual.symbol_at(b.slots[row]), expected.symbol_at(a.slots[row])) == 0);
+          break;
+        case NotionPropertyType::MULTI_SELECT: {
+          uint32_t count = expected.item_count_at(a.slots[row]);
+          CHECK(actual.item_count_at(b.slots[row]) == count);
+          for (uint32_t item = 0; item < count && actual.item_count_at(b.slots[row]) == count; item++) {
+            CHECK(std::strcmp(actual.symbol_at(actual.item_at(b.slots[row], item)),
+                              expected.symbol_at(expected.item_at(a.slots[row], item))) == 0);
+          }
+          break;
+        }
+        default:
+          CHECK(std::strcmp(actual.string_at(b.slots[row]), expected.string_at(a.slots[row])) == 0);
+          break;
+      }
+      // NaN equals nothing, not even itself; JSON has no NaN, so responses never carry one
+      CHECK(PageTable::cell_equals(expected, i, row, actual, i, row) ||
+            (a.type == NotionPropertyType::NUMBER && std::isnan(a.numbers[row])));
+    }
+  }
+}
+
+std::vector<uint8_t> encode(const PageTable &pages) {
+  std::vector<uint8_t> data;
+  ByteWriter writer(data);
+  encode_page_set(pages, writer);
+  return data;
+}
+
+void test_zigzag() {
+  const int32_t values[] = {0, 1, -1, 2, -2, 63, -64, 64, INT16_MAX, INT16_MIN, INT32_MAX, INT32_MIN, INT32_MAX - 1,
+                            INT32_MIN + 1};
+  for (int32_t value : values) {
+    CHECK(zigzag_decode(zigzag_encode(value)) == value);
+  }
+  // Small magnitudes of either sign stay small
+  CHECK(zigzag_encode(0) == 0);
+  CHECK(zigzag_encode(-1) == 1);
+  CHECK(zigzag_encode(1) == 2);
+  CHECK(zigzag_encode(INT32_MAX) == 0xFFFFFFFEu);
+  CHECK(zigzag_encode(INT32_MIN) == 0xFFFFFFFFu);
+
+  // Varints of every length, including the largest
+  std::vector<uint8_t> data;
+  ByteWriter writer(data);
+  const uint32_t varints[] = {0, 127, 128, 16383, 16384, (1u << 21) - 1, 1u << 21, (1u << 28) - 1, 1u << 28,
+                              0xFFFFFFFFu};
+  for (uint32_t value : varints) {
+    writer.varint(value);
+  }
+  for (int32_t value : values) {
+    writer.zigzag(value);
+  }
+  CHECK(data.size() < 5 * (sizeof(varints) + sizeof(values)) / sizeof(uint32_t));
+  ByteReader reader(data.data(), data.size());
+  for (uint32_t value : varints) {
+    CHECK(reader.varint() == value);
+  }
+  for (int32_t value : values) {
+    CHECK(reader.zigzag() == value);
+  }
+  CHECK(reader.ok() && reader.at_end());
+}
+
+void test_numbers() {
+  for (double value : NUMBERS) {
+    auto symbols = std::make_shared<SymbolTable>();
+    PageTable pages(MemoryPlacement::INTERNAL);
+    pages.set_symbols(symbols);
+    pages.get_or_add_column(1, NotionPropertyType::NUMBER);
+    pages.add_row();
+    pages.set_number(0, value);
+    std::vector<uint8_t> data = encode(pages);
+
+    PageTable decoded(MemoryPlacement::INTERNAL);
+    ByteReader reader(data.data(), data.size());
+    CHECK(decode_page_set(reader, decoded, std::make_shared<SymbolTable>()));
+    CHECK(decoded.size() == 1);
+    if (decoded.size() == 1) {
+      CHECK(same_number(decoded.column(0).numbers[0], value));
+    }
+
+    // Whole numbers below 2^30 are a varint with a clear tag bit; anything else is the tag and eight bytes. The
+    // cell follows 16 bytes of symbols, schema, row count, key and hash.
+    bool whole = value == std::floor(value) && std::fabs(value) < (1 << 30) && !(value == 0 && std::signbit(value));
+    if (whole) {
+      CHECK(data.size() > 16 && data.size() <= 16 + 5 && (data[16] & 1) == 0);
+      CHECK(std::fabs(value) >= 32 || data.size() == 17);
+    } else {
+      CHECK(data.size() == 16 + 1 + 8 && data[16] == 1);
+    }
+  }
+}
+
+void test_round_trip() {
+  auto symbols = std::make_shared<SymbolTable>();
+  PageTable pages = build_pages(symbols);
+  std::vector<uint8_t> data = encode(pages);
+
+  PageTable decoded(MemoryPlacement::INTERNAL);
+  auto decoded_symbols = std::make_shared<SymbolTable>();
+  ByteReader reader(data.data(), data.size());
+  CHECK(decode_page_set(reader, decoded, decoded_symbols));
+  CHECK(reader.at_end());
+  // The rows use the symbols in the order they were interned, so they keep their IDs
+  CHECK(decoded_symbols->size() == symbols->size());
+  for (size_t id = 0; id < symbols->size(); id++) {
+    CHECK(std::strcmp(decoded_symbols->lookup(id), symbols->lookup(id)) == 0);
+  }
+  check_same_pages(pages, decoded);
+
+  // Encoding the decoded pages gives the same bytes
+  CHECK(encode(decoded) == data);
+
+  // Reading in place gives the same cells without building a table
+  PageSetReader set;
+  ByteReader in_place(data.data(), data.size());
+  CHECK(set.open(in_place));
+  CHECK(set.row_count() == pages.size());
+  size_t rows = 0;
+  PageSetCell cell;
+  while (set.next_row()) {
+    CHECK(set.row_key() == pages.row_key(rows));
+    size_t cells = 0;
+    while (set.next_cell(cell)) {
+      if (cell.type == NotionPropertyType::MULTI_SELECT) {
+        for (uint16_t item = 0; item < cell.item_count; item++) {
+          CHECK(set.next_item() != SymbolTable::EMPTY);
+        }
+      }
+      cells++;
+    }
+    CHECK(cells == pages.columns().size());
+    rows++;
+  }
+  CHECK(rows == pages.size());
+  CHECK(in_place.ok() && in_place.at_end());
+
+  // An empty table round trips too
+  PageTable empty(MemoryPlacement::INTERNAL);
+  std::vector<uint8_t> empty_data = encode(empty);
+  ByteReader empty_reader(empty_data.data(), empty_data.size());
+  CHECK(decode_page_set(empty_reader, decoded, std::make_shared<SymbolTable>()));
+  CHECK(decoded.empty() && decoded.columns().empty());
+}
+
+// Only the symbols the rows use are written, renumbered in the order the rows use them
+void test_unused_symbols() {
+  auto fresh = std::make_shared<SymbolTable>();
+  std::vector<uint8_t> expected = encode(build_pages(fresh));
+
+  // A table of a generation that has seen many other pages, with the used symbols out of order
+  auto shared = std::make_shared<SymbolTable>();
+  char name[16];
+  for (int i = 0; i < 200; i++) {
+    std::snprintf(name, sizeof(name), "Stale %d", i);
+    shared->intern(name);
+  }
+  shared->intern("Work");
+  shared->intern("Home");
+  PageTable pages = build_pages(shared);
+  shared->intern("Added later");
+  std::vector<uint8_t> data = encode(pages);
+  CHECK(data == expected);
+
+  PageTable decoded(MemoryPlacement::INTERNAL);
+  auto decoded_symbols = std::make_shared<SymbolTable>();
+  ByteReader reader(data.data(), data.size());
+  CHECK(decode_page_set(reader, decoded, decoded_symbols));
+  CHECK(decoded_symbols->size() == fresh->size());
+  check_same_pages(pages, decoded);
+
+  // A table without symbol cells writes no symbols at all
+  PageTable plain(MemoryPlacement::INTERNAL);
+  plain.set_symbols(shared);
+  plain.get_or_add_column(1, NotionPropertyType::TITLE);
+  plain.add_row();
+  plain.set_text(0, "Stale 1");
+  std::vector<uint8_t> plain_data = encode(plain);
+  CHECK(!plain_data.empty() && plain_data[0] == 0);
+}
+
+// Sorted times cost a byte or two per row, as deltas from the row before
+void test_time_deltas() {
+  PageTable pages(MemoryPlacement::INTERNAL);
+  pages.set_symbols(std::make_shared<SymbolTable>());
+  pages.get_or_add_column(1, NotionPropertyType::DATE);
+  const size_t rows = 100;
+  for (size_t row = 0; row < rows; row++) {
+    pages.add_row();
+    pages.set_epoch(0, 1700000000 + row * 60);
+  }
+  std::vector<uint8_t> data = encode(pages);
+  // The first time, then one two-byte delta per row, besides the key and hash
+  CHECK(data.size() <= 16 + 5 + rows * (8 + 2));
+
+  PageTable decoded(MemoryPlacement::INTERNAL);
+  ByteReader reader(data.data(), data.size());
+  CHECK(decode_page_set(reader, decoded, std::make_shared<SymbolTable>()));
+  check_same_pages(pages, decoded);
+}
+
+// Every prefix of an encoding is rejected, and so are malformed values
+void test_malformed() {
+  auto symbols = std::make_shared<SymbolTable>();
+  PageTable pages = build_pages(symbols);
+  std::vector<uint8_t> data = encode(pages);
+  for (size_t size = 0; size < data.size(); size++) {
+    PageTable decoded(MemoryPlacement::INTERNAL);
+    ByteReader reader(data.data(), size);
+    bool ok = decode_page_set(reader, decoded, std::make_shared<SymbolTable>());
+    CHECK(!ok);
+    CHECK(!ok || decoded.empty());
+    if (ok) {
+      std::printf("prefix of %zu of %zu bytes decoded\n", size, data.size());
+      break;
+    }
+  }
+
+  // A varint longer than five bytes
+  const uint8_t long_varint[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  ByteReader varint_reader(long_varint, sizeof(long_varint));
+  varint_reader.varint();
+  CHECK(!varint_reader.ok());
+
+  // A string with a NUL inside, or without one at its end
+  const uint8_t embedded_nul[] = {3, 'a', 0, 'b', 0};
+  ByteReader nul_reader(embedded_nul, sizeof(embedded_nul));
+  CHECK(std::strcmp(nul_reader.str(), "") == 0 && !nul_reader.ok());
+  const uint8_t missing_nul[] = {2, 'a', 'b', 'c'};
+  ByteReader missing_reader(missing_nul, sizeof(missing_nul));
+  CHECK(std::strcmp(missing_reader.str(), "") == 0 && !missing_reader.ok());
+
+  // Reads after a failure return nothing
+  CHECK(missing_reader.u32() == 0 && missing_reader.varint() == 0 && missing_reader.f64() == 0.0);
+
+  // A symbol ID beyond the symbol table, and a symbol listed twice
+  std::vector<uint8_t> bad;
+  ByteWriter writer(bad);
+  writer.varint(1);
+  writer.str("To do");
+  writer.varint(1);
+  writer.u32(1);
+  writer.u8(static_cast<uint8_t>(NotionPropertyType::SELECT));
+  writer.varint(1);
+  writer.u32(2);
+  writer.u32(3);
+  writer.varint(2);
+  PageTable decoded(MemoryPlacement::INTERNAL);
+  ByteReader bad_reader(bad.data(), bad.size());
+  CHECK(!decode_page_set(bad_reader, decoded, std::make_shared<SymbolTable>()));
+
+  std::vector<uint8_t> repeated;
+  ByteWriter repeated_writer(repeated);
+  repeated_writer.varint(2);
+  repeated_writer.str("To do");
+  repeated_writer.str("To do");
+  repeated_writer.varint(0);
+  repeated_writer.varint(0);
+  ByteReader repeated_reader(repeated.data(), repeated.size());
+  CHECK(!decode_page_set(repeated_reader, decoded, std::make_shared<SymbolTable>()));
+
+  // An unknown property type
+  std::vector<uint8_t> unknown;
+  ByteWriter unknown_writer(unknown);
+  unknown_writer.varint(0);
+  unknown_writer.varint(1);
+  unknown_writer.u32(1);
+  unknown_writer.u8(static_cast<uint8_t>(NotionPropertyType::UNKNOWN));
+  unknown_writer.varint(0);
+  ByteReader unknown_reader(unknown.data(), unknown.size());
+  CHECK(!decode_page_set(unknown_reader, decoded, std::make_shared<SymbolTable>()));
+}
+
+void test_snapshot() {
+  auto symbols = std::make_shared<SymbolTable>();
+  PageTable pages = build_pages(symbols);
+  SnapshotState state;
+  state.config_hash = 0xC0FFEE;
+  state.saved_at = 1700000000;
+  state.pages_hash = 0x12345678;
+  state.has_more = true;
+  state.next_cursor = "cursor-25";
+  state.watermark = "2024-01-01T00:00:00.000Z";
+  state.available_properties = {"Name", "Status", "Tags"};
+
+  std::vector<uint8_t> data;
+  CHECK(SnapshotCodec::encode(state, pages, data, 64 * 1024));
+  CHECK(!SnapshotCodec::encode(state, pages, data, 64));
+  CHECK(SnapshotCodec::encode(state, pages, data, 64 * 1024));
+
+  SnapshotState decoded_state;
+  PageTable decoded(MemoryPlacement::INTERNAL);
+  CHECK(SnapshotCodec::decode(data.data(), data.size(), decoded_state, decoded, std::make_shared<SymbolTable>()));
+  CHECK(decoded_state.config_hash == state.config_hash);
+  CHECK(decoded_state.saved_at == state.saved_at);
+  CHECK(decoded_state.pages_hash == state.pages_hash);
+  CHECK(decoded_state.has_more == state.has_more);
+  CHECK(decoded_state.next_cursor == state.next_cursor);
+  CHECK(decoded_state.watermark == state.watermark);
+  CHECK(decoded_state.available_properties == state.available_properties);
+  check_same_pages(pages, decoded);
+
+  // Any flipped bit or lost byte is caught by the header or the CRC
+  for (size_t i = 0; i < data.size(); i++) {
+    std::vector<uint8_t> corrupt = data;
+    corrupt[i] ^= 1 << (i % 8);
+    CHECK(!SnapshotCodec::decode(corrupt.data(), corrupt.size(), decoded_state, decoded,
+                                 std::make_shared<SymbolTable>()));
+  }
+  for (size_t size = 0; size < data.size(); size++) {
+    CHECK(!SnapshotCodec::decode(data.data(), size, decoded_state, decoded, std::make_shared<SymbolTable>()));
+  }
+}
+
+void test_snapshot_store() {
+  SnapshotStore store;
+  store.set_key(0xABCDEF01);
+  std::vector<uint8_t> data;
+  uint32_t checked_at = 0;
+  CHECK(!store.load(data));
+  CHECK(!store.load_checked_at(checked_at));
+
+  const std::vector<uint8_t> saved = {1, 2, 3, 4, 5};
+  CHECK(store.save(saved));
+  CHECK(store.load(data) && data == saved);
+
+  // The check time lives beside the snapshot, so refreshing it leaves the snapshot alone
+  size_t writes = get_host_nvs_writes();
+  CHECK(store.save_checked_at(1700000000));
+  CHECK(get_host_nvs_writes() == writes + 1);
+  CHECK(store.load_checked_at(checked_at) && checked_at == 1700000000);
+  CHECK(store.load(data) && data == saved);
+
+  // Another database keeps its own entries
+  SnapshotStore other;
+  other.set_key(0x10FEDCBA);
+  CHECK(!other.load(data));
+  CHECK(!other.load_checked_at(checked_at));
+
+  store.erase();
+  CHECK(!store.load(data));
+  CHECK(!store.load_checked_at(checked_at));
+}
+
+}  // namespace
+
+int main() {
+  test_zigzag();
+  test_numbers();
+  test_round_trip();
+  test_unused_symbols();
+  test_time_deltas();
+  test_malformed();
+  test_snapshot();
+  test_snapshot_store();
+  return check_result();
+}
@@ -0,0 +1,134 @@
+// Replays a recorded query response through ChunkedStream, the way HttpSession reads a
+// keep-alive response: in chunks of various sizes, dripping in slowly, and cut short.
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "chunked_stream.h"
+#include "test_check.h"
+
+namespace {
+
+// Serves bytes like a network connection; with drip set, only every other read finds a byte
+class ReplayStream : public Stream {
+ public:
+  ReplayStream(const std::string &data, bool drip) : data_(data), drip_(drip) { setTimeout(5); }
+
+  int available() override { return arrived_() ? static_cast<int>(data_.size() - pos_) : 0; }
+  int read() override {
+    if (!arrived_() || pos_ >= data_.size()) return -1;
+    waiting_ = drip_;
+    return static_cast<uint8_t>(data_[pos_++]);
+  }
+  int peek() override { return arrived_() && pos_ < data_.size() ? static_cast<uint8_t>(data_[pos_]) : -1; }
+  size_t write(uint8_t byte) override { return 0; }
+
+ protected:
+  bool arrived_() {
+    if (waiting_) {
+      waiting_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  std::string data_;
+  size_t pos_{0};
+  bool drip_;
+  bool waiting_{false};
+};
+
+std::string read_file(const char *path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Encodes a body in chunks of chunk_size bytes, with an extension and a trailer as servers may send
+std::string encode_chunked(const std::string &body, size_t chunk_size) {
+  std::string encoded;
+  char header[32];
+  for (size_t pos = 0; pos < body.size(); pos += chunk_size) {
+    std::string chunk = body.substr(pos, chunk_size);
+    std::snprintf(header, sizeof(header), pos == 0 ? "%zx;name=value\r\n" : "%zX\r\n", chunk.size());
+    encoded += header + chunk + "\r\n";
+  }
+  return encoded + "0\r\nX-Trailer: 1\r\n\r\n";
+}
+
+// Reads byte by byte with the stream timeout, as ArduinoJson does
+std::string read_all(ChunkedStream &stream) {
+  std::string body;
+  char c;
+  while (stream.readBytes(&c, 1) == 1) {
+    body += c;
+  }
+  return body;
+}
+
+void test_chunk_sizes(const std::string &body) {
+  for (size_t chunk_size : {size_t(1), size_t(7), size_t(512), body.size()}) {
+    for (bool drip : {false, true}) {
+      ReplayStream raw(encode_chunked(body, chunk_size), drip);
+      ChunkedStream stream(raw);
+      CHECK(drip || stream.peek() == body[0]);
+      CHECK(read_all(stream) == body);
+      CHECK(stream.is_done());
+      CHECK(stream.drain());
+      CHECK(raw.available() == 0);
+    }
+  }
+}
+
+// After the parser stops at the closing brace, the rest of the body is drained for the next request
+void test_drain_after_partial_read(const std::string &body) {
+  ReplayStream raw(encode_chunked(body, 512) + "HTTP/1.1 200 OK\r\n", false);
+  ChunkedStream stream(raw);
+  char c;
+  for (size_t i = 0; i < body.size() / 2; i++) {
+    CHECK(stream.readBytes(&c, 1) == 1 && c == body[i]);
+  }
+  CHECK(stream.drain());
+  CHECK(stream.is_done());
+  CHECK(stream.read() < 0);
+  // The connection is left at the start of the next response
+  CHECK(raw.peek() == 'H');
+}
+
+// A body cut short must not look complete, so the session closes the connection
+void test_truncated(const std::string &body) {
+  std::string encoded = encode_chunked(body, 512);
+  for (size_t cut : {size_t(3), encoded.size() / 2, encoded.size() - 30}) {
+    ReplayStream raw(encoded.substr(0, cut), false);
+    ChunkedStream stream(raw);
+    std::string read = read_all(stream);
+    CHECK(read.size() < body.size());
+    CHECK(body.compare(0, read.size(), read) == 0);
+    CHECK(!stream.is_done());
+    CHECK(!stream.drain());
+  }
+
+  // Cut in the trailers, after the whole payload
+  ReplayStream raw(encoded.substr(0, encoded.size() - 7), false);
+  ChunkedStream stream(raw);
+  CHECK(read_all(stream) == body);
+  CHECK(!stream.is_done());
+  CHECK(!stream.drain());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::string body = read_file(argc > 1 ? argv[1] : "data/tasks.json");
+  CHECK(!body.empty());
+  if (body.empty()) {
+    return 1;
+  }
+  test_chunk_sizes(body);
+  test_drain_after_partial_read(body);
+  test_truncated(body);
+  return check_result();
+}